@@ -31,6 +31,7 @@ static gboolean gst_cool_initialized = FALSE;
 static void gst_cool_init_config (void);
 static void gst_cool_load_configuration (void);
 static void gst_cool_load_debug_configuration (void);
+static void gst_cool_load_memory_configuration (void);
 
 static GKeyFile *config = NULL;
 GKeyFile *
@@ -158,6 +159,24 @@ gst_cool_load_configuration (void)
 done:
   g_strfreev (rank_items);
   g_strfreev (sections);
+
+  gst_cool_load_memory_configuration ();
+}
+
+static void
+gst_cool_load_memory_configuration (void)
+{
+  guint64 budget;
+  GError *err = NULL;
+
+  budget = g_key_file_get_uint64 (config, "memory", "budget", &err);
+  if (err) {
+    GST_DEBUG ("Unable to read memory budget: %s", err->message);
+    g_error_free (err);
+    return;
+  }
+
+  gst_cool_budget_set_ceiling (budget);
 }
 
 static void
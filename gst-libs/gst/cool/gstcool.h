@@ -25,6 +25,9 @@
 #include <gst/gst.h>
 #include <gst/cool/gstcoolutil.h>
 #include <gst/cool/gstcoolplaybin.h>
+#include <gst/cool/gstcoolbudget.h>
+#include <gst/cool/gstcoolstreammeta.h>
+#include <gst/cool/gstcoolsubtitle.h>
 
 G_BEGIN_DECLS
 
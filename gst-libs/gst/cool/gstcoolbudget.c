@@ -0,0 +1,322 @@
+/* GStreamer Plugins Cool
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *	Author : Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+/*
+ * The memory budget hands out one configured ceiling to the buffering
+ * elements (queue2, multiqueue, queue, appsrc) which register with it.
+ * Each registered element gets a share proportional to its weight, and the
+ * shares are recomputed whenever an element comes or goes, so that the sum
+ * of all byte limits never exceeds the ceiling.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcoolbudget.h"
+
+typedef struct _GstCoolBudgetClient GstCoolBudgetClient;
+
+struct _GstCoolBudgetClient
+{
+  GstElement *element;          /* only used as a key, not reffed */
+  GWeakRef ref;
+
+  guint weight;
+  GstCoolBudgetFunc func;
+  gpointer user_data;
+};
+
+typedef struct
+{
+  GstElement *element;
+  guint64 share;
+  GstCoolBudgetFunc func;
+  gpointer user_data;
+} GstCoolBudgetUpdate;
+
+static GMutex budget_lock;
+static GList *budget_clients = NULL;
+static guint64 budget_ceiling = 0;
+static guint budget_total_weight = 0;
+
+/* shares are applied outside of budget_lock, so concurrent rebalances are
+ * serialized here and an older one stops once a newer one was computed */
+static GRecMutex budget_apply_lock;
+static gint budget_generation = 0;
+
+static void budget_element_gone (gpointer data, GObject * where_the_object_was);
+
+static void
+budget_apply_bytes_property (GstElement * element, guint64 share,
+    gpointer user_data)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (element);
+  GParamSpec *pspec;
+
+  /* queue, queue2 and multiqueue use max-size-bytes, appsrc uses max-bytes */
+  if (!(pspec = g_object_class_find_property (klass, "max-size-bytes")))
+    pspec = g_object_class_find_property (klass, "max-bytes");
+
+  if (!pspec) {
+    GST_WARNING_OBJECT (element, "no byte limit to apply budget to");
+    return;
+  }
+
+  GST_DEBUG_OBJECT (element, "%s: %" G_GUINT64_FORMAT, pspec->name, share);
+
+  if (pspec->value_type == G_TYPE_UINT64)
+    g_object_set (element, pspec->name, share, NULL);
+  else
+    g_object_set (element, pspec->name, (guint) MIN (share, G_MAXUINT), NULL);
+}
+
+static GstCoolBudgetClient *
+budget_find_client (GstElement * element)
+{
+  GList *l;
+
+  for (l = budget_clients; l; l = g_list_next (l)) {
+    GstCoolBudgetClient *client = l->data;
+
+    if (client->element == element)
+      return client;
+  }
+
+  return NULL;
+}
+
+static void
+budget_free_client (GstCoolBudgetClient * client)
+{
+  g_weak_ref_clear (&client->ref);
+  g_slice_free (GstCoolBudgetClient, client);
+}
+
+static guint64
+budget_compute_share (GstCoolBudgetClient * client)
+{
+  if (budget_total_weight == 0)
+    return 0;
+
+  return budget_ceiling * client->weight / budget_total_weight;
+}
+
+/* must be called with budget_lock held, the lock is released on return so
+ * that the callbacks can freely take other locks */
+static void
+budget_rebalance_unlocked (void)
+{
+  GList *l, *updates = NULL;
+  gint generation;
+
+  generation = g_atomic_int_add (&budget_generation, 1) + 1;
+
+  if (budget_ceiling == 0) {
+    g_mutex_unlock (&budget_lock);
+    return;
+  }
+
+  for (l = budget_clients; l; l = g_list_next (l)) {
+    GstCoolBudgetClient *client = l->data;
+    GstCoolBudgetUpdate *update;
+    GstElement *element = g_weak_ref_get (&client->ref);
+
+    if (!element)
+      continue;
+
+    update = g_slice_new (GstCoolBudgetUpdate);
+    update->element = element;
+    update->share = budget_compute_share (client);
+    update->func = client->func;
+    update->user_data = client->user_data;
+    updates = g_list_prepend (updates, update);
+  }
+
+  g_mutex_unlock (&budget_lock);
+
+  g_rec_mutex_lock (&budget_apply_lock);
+  for (l = updates; l; l = g_list_next (l)) {
+    GstCoolBudgetUpdate *update = l->data;
+
+    /* a newer rebalance, possibly from a callback, applies its own shares */
+    if (g_atomic_int_get (&budget_generation) == generation)
+      update->func (update->element, update->share, update->user_data);
+    gst_object_unref (update->element);
+    g_slice_free (GstCoolBudgetUpdate, update);
+  }
+  g_list_free (updates);
+  g_rec_mutex_unlock (&budget_apply_lock);
+}
+
+static void
+budget_remove_client_unlocked (GstCoolBudgetClient * client)
+{
+  budget_clients = g_list_remove (budget_clients, client);
+  budget_total_weight -= client->weight;
+  budget_free_client (client);
+}
+
+static void
+budget_element_gone (gpointer data, GObject * where_the_object_was)
+{
+  GstCoolBudgetClient *client;
+
+  g_mutex_lock (&budget_lock);
+  client = budget_find_client ((GstElement *) where_the_object_was);
+  if (!client) {
+    g_mutex_unlock (&budget_lock);
+    return;
+  }
+
+  GST_DEBUG ("budget client %p is gone", where_the_object_was);
+  budget_remove_client_unlocked (client);
+  budget_rebalance_unlocked ();
+}
+
+/**
+ * gst_cool_budget_set_ceiling:
+ * @ceiling: total number of bytes for all registered elements, 0 to disable
+ *
+ * Set the memory ceiling and apportion it to the registered elements.
+ * When the ceiling is 0 the registered elements keep their own limits.
+ */
+void
+gst_cool_budget_set_ceiling (guint64 ceiling)
+{
+  GST_DEBUG ("memory budget ceiling: %" G_GUINT64_FORMAT, ceiling);
+
+  g_mutex_lock (&budget_lock);
+  budget_ceiling = ceiling;
+  budget_rebalance_unlocked ();
+}
+
+/**
+ * gst_cool_budget_get_ceiling:
+ *
+ * Returns: the memory ceiling, 0 when the budget is disabled.
+ */
+guint64
+gst_cool_budget_get_ceiling (void)
+{
+  guint64 ceiling;
+
+  g_mutex_lock (&budget_lock);
+  ceiling = budget_ceiling;
+  g_mutex_unlock (&budget_lock);
+
+  return ceiling;
+}
+
+/**
+ * gst_cool_budget_register:
+ * @element: a buffering element
+ * @weight: relative weight of @element
+ * @func: (allow-none): function applying a new share to @element
+ * @user_data: user data passed to @func
+ *
+ * Register @element with the memory budget, or update its weight when it
+ * is already registered. When @func is NULL the share is set to the
+ * max-size-bytes or max-bytes property of @element. @element is
+ * unregistered automatically when it is destroyed.
+ */
+void
+gst_cool_budget_register (GstElement * element, guint weight,
+    GstCoolBudgetFunc func, gpointer user_data)
+{
+  GstCoolBudgetClient *client;
+
+  g_return_if_fail (GST_IS_ELEMENT (element));
+  g_return_if_fail (weight > 0);
+
+  g_mutex_lock (&budget_lock);
+
+  if ((client = budget_find_client (element))) {
+    budget_total_weight -= client->weight;
+  } else {
+    client = g_slice_new0 (GstCoolBudgetClient);
+    client->element = element;
+    g_weak_ref_init (&client->ref, element);
+    g_object_weak_ref (G_OBJECT (element), budget_element_gone, NULL);
+    budget_clients = g_list_append (budget_clients, client);
+  }
+
+  client->weight = weight;
+  client->func = func ? func : budget_apply_bytes_property;
+  client->user_data = user_data;
+  budget_total_weight += weight;
+
+  GST_DEBUG_OBJECT (element, "registered with weight %u (total %u)", weight,
+      budget_total_weight);
+
+  budget_rebalance_unlocked ();
+}
+
+/**
+ * gst_cool_budget_unregister:
+ * @element: a registered element
+ *
+ * Remove @element from the memory budget and apportion its share to the
+ * other registered elements. The current byte limit of @element is left
+ * as it is.
+ */
+void
+gst_cool_budget_unregister (GstElement * element)
+{
+  GstCoolBudgetClient *client;
+
+  g_return_if_fail (GST_IS_ELEMENT (element));
+
+  g_mutex_lock (&budget_lock);
+  client = budget_find_client (element);
+  if (!client) {
+    g_mutex_unlock (&budget_lock);
+    return;
+  }
+
+  g_object_weak_unref (G_OBJECT (element), budget_element_gone, NULL);
+  budget_remove_client_unlocked (client);
+
+  GST_DEBUG_OBJECT (element, "unregistered (total %u)", budget_total_weight);
+
+  budget_rebalance_unlocked ();
+}
+
+/**
+ * gst_cool_budget_get_share:
+ * @element: a registered element
+ *
+ * Returns: the number of bytes currently apportioned to @element, or 0 when
+ * @element is not registered or the budget is disabled.
+ */
+guint64
+gst_cool_budget_get_share (GstElement * element)
+{
+  GstCoolBudgetClient *client;
+  guint64 share = 0;
+
+  g_mutex_lock (&budget_lock);
+  if ((client = budget_find_client (element)))
+    share = budget_compute_share (client);
+  g_mutex_unlock (&budget_lock);
+
+  return share;
+}
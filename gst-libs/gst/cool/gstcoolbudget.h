@@ -0,0 +1,57 @@
+/* GStreamer Plugins Cool
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *	Author : Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_COOL_BUDGET_H__
+#define __GST_COOL_BUDGET_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* relative weights used by the elements in this package */
+#define GST_COOL_BUDGET_WEIGHT_BUFFERING        16
+#define GST_COOL_BUDGET_WEIGHT_STREAM           4
+#define GST_COOL_BUDGET_WEIGHT_TEXT             1
+
+/**
+ * GstCoolBudgetFunc:
+ * @element: the registered element
+ * @share: number of bytes @element may hold
+ * @user_data: user data given at registration
+ *
+ * Called whenever the share of @element changes.
+ */
+typedef void (*GstCoolBudgetFunc) (GstElement * element, guint64 share,
+    gpointer user_data);
+
+void            gst_cool_budget_set_ceiling     (guint64 ceiling);
+guint64         gst_cool_budget_get_ceiling     (void);
+
+void            gst_cool_budget_register        (GstElement * element,
+                                                 guint weight,
+                                                 GstCoolBudgetFunc func,
+                                                 gpointer user_data);
+void            gst_cool_budget_unregister      (GstElement * element);
+
+guint64         gst_cool_budget_get_share       (GstElement * element);
+
+G_END_DECLS
+
+#endif
@@ -129,6 +129,9 @@ q2_set_property_by_configuration (GstElement * q2)
       "max-size-bytes", max_size_bytes, "max-size-time", max_size_time,
       "ring-buffer-max-size", ring_buffer_max_size,
       "use-rate-estimate", use_rate_estimate, NULL);
+
+  /* max-size-bytes is taken over by the memory budget when it is enabled */
+  gst_cool_budget_register (q2, GST_COOL_BUDGET_WEIGHT_BUFFERING, NULL, NULL);
 }
 
 static void
@@ -353,44 +356,207 @@ gst_cool_playbin_set_q2_conf (GstElement * playbin, const gchar * firstfield,
   va_end (vaargs);
 }
 
-static gboolean
-dot_graph_timeout_cb (GstElement * playbin)
+/* appends @structure to the array @list, takes @structure */
+static void
+append_structure (GValue * list, GstStructure * structure)
 {
+  GValue value = { 0, };
+
+  g_value_init (&value, GST_TYPE_STRUCTURE);
+  g_value_take_boxed (&value, structure);
+  gst_value_array_append_value (list, &value);
+  g_value_unset (&value);
+}
+
+/* Element and pad names keep counting up on a long running pipeline, so
+ * they are carried in string fields. As field names, each of them would
+ * become a GQuark which is never freed. */
+static void
+snapshot_element (const GValue * item, GValue * elements)
+{
+  GstElement *element = g_value_get_object (item);
+  GObjectClass *klass = G_OBJECT_GET_CLASS (element);
+  GstStructure *record;
+  GValue pads = { 0, };
+  gchar *path;
+  GList *l;
+
+  /* names are only unique within a bin, nested bins have their own queue0 */
+  path = gst_object_get_path_string (GST_OBJECT_CAST (element));
+  record = gst_structure_new ("element", "path", G_TYPE_STRING, path, NULL);
+  g_free (path);
+
+  g_value_init (&pads, GST_TYPE_ARRAY);
+
+  GST_OBJECT_LOCK (element);
+  gst_structure_set (record, "state", G_TYPE_INT, GST_STATE (element),
+      "pending", G_TYPE_INT, GST_STATE_PENDING (element), NULL);
+
+  /* only the negotiated caps are referenced here, serializing them is left
+   * to whoever consumes the record */
+  for (l = element->pads; l; l = g_list_next (l)) {
+    GstPad *pad = GST_PAD_CAST (l->data);
+    GstCaps *caps = gst_pad_get_current_caps (pad);
+
+    if (caps) {
+      append_structure (&pads, gst_structure_new ("pad", "name",
+              G_TYPE_STRING, GST_PAD_NAME (pad), "caps", GST_TYPE_CAPS, caps,
+              NULL));
+      gst_caps_unref (caps);
+    }
+  }
+  GST_OBJECT_UNLOCK (element);
+
+  gst_structure_take_value (record, "pads", &pads);
+
+  /* queue and queue2 expose their fill level */
+  if (g_object_class_find_property (klass, "current-level-bytes")) {
+    guint level_bytes = 0;
+    guint64 level_time = 0;
+
+    g_object_get (element, "current-level-bytes", &level_bytes,
+        "current-level-time", &level_time, NULL);
+    gst_structure_set (record, "level-bytes", G_TYPE_UINT, level_bytes,
+        "level-time", G_TYPE_UINT64, level_time, NULL);
+  }
+
+  if (g_object_class_find_property (klass, "decoder-state")) {
+    gint decoder_state = -1;
+
+    g_object_get (element, "decoder-state", &decoder_state, NULL);
+    gst_structure_set (record, "decoder-state", G_TYPE_INT, decoder_state,
+        NULL);
+  }
+
+  append_structure (elements, record);
+}
+
+/**
+ * gst_cool_playbin_snapshot:
+ * @playbin: a playbin
+ *
+ * Collect a compact health record of @playbin: the state of every element,
+ * the fill level of queues, the current caps of each pad and the decoder
+ * state of decproxy elements. The "elements" array holds an "element"
+ * structure per element, with the "path" string of the element, e.g.
+ * "/playbin0/uridecodebin0/queue2-0", and its "pads" array of "pad"
+ * structures with a "name" and "caps". Nothing is serialized, so this is
+ * cheap enough to be taken periodically on a running pipeline.
+ *
+ * Returns: (transfer full): a "cool-snapshot" #GstStructure
+ */
+GstStructure *
+gst_cool_playbin_snapshot (GstElement * playbin)
+{
+  GstStructure *snapshot;
+  GstIterator *it;
+  GstIteratorResult ires = GST_ITERATOR_RESYNC;
+  GValue elements = { 0, };
+  gint64 timestamp = 0;
+
+  g_return_val_if_fail (playbin != NULL, NULL);
+
+  g_value_init (&elements, GST_TYPE_ARRAY);
+
+  it = gst_bin_iterate_recurse (GST_BIN_CAST (playbin));
+  while (ires == GST_ITERATOR_RESYNC) {
+    timestamp = g_get_monotonic_time ();
+    ires = gst_iterator_foreach (it,
+        (GstIteratorForeachFunction) snapshot_element, &elements);
+    if (ires == GST_ITERATOR_RESYNC) {
+      gst_iterator_resync (it);
+      g_value_unset (&elements);
+      g_value_init (&elements, GST_TYPE_ARRAY);
+    }
+  }
+  gst_iterator_free (it);
+
+  snapshot = gst_structure_new ("cool-snapshot",
+      "timestamp", G_TYPE_INT64, timestamp, NULL);
+  gst_structure_take_value (snapshot, "elements", &elements);
+
+  return snapshot;
+}
+
+/**
+ * gst_cool_playbin_dump_dot:
+ * @playbin: a playbin
+ * @name: file name prefix of the dot file
+ *
+ * Write a dot graph of @playbin to GST_DEBUG_DUMP_DOT_DIR on demand.
+ */
+void
+gst_cool_playbin_dump_dot (GstElement * playbin, const gchar * name)
+{
+  g_return_if_fail (playbin != NULL);
+
   GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS (GST_BIN (playbin),
-      GST_DEBUG_GRAPH_SHOW_ALL, "timeout_dot_graph");
-  g_message ("timout dot-graph created");
+      GST_DEBUG_GRAPH_SHOW_ALL, name ? name : "cool_dot_graph");
+}
+
+/* the timeout only holds a weak reference, it's cleared before playbin is
+ * disposed, so a snapshot is never taken of a playbin going away */
+static gboolean
+snapshot_timeout_cb (GWeakRef * ref)
+{
+  GstElement *playbin;
+  GstStructure *snapshot;
+
+  if (!(playbin = g_weak_ref_get (ref)))
+    return FALSE;
+
+  snapshot = gst_cool_playbin_snapshot (playbin);
+  gst_element_post_message (playbin,
+      gst_message_new_application (GST_OBJECT_CAST (playbin), snapshot));
+  gst_object_unref (playbin);
+
   return TRUE;
 }
 
+static void
+free_snapshot_ref (GWeakRef * ref)
+{
+  g_weak_ref_clear (ref);
+  g_slice_free (GWeakRef, ref);
+}
+
+static void
+remove_snapshot_source (GSource * source)
+{
+  g_source_destroy (source);
+  g_source_unref (source);
+}
+
 static void
 gst_cool_playbin_load_configuration (GstElement * playbin)
 {
   GError *err = NULL;
   GKeyFile *config = gst_cool_get_configuration ();
-  gint dot_graph_timeout = 0;
-  const gchar *debug_mode;
+  gint snapshot_interval = 0;
+  GWeakRef *ref;
+  GSource *source;
 
-  debug_mode = g_key_file_get_string (config, "debug", "DEBUG_MODE", &err);
+  /* snapshots are cheap, so they don't depend on debug mode */
+  snapshot_interval =
+      g_key_file_get_integer (config, "monitor", "snapshot-interval", &err);
   if (err) {
-    GST_WARNING ("Unable to read debug mode: %s", err->message);
+    GST_DEBUG ("Unable to read snapshot-interval: %s", err->message);
     g_error_free (err);
     err = NULL;
   }
 
-  /* if debug mode is not enable, do not set debug option */
-  if (g_strcmp0 (debug_mode, "enable") != 0)
+  if (snapshot_interval <= 0)
     return;
 
-  dot_graph_timeout =
-      g_key_file_get_integer (config, "debug", "DOT_GRAPH_TIMEOUT", &err);
-  if (err) {
-    GST_WARNING ("Unable to read debug mode: %s", err->message);
-    g_error_free (err);
-    err = NULL;
-  }
+  GST_DEBUG ("posting snapshot every %d ms", snapshot_interval);
 
-  if (dot_graph_timeout) {
-    g_timeout_add (dot_graph_timeout, (GSourceFunc) dot_graph_timeout_cb,
-        playbin);
-  }
+  ref = g_slice_new0 (GWeakRef);
+  g_weak_ref_init (ref, playbin);
+
+  source = g_timeout_source_new (snapshot_interval);
+  g_source_set_callback (source, (GSourceFunc) snapshot_timeout_cb, ref,
+      (GDestroyNotify) free_snapshot_ref);
+  g_source_attach (source, NULL);
+  g_object_set_data_full (G_OBJECT (playbin), "cool-snapshot-source",
+      source, (GDestroyNotify) remove_snapshot_source);
 }
@@ -34,6 +34,11 @@ GstElement *    gst_cool_playbin_get_q2         (GstElement * playbin);
 void            gst_cool_playbin_set_q2_conf    (GstElement * playbin,
                                                  const gchar * firstfield, ...);
 
+GstStructure *  gst_cool_playbin_snapshot       (GstElement * playbin);
+
+void            gst_cool_playbin_dump_dot       (GstElement * playbin,
+                                                 const gchar * name);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,197 @@
+/* GStreamer Plugins Cool
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *	Author : Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * The stream meta carries the stream-id on each buffer. A pad tagged with
+ * gst_cool_stream_meta_tag_pad(), e.g. a sink pad of funnel, adds it to
+ * every buffer going through, and streamiddemux in interleaved mode
+ * routes by it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcoolstreammeta.h"
+
+GType
+gst_cool_stream_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstCoolStreamMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+static gboolean
+gst_cool_stream_meta_init (GstMeta * meta, gpointer params, GstBuffer * buffer)
+{
+  GstCoolStreamMeta *smeta = (GstCoolStreamMeta *) meta;
+
+  smeta->stream_id = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_cool_stream_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstCoolStreamMeta *smeta = (GstCoolStreamMeta *) meta;
+  GstCoolStreamMeta *dmeta;
+
+  /* copies and regions of a buffer stay in its stream */
+  dmeta = (GstCoolStreamMeta *) gst_buffer_add_meta (dest,
+      GST_COOL_STREAM_META_INFO, NULL);
+  if (!dmeta)
+    return FALSE;
+
+  dmeta->stream_id = smeta->stream_id;
+
+  return TRUE;
+}
+
+const GstMetaInfo *
+gst_cool_stream_meta_get_info (void)
+{
+  static const GstMetaInfo *meta_info = NULL;
+
+  if (g_once_init_enter (&meta_info)) {
+    const GstMetaInfo *mi = gst_meta_register (GST_COOL_STREAM_META_API_TYPE,
+        "GstCoolStreamMeta", sizeof (GstCoolStreamMeta),
+        gst_cool_stream_meta_init, NULL, gst_cool_stream_meta_transform);
+    g_once_init_leave (&meta_info, mi);
+  }
+  return meta_info;
+}
+
+/**
+ * gst_buffer_add_cool_stream_meta:
+ * @buffer: a writable #GstBuffer
+ * @stream_id: stream-id of the stream @buffer belongs to
+ *
+ * Tags @buffer with @stream_id.
+ *
+ * Returns: the added #GstCoolStreamMeta
+ */
+GstCoolStreamMeta *
+gst_buffer_add_cool_stream_meta (GstBuffer * buffer, const gchar * stream_id)
+{
+  GstCoolStreamMeta *meta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (stream_id != NULL, NULL);
+
+  meta = (GstCoolStreamMeta *) gst_buffer_add_meta (buffer,
+      GST_COOL_STREAM_META_INFO, NULL);
+  meta->stream_id = g_quark_from_string (stream_id);
+
+  return meta;
+}
+
+static GstBuffer *
+tag_buffer (GstBuffer * buffer, GQuark stream_id)
+{
+  GstCoolStreamMeta *meta = gst_buffer_get_cool_stream_meta (buffer);
+
+  if (meta && meta->stream_id == stream_id)
+    return buffer;
+
+  buffer = gst_buffer_make_writable (buffer);
+  if (!(meta = gst_buffer_get_cool_stream_meta (buffer)))
+    meta = (GstCoolStreamMeta *) gst_buffer_add_meta (buffer,
+        GST_COOL_STREAM_META_INFO, NULL);
+  meta->stream_id = stream_id;
+
+  return buffer;
+}
+
+static gboolean
+tag_list_item (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  *buffer = tag_buffer (*buffer, GPOINTER_TO_UINT (user_data));
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+tag_probe_cb (GstPad * pad, GstPadProbeInfo * info, GQuark * stream_id)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+    const gchar *id = NULL;
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_STREAM_START) {
+      gst_event_parse_stream_start (event, &id);
+      *stream_id = id ? g_quark_from_string (id) : 0;
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  /* nothing to tag before the first stream-start */
+  if (!*stream_id)
+    return GST_PAD_PROBE_OK;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+
+    list = gst_buffer_list_make_writable (list);
+    gst_buffer_list_foreach (list, tag_list_item,
+        GUINT_TO_POINTER (*stream_id));
+    GST_PAD_PROBE_INFO_DATA (info) = list;
+  } else {
+    GST_PAD_PROBE_INFO_DATA (info) =
+        tag_buffer (GST_PAD_PROBE_INFO_BUFFER (info), *stream_id);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * gst_cool_stream_meta_tag_pad:
+ * @pad: a #GstPad
+ *
+ * Tags every buffer going through @pad with the stream-id of the last
+ * stream-start event seen on @pad.
+ *
+ * Returns: the id of the probe doing it, for gst_pad_remove_probe()
+ */
+gulong
+gst_cool_stream_meta_tag_pad (GstPad * pad)
+{
+  GQuark *stream_id;
+  gchar *id;
+
+  g_return_val_if_fail (GST_IS_PAD (pad), 0);
+
+  stream_id = g_new0 (GQuark, 1);
+  if ((id = gst_pad_get_stream_id (pad))) {
+    *stream_id = g_quark_from_string (id);
+    g_free (id);
+  }
+
+  return gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) tag_probe_cb, stream_id, g_free);
+}
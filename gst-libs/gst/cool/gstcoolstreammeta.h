@@ -0,0 +1,61 @@
+/* GStreamer Plugins Cool
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *	Author : Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_COOL_STREAM_META_H__
+#define __GST_COOL_STREAM_META_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_COOL_STREAM_META_API_TYPE (gst_cool_stream_meta_api_get_type())
+#define GST_COOL_STREAM_META_INFO  (gst_cool_stream_meta_get_info())
+
+typedef struct _GstCoolStreamMeta GstCoolStreamMeta;
+
+/**
+ * GstCoolStreamMeta:
+ * @meta: parent #GstMeta
+ * @stream_id: interned stream-id of the stream the buffer belongs to
+ *
+ * Tags a buffer with its stream, so that streams interleaved on one pad
+ * can be told apart without a stream-start event per switch.
+ */
+struct _GstCoolStreamMeta
+{
+  GstMeta meta;
+
+  GQuark stream_id;
+};
+
+GType                   gst_cool_stream_meta_api_get_type (void);
+const GstMetaInfo *     gst_cool_stream_meta_get_info     (void);
+
+#define gst_buffer_get_cool_stream_meta(b) \
+  ((GstCoolStreamMeta *) gst_buffer_get_meta ((b), GST_COOL_STREAM_META_API_TYPE))
+
+GstCoolStreamMeta *     gst_buffer_add_cool_stream_meta   (GstBuffer * buffer,
+                                                           const gchar * stream_id);
+
+gulong                  gst_cool_stream_meta_tag_pad      (GstPad * pad);
+
+G_END_DECLS
+
+#endif
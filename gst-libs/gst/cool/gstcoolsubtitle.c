@@ -0,0 +1,201 @@
+/* GStreamer Plugins Cool
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *	Author : Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Subtitle samples are handed to the application by a function set on the
+ * pipeline, or on any bin holding the subtitle sink, instead of a bus
+ * message per sample. The sink looks the function up once when it starts.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcoolsubtitle.h"
+
+typedef struct
+{
+  gpointer func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} GstCoolSubtitleHandler;
+
+static GQuark
+subtitle_handler_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstCoolSubtitleHandler");
+
+  return quark;
+}
+
+static GQuark
+subtitle_batch_handler_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstCoolSubtitleBatchHandler");
+
+  return quark;
+}
+
+static void
+subtitle_handler_free (GstCoolSubtitleHandler * handler)
+{
+  if (handler->notify)
+    handler->notify (handler->user_data);
+
+  g_slice_free (GstCoolSubtitleHandler, handler);
+}
+
+/* keeps @func on @element, NULL removes the one set before */
+static void
+subtitle_set_handler (GstElement * element, GQuark quark, gpointer func,
+    gpointer user_data, GDestroyNotify notify)
+{
+  GstCoolSubtitleHandler *handler = NULL;
+
+  if (func) {
+    handler = g_slice_new (GstCoolSubtitleHandler);
+    handler->func = func;
+    handler->user_data = user_data;
+    handler->notify = notify;
+  }
+
+  g_object_set_qdata_full (G_OBJECT (element), quark, handler,
+      (GDestroyNotify) subtitle_handler_free);
+}
+
+/* the handler set on @element or the closest of its parents */
+static gboolean
+subtitle_get_handler (GstElement * element, GQuark quark, gpointer * func,
+    gpointer * user_data)
+{
+  GstObject *object, *parent;
+  GstCoolSubtitleHandler *handler = NULL;
+
+  object = gst_object_ref (element);
+  while (object) {
+    handler = g_object_get_qdata (G_OBJECT (object), quark);
+    if (handler)
+      break;
+
+    parent = gst_object_get_parent (object);
+    gst_object_unref (object);
+    object = parent;
+  }
+
+  if (object)
+    gst_object_unref (object);
+
+  if (!handler)
+    return FALSE;
+
+  *func = handler->func;
+  *user_data = handler->user_data;
+
+  return TRUE;
+}
+
+/**
+ * gst_cool_subtitle_set_func:
+ * @element: a pipeline, or any element containing the subtitle sink
+ * @func: (allow-none): function receiving the samples
+ * @user_data: user data passed to @func
+ * @notify: (allow-none): called on @user_data when it's no longer needed
+ *
+ * Delivers the subtitle samples of every subtitle sink inside of @element
+ * to @func. It has to be set before @element goes to PAUSED, the sinks
+ * post a "subtitle_data" application message per sample otherwise.
+ */
+void
+gst_cool_subtitle_set_func (GstElement * element, GstCoolSubtitleFunc func,
+    gpointer user_data, GDestroyNotify notify)
+{
+  g_return_if_fail (GST_IS_ELEMENT (element));
+
+  subtitle_set_handler (element, subtitle_handler_quark (), (gpointer) func,
+      user_data, notify);
+}
+
+/**
+ * gst_cool_subtitle_get_func:
+ * @element: a subtitle sink
+ * @func: (out): the function set on @element or the closest of its parents
+ * @user_data: (out): user data of @func
+ *
+ * Returns: %TRUE if a function was set on @element or any of its parents
+ */
+gboolean
+gst_cool_subtitle_get_func (GstElement * element, GstCoolSubtitleFunc * func,
+    gpointer * user_data)
+{
+  g_return_val_if_fail (GST_IS_ELEMENT (element), FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  return subtitle_get_handler (element, subtitle_handler_quark (),
+      (gpointer *) func, user_data);
+}
+
+/**
+ * gst_cool_subtitle_set_batch_func:
+ * @element: a pipeline, or any element containing the subtitle sink
+ * @func: (allow-none): function receiving the batches of samples
+ * @user_data: user data passed to @func
+ * @notify: (allow-none): called on @user_data when it's no longer needed
+ *
+ * Delivers the batches of the subtitle sinks inside of @element which have
+ * a batch window to @func. Without it, the samples of a batch are given to
+ * the #GstCoolSubtitleFunc one by one, or posted in one "subtitle_batch"
+ * application message. It has to be set before @element goes to PAUSED.
+ */
+void
+gst_cool_subtitle_set_batch_func (GstElement * element,
+    GstCoolSubtitleBatchFunc func, gpointer user_data, GDestroyNotify notify)
+{
+  g_return_if_fail (GST_IS_ELEMENT (element));
+
+  subtitle_set_handler (element, subtitle_batch_handler_quark (),
+      (gpointer) func, user_data, notify);
+}
+
+/**
+ * gst_cool_subtitle_get_batch_func:
+ * @element: a subtitle sink
+ * @func: (out): the function set on @element or the closest of its parents
+ * @user_data: (out): user data of @func
+ *
+ * Returns: %TRUE if a function was set on @element or any of its parents
+ */
+gboolean
+gst_cool_subtitle_get_batch_func (GstElement * element,
+    GstCoolSubtitleBatchFunc * func, gpointer * user_data)
+{
+  g_return_val_if_fail (GST_IS_ELEMENT (element), FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+  g_return_val_if_fail (user_data != NULL, FALSE);
+
+  return subtitle_get_handler (element, subtitle_batch_handler_quark (),
+      (gpointer *) func, user_data);
+}
@@ -0,0 +1,73 @@
+/* GStreamer Plugins Cool
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *	Author : Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_COOL_SUBTITLE_H__
+#define __GST_COOL_SUBTITLE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstCoolSubtitleFunc:
+ * @sink: the element delivering the sample
+ * @pad: the sink pad of @sink the sample came in on, one per text stream
+ * @sample: the subtitle sample, owned by the caller
+ * @user_data: user data given to gst_cool_subtitle_set_func()
+ *
+ * Called from the streaming thread of @pad for every subtitle sample.
+ */
+typedef void (*GstCoolSubtitleFunc) (GstElement * sink, GstPad * pad,
+    GstSample * sample, gpointer user_data);
+
+/**
+ * GstCoolSubtitleBatchFunc:
+ * @sink: the element delivering the samples
+ * @pad: the sink pad of @sink the samples came in on
+ * @samples: the samples of one batch in arrival order, owned by the caller
+ * @n_samples: number of @samples
+ * @user_data: user data given to gst_cool_subtitle_set_batch_func()
+ *
+ * Called with the samples a subtitle sink collected in its batch window,
+ * from the streaming thread of @pad or from a clock thread when the window
+ * ran out before the next sample.
+ */
+typedef void (*GstCoolSubtitleBatchFunc) (GstElement * sink, GstPad * pad,
+    GstSample ** samples, guint n_samples, gpointer user_data);
+
+void            gst_cool_subtitle_set_func      (GstElement * element,
+                                                 GstCoolSubtitleFunc func,
+                                                 gpointer user_data,
+                                                 GDestroyNotify notify);
+gboolean        gst_cool_subtitle_get_func      (GstElement * element,
+                                                 GstCoolSubtitleFunc * func,
+                                                 gpointer * user_data);
+
+void            gst_cool_subtitle_set_batch_func (GstElement * element,
+                                                 GstCoolSubtitleBatchFunc func,
+                                                 gpointer user_data,
+                                                 GDestroyNotify notify);
+gboolean        gst_cool_subtitle_get_batch_func (GstElement * element,
+                                                 GstCoolSubtitleBatchFunc * func,
+                                                 gpointer * user_data);
+
+G_END_DECLS
+
+#endif
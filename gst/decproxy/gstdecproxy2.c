@@ -40,11 +40,20 @@ static GstStaticPadTemplate decproxy_src_template =
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-raw;audio/x-media;video/x-raw"));
 
+enum
+{
+  PROP_0,
+  PROP_DECODER_STATE,
+  PROP_LAST
+};
+
 #define gst_decproxy_parent_class parent_class
 G_DEFINE_TYPE (GstDecProxy, gst_decproxy, GST_TYPE_BIN);
 
 static void gst_decproxy_dispose (GObject * object);
 static void gst_decproxy_finalize (GObject * object);
+static void gst_decproxy_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static gboolean gst_decproxy_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
@@ -68,6 +77,19 @@ gst_decproxy_class_init (GstDecProxyClass * klass)
 
   gobject_klass->dispose = GST_DEBUG_FUNCPTR (gst_decproxy_dispose);
   gobject_klass->finalize = GST_DEBUG_FUNCPTR (gst_decproxy_finalize);
+  gobject_klass->get_property = gst_decproxy_get_property;
+
+  /**
+   * GstDecProxy:decoder-state
+   *
+   * Whether the actual decoder (1) or the puppet (0) is deployed,
+   * -1 before the first caps arrived.
+   */
+  g_object_class_install_property (gobject_klass, PROP_DECODER_STATE,
+      g_param_spec_int ("decoder-state", "Decoder state",
+          "Currently deployed decoder state", GST_DECPROXY_STATE_UNKNOWN,
+          GST_DECPROXY_STATE_DECODER, GST_DECPROXY_STATE_UNKNOWN,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&decproxy_sink_template));
@@ -203,6 +225,24 @@ gst_decproxy_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_decproxy_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstDecProxy *decproxy = GST_DECPROXY (object);
+
+  switch (prop_id) {
+    case PROP_DECODER_STATE:
+      /* don't take the decproxy lock here, it is held while the decoder is
+       * being switched and readers only want a snapshot */
+      g_value_set_int (value, decproxy->current_decoder_state);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 gst_decproxy_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -34,11 +34,37 @@
  *
  * Dynappsrc is #GstBin. It will notified to application when it is created by
  * source-setup signal of pipeline.
- * A appsrc element can be created by new-appsrc signal action to dynappsrc. It
- * should be created before changing state READY to PAUSED. Therefore application
- * need to create appsrc element as soon as receiving source-setup signal.
+ * A appsrc element can be created by new-appsrc signal action to dynappsrc.
+ * The initial appsrc elements should be created before changing state READY
+ * to PAUSED. Therefore application need to create appsrc element as soon as
+ * receiving source-setup signal.
  * Then appsrc can be configured by setting the element to PAUSED state.
  *
+ * Sources can also be added with new-appsrc and removed with remove-appsrc
+ * while dynappsrc is in PAUSED or PLAYING state, for example when a track is
+ * added to or removed from a MSE session. The pad of a new source is added
+ * right away. A removed source is stopped, dropping the data still queued in
+ * its appsrc, and its pad gets EOS and is removed, without affecting the
+ * other sources. Every time the set of sources changes,
+ * dynappsrc posts a "dynappsrc-stream-collection" element message holding
+ * the number of sources and the names of the appsrc elements.
+ *
+ * A seek is applied once to all of sources, whichever src pad it arrives on,
+ * and the sources are flushed in parallel. Instead of handling seek-data of
+ * every appsrc, the application can handle the seek-data signal of
+ * dynappsrc which is emitted once per seek with the offset of every source.
+ *
+ * Likewise, a single feeding thread can handle the need-data signal of
+ * dynappsrc, which reports which sources want data as a bitmap, instead of
+ * need-data and enough-data of every appsrc. The fill level of each source
+ * is set with the set-watermarks action.
+ *
+ * To reproduce a session, the feeds of all sources can be captured to a file
+ * with #GstDynAppSrc:record-location. A dynappsrc with
+ * #GstDynAppSrc:replay-location set to that file creates the same sources
+ * and feeds them from the file, at the captured speed or as fast as
+ * possible, without the application.
+ *
  * When playback has finished (an EOS message has been received on the bus)
  * or an error has occured (an ERROR message has been received on the bus) or
  * the user wants to play a different track, dynappsrc should be set back to
@@ -82,17 +108,37 @@
  * ]|
  * This will create appsrc elements when called source notify handler.
  * </refsect2>
+ * <refsect2>
+ * <title>Zero-copy feeding</title>
+ * <para>
+ * Instead of pushing #GstBuffer to each appsrc, the application can hand its
+ * own memory to dynappsrc with the push-memory and push-fd actions. The
+ * memory is wrapped without copying and the memory-released signal is
+ * emitted with the given user data once the pipeline is done with it, so
+ * that the application can reuse it.
+ * |[
+ * g_signal_emit_by_name (dynappsrc, "push-memory", 0, data, size, pts, dts,
+ *     slot, &ret);
+ * ]|
+ * </para>
+ * </refsect2>
  */
 
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 
 #include "gstdynappsrc.h"
+#include "gstdynappsrcpool.h"
+#include "gstdynappsrcunwrap.h"
+
+#include <gst/cool/gstcool.h>
 
 GST_DEBUG_CATEGORY_STATIC (dyn_appsrc_debug);
 #define GST_CAT_DEFAULT dyn_appsrc_debug
@@ -100,28 +146,81 @@ GST_DEBUG_CATEGORY_STATIC (dyn_appsrc_debug);
 #define parent_class gst_dyn_appsrc_parent_class
 
 #define DEFAULT_PROP_URI NULL
+#define DEFAULT_PROP_UNWRAP_TIMESTAMPS FALSE
+#define DEFAULT_PROP_RECORD_LOCATION NULL
+#define DEFAULT_PROP_REPLAY_LOCATION NULL
+#define DEFAULT_PROP_REPLAY_SYNC TRUE
 
 #define PTS_DTS_MAX_VALUE (((guint64)1) << 33)
 #define MPEGTIME_TO_GSTTIME(t) ((t) * 100000 / 9)
 
+#define BUFFER_TIME(b) (GST_CLOCK_TIME_IS_VALID (GST_BUFFER_DTS (b)) ? \
+    GST_BUFFER_DTS (b) : GST_BUFFER_PTS (b))
+
+/* number of sources reported by need-data */
+#define MAX_FEED_SOURCES 64
+
+/* threads seeking the sources besides the calling one */
+#define MAX_SEEK_THREADS 4
+
 enum
 {
   PROP_0,
   PROP_URI,
   PROP_N_SRC,
   PROP_SMART_PROPERTIES,
+  PROP_UNWRAP_TIMESTAMPS,
+  PROP_NEED_DATA_MASK,
+  PROP_RECORD_LOCATION,
+  PROP_REPLAY_LOCATION,
+  PROP_REPLAY_SYNC,
   PROP_LAST
 };
 
 enum
 {
   SIGNAL_NEW_APPSRC,
+  SIGNAL_MEMORY_RELEASED,
+  SIGNAL_SEEK_DATA,
+  SIGNAL_NEED_DATA,
 
   /* actions */
+  SIGNAL_REMOVE_APPSRC,
   SIGNAL_END_OF_STREAM,
+  SIGNAL_PUSH_MEMORY,
+  SIGNAL_PUSH_FD,
+  SIGNAL_PUSH_BUFFER_LISTS,
+  SIGNAL_SET_WATERMARKS,
   LAST_SIGNAL
 };
 
+typedef struct
+{
+  GstDynAppSrc *bin;
+  /* the index of a source changes when an earlier source is removed */
+  GstElement *appsrc;
+  gpointer user_data;
+
+  /* set when the memory was mapped from a fd */
+  gpointer map;
+  gsize map_size;
+} GstDynAppSrcMemory;
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gint pending;
+  gboolean res;
+} GstDynAppSrcSeekFanout;
+
+typedef struct
+{
+  GstDynAppSrcSeekFanout *fanout;
+  GstPad *target;
+  GstEvent *event;
+} GstDynAppSrcSeekTask;
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src_%u",
     GST_PAD_SRC,
     GST_PAD_SOMETIMES,
@@ -182,14 +281,76 @@ gst_dyn_appsrc_class_init (GstDynAppSrcClass * klass)
           "Hold various property values for reply custom query",
           GST_TYPE_STRUCTURE, G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstDynAppSrc:unwrap-timestamps
+   *
+   * Unwrap the timestamps of each source when they wrap around the 33-bit
+   * MPEG clock (about 26.5 hours), so that long live MPEG-TS sessions keep
+   * on increasing timestamps without a flush.
+   */
+  g_object_class_install_property (gobject_class, PROP_UNWRAP_TIMESTAMPS,
+      g_param_spec_boolean ("unwrap-timestamps", "Unwrap Timestamps",
+          "Unwrap 33-bit MPEG timestamps of every source",
+          DEFAULT_PROP_UNWRAP_TIMESTAMPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:need-data-mask
+   *
+   * Bit n is set while the source with index n wants data, see need-data.
+   */
+  g_object_class_install_property (gobject_class, PROP_NEED_DATA_MASK,
+      g_param_spec_uint64 ("need-data-mask", "Need Data Mask",
+          "Bitmap of the sources that want data", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:record-location
+   *
+   * When set, the buffers, caps, segments and timing of every source are
+   * captured to this file from READY to PAUSED on, so that the session can
+   * be replayed later with #GstDynAppSrc:replay-location.
+   */
+  g_object_class_install_property (gobject_class, PROP_RECORD_LOCATION,
+      g_param_spec_string ("record-location", "Record Location",
+          "File to capture the feeds of all sources to",
+          DEFAULT_PROP_RECORD_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:replay-location
+   *
+   * When set, dynappsrc creates the sources of this capture file itself and
+   * feeds them from it, without the application.
+   */
+  g_object_class_install_property (gobject_class, PROP_REPLAY_LOCATION,
+      g_param_spec_string ("replay-location", "Replay Location",
+          "Capture file to feed the sources from",
+          DEFAULT_PROP_REPLAY_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:replay-sync
+   *
+   * Feed the capture file at the speed it was captured with. Otherwise the
+   * sources are fed as fast as downstream consumes the data.
+   */
+  g_object_class_install_property (gobject_class, PROP_REPLAY_SYNC,
+      g_param_spec_boolean ("replay-sync", "Replay Sync",
+          "Replay at the original speed instead of as fast as possible",
+          DEFAULT_PROP_REPLAY_SYNC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstDynAppSrc::new-appsrc
    * @dynappsrc: a #GstDynAppSrc
    * @name : name of appsrc element
    *
    * Action signal to create a appsrc element.
-   * This signal should be emitted before changing state READY to PAUSED.
-   * The application emit this signal as soon as receiving source-setup signal from pipeline.
+   * The initial sources should be created before changing state READY to
+   * PAUSED, so the application emit this signal as soon as receiving
+   * source-setup signal from pipeline. When emitted in PAUSED or PLAYING
+   * state, the src pad of the new appsrc is exposed right away.
    *
    * Returns: a GstElement of appsrc element or NULL when element creation failed.
    */
@@ -199,6 +360,23 @@ gst_dyn_appsrc_class_init (GstDynAppSrcClass * klass)
       G_STRUCT_OFFSET (GstDynAppSrcClass, new_appsrc), NULL, NULL,
       g_cclosure_marshal_generic, GST_TYPE_ELEMENT, 1, G_TYPE_STRING);
 
+  /**
+   * GstDynAppSrc::remove-appsrc
+   * @dynappsrc: a #GstDynAppSrc
+   * @appsrc: a appsrc element created by new-appsrc
+   *
+   * Action signal to remove a appsrc element and its src pad. It can be
+   * emitted in any state, in PAUSED or PLAYING the other sources keep on
+   * running.
+   *
+   * Returns: TRUE if @appsrc was removed.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_REMOVE_APPSRC] =
+      g_signal_new ("remove-appsrc", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstDynAppSrcClass, remove_appsrc), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_BOOLEAN, 1, GST_TYPE_ELEMENT);
+
   /**
     * GstDynAppSrc::end-of-stream:
     * @dynappsrc: the dynappsrc
@@ -211,8 +389,147 @@ gst_dyn_appsrc_class_init (GstDynAppSrcClass * klass)
           end_of_stream), NULL, NULL, g_cclosure_marshal_generic,
       GST_TYPE_FLOW_RETURN, 0, G_TYPE_NONE);
 
+  /**
+   * GstDynAppSrc::push-memory:
+   * @dynappsrc: the dynappsrc
+   * @index: index of the appsrc to push to
+   * @data: application-owned memory
+   * @size: size of @data
+   * @pts: presentation timestamp or GST_CLOCK_TIME_NONE
+   * @dts: decoding timestamp or GST_CLOCK_TIME_NONE
+   * @user_data: passed back by memory-released
+   *
+   * Push @data to the @index appsrc without copying it. @data must stay
+   * valid until memory-released is emitted with @user_data.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_PUSH_MEMORY] =
+      g_signal_new ("push-memory", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstDynAppSrcClass,
+          push_memory), NULL, NULL, g_cclosure_marshal_generic,
+      GST_TYPE_FLOW_RETURN, 6, G_TYPE_UINT, G_TYPE_POINTER, G_TYPE_UINT64,
+      G_TYPE_UINT64, G_TYPE_UINT64, G_TYPE_POINTER);
+
+  /**
+   * GstDynAppSrc::push-fd:
+   * @dynappsrc: the dynappsrc
+   * @index: index of the appsrc to push to
+   * @fd: a mappable fd such as memfd or dmabuf
+   * @offset: offset of the data in @fd
+   * @size: size of the data
+   * @pts: presentation timestamp or GST_CLOCK_TIME_NONE
+   * @dts: decoding timestamp or GST_CLOCK_TIME_NONE
+   * @user_data: passed back by memory-released
+   *
+   * Map @fd and push the mapped range to the @index appsrc without copying.
+   * @fd is not closed, the application owns it.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_PUSH_FD] =
+      g_signal_new ("push-fd", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstDynAppSrcClass,
+          push_fd), NULL, NULL, g_cclosure_marshal_generic,
+      GST_TYPE_FLOW_RETURN, 7, G_TYPE_UINT, G_TYPE_INT, G_TYPE_UINT64,
+      G_TYPE_UINT64, G_TYPE_UINT64, G_TYPE_UINT64, G_TYPE_POINTER);
+
+  /**
+   * GstDynAppSrc::push-buffer-lists:
+   * @dynappsrc: the dynappsrc
+   * @lists: a #GPtrArray of #GstBufferList, the list at position n is
+   *     pushed to the appsrc with index n, NULL entries are skipped
+   *
+   * Push buffer lists to several appsrc elements in one call. The lists are
+   * not taken over, the caller keeps its reference.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_PUSH_BUFFER_LISTS] =
+      g_signal_new ("push-buffer-lists", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstDynAppSrcClass,
+          push_buffer_lists), NULL, NULL, g_cclosure_marshal_generic,
+      GST_TYPE_FLOW_RETURN, 1, G_TYPE_PTR_ARRAY);
+
+  /**
+   * GstDynAppSrc::memory-released:
+   * @dynappsrc: the dynappsrc
+   * @appsrc: the appsrc the memory was pushed to
+   * @user_data: user data given to push-memory or push-fd
+   *
+   * Emitted from a streaming thread when memory pushed with push-memory or
+   * push-fd is not used anymore. @appsrc may have been removed meanwhile.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_MEMORY_RELEASED] =
+      g_signal_new ("memory-released", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstDynAppSrcClass, memory_released),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 2,
+      GST_TYPE_ELEMENT, G_TYPE_POINTER);
+
+  /**
+   * GstDynAppSrc::seek-data:
+   * @dynappsrc: the dynappsrc
+   * @offsets: a #GArray of guint64 holding the offset the source with index
+   *     n was seeked to at position n, or #GST_BUFFER_OFFSET_NONE when that
+   *     source didn't ask for data
+   *
+   * Emitted once per seek after all of appsrc elements have been flushed,
+   * instead of the application handling seek-data of every appsrc. The
+   * application should feed every source from its offset.
+   *
+   * Returns: TRUE if the application could seek to @offsets.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_SEEK_DATA] =
+      g_signal_new ("seek-data", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstDynAppSrcClass, seek_data),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_BOOLEAN, 1,
+      G_TYPE_ARRAY);
+
+  /**
+   * GstDynAppSrc::need-data:
+   * @dynappsrc: the dynappsrc
+   * @mask: bit n is set when the source with index n wants data
+   *
+   * Emitted when the set of sources that want data changes. A source wants
+   * data once its level dropped to its low watermarks and stops wanting
+   * data when its level reached one of its high watermarks, see
+   * set-watermarks. A single feeding thread can use this instead of
+   * need-data and enough-data of every appsrc.
+   *
+   * Only the first 64 sources are reported.
+   *
+   * This signal is emitted from the streaming thread of a source or from
+   * the thread pushing data, one thread at a time and in order.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_NEED_DATA] =
+      g_signal_new ("need-data", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstDynAppSrcClass, need_data),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 1, G_TYPE_UINT64);
+
+  /**
+   * GstDynAppSrc::set-watermarks:
+   * @dynappsrc: the dynappsrc
+   * @index: index of the appsrc
+   * @low_bytes: level in bytes to start wanting data again
+   * @high_bytes: level in bytes to stop wanting data, 0 for no limit
+   * @low_time: level in time to start wanting data again
+   * @high_time: level in time to stop wanting data, 0 for no limit
+   *
+   * Set the watermarks used by need-data for the @index appsrc. The level
+   * in time is the distance between the last timestamp pushed to the
+   * appsrc and the last timestamp that left it, only data pushed with the
+   * push actions of dynappsrc counts for it.
+   *
+   * Returns: TRUE if @index is a valid source.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_SET_WATERMARKS] =
+      g_signal_new ("set-watermarks", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstDynAppSrcClass,
+          set_watermarks), NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_BOOLEAN, 5, G_TYPE_UINT, G_TYPE_UINT64, G_TYPE_UINT64,
+      G_TYPE_UINT64, G_TYPE_UINT64);
+
   klass->new_appsrc = gst_dyn_appsrc_new_appsrc;
+  klass->remove_appsrc = gst_dyn_appsrc_remove_appsrc;
   klass->end_of_stream = gst_dyn_appsrc_end_of_stream;
+  klass->push_memory = gst_dyn_appsrc_push_memory;
+  klass->push_fd = gst_dyn_appsrc_push_fd;
+  klass->push_buffer_lists = gst_dyn_appsrc_push_buffer_lists;
+  klass->set_watermarks = gst_dyn_appsrc_set_watermarks;
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_dyn_appsrc_change_state);
@@ -232,12 +549,33 @@ gst_dyn_appsrc_init (GstDynAppSrc * bin)
   bin->uri = g_strdup (DEFAULT_PROP_URI);
   bin->appsrc_list = NULL;
   bin->n_source = 0;
+  bin->next_source_id = 0;
   bin->smart_prop = NULL;
 
   bin->directv_rvu = FALSE;
   bin->segment_event = NULL;
   bin->rate = 1.0;
+  bin->unwrap_timestamps = DEFAULT_PROP_UNWRAP_TIMESTAMPS;
   gst_segment_init (&bin->segment, GST_FORMAT_TIME);
+  bin->pool = NULL;
+  bin->seek_pool = NULL;
+  bin->have_seek_seqnum = FALSE;
+  bin->seek_running = FALSE;
+  bin->seek_thread = NULL;
+  g_cond_init (&bin->seek_cond);
+  bin->need_data_mask = 0;
+  bin->need_data_emitted = 0;
+  bin->need_data_emitting = FALSE;
+
+  bin->record_location = g_strdup (DEFAULT_PROP_RECORD_LOCATION);
+  bin->recorder = NULL;
+  bin->replay_location = g_strdup (DEFAULT_PROP_REPLAY_LOCATION);
+  bin->replay_sync = DEFAULT_PROP_REPLAY_SYNC;
+  bin->replay = NULL;
+  bin->replay_thread = NULL;
+  g_mutex_init (&bin->replay_lock);
+  g_cond_init (&bin->replay_cond);
+  bin->replay_stop = FALSE;
 
   GST_OBJECT_FLAG_SET (bin, GST_ELEMENT_FLAG_SOURCE);
 }
@@ -251,11 +589,21 @@ set_smart_properties (GQuark field_id, const GValue * value, gpointer user_data)
   return TRUE;
 }
 
-static void
-apply_smart_properties (GstAppSourceGroup * appsrc_group, GstDynAppSrc * bin)
+/* references to the appsrc elements in the order of their index, with the
+ * object lock held. A source can be removed while running, so the list is
+ * only walked under the lock. */
+static GList *
+copy_appsrcs_unlocked (GstDynAppSrc * bin)
 {
-  GstElement *elem = appsrc_group->appsrc;
-  g_object_set (elem, "smart-properties", bin->smart_prop, NULL);
+  GList *appsrcs = NULL, *item;
+
+  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
+    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
+
+    appsrcs = g_list_prepend (appsrcs, gst_object_ref (appsrc_group->appsrc));
+  }
+
+  return g_list_reverse (appsrcs);
 }
 
 static void
@@ -278,19 +626,51 @@ gst_dyn_appsrc_set_property (GObject * object, guint prop_id,
     case PROP_SMART_PROPERTIES:
     {
       const GstStructure *s = gst_value_get_structure (value);
+      GstStructure *smart_prop;
+      GList *appsrcs, *item;
 
+      GST_OBJECT_LOCK (bin);
       if (bin->smart_prop)
         gst_structure_foreach (s, set_smart_properties, bin->smart_prop);
       else
         bin->smart_prop = gst_structure_copy (s);
 
-      if (bin->appsrc_list)
-        g_list_foreach (bin->appsrc_list, (GFunc) apply_smart_properties, bin);
-
       gst_structure_get_boolean (bin->smart_prop, "directv-rvu",
           &bin->directv_rvu);
+
+      smart_prop = gst_structure_copy (bin->smart_prop);
+      appsrcs = copy_appsrcs_unlocked (bin);
+      GST_OBJECT_UNLOCK (bin);
+
+      for (item = appsrcs; item; item = g_list_next (item))
+        g_object_set (item->data, "smart-properties", smart_prop, NULL);
+
+      g_list_free_full (appsrcs, gst_object_unref);
+      gst_structure_free (smart_prop);
       break;
     }
+    case PROP_UNWRAP_TIMESTAMPS:
+      GST_OBJECT_LOCK (bin);
+      bin->unwrap_timestamps = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_RECORD_LOCATION:
+      GST_OBJECT_LOCK (bin);
+      g_free (bin->record_location);
+      bin->record_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_REPLAY_LOCATION:
+      GST_OBJECT_LOCK (bin);
+      g_free (bin->replay_location);
+      bin->replay_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_REPLAY_SYNC:
+      GST_OBJECT_LOCK (bin);
+      bin->replay_sync = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -314,6 +694,31 @@ gst_dyn_appsrc_get_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (bin);
       break;
     }
+    case PROP_UNWRAP_TIMESTAMPS:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_boolean (value, bin->unwrap_timestamps);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_NEED_DATA_MASK:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->need_data_mask);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_RECORD_LOCATION:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_string (value, bin->record_location);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_REPLAY_LOCATION:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_string (value, bin->replay_location);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_REPLAY_SYNC:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_boolean (value, bin->replay_sync);
+      GST_OBJECT_UNLOCK (bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -337,6 +742,23 @@ gst_dyn_appsrc_finalize (GObject * self)
     bin->segment_event = NULL;
   }
 
+  if (bin->pool) {
+    gst_buffer_pool_set_active (bin->pool, FALSE);
+    gst_object_unref (bin->pool);
+    bin->pool = NULL;
+  }
+
+  if (bin->seek_pool) {
+    g_thread_pool_free (bin->seek_pool, FALSE, TRUE);
+    bin->seek_pool = NULL;
+  }
+
+  g_free (bin->record_location);
+  g_free (bin->replay_location);
+  g_mutex_clear (&bin->replay_lock);
+  g_cond_clear (&bin->replay_cond);
+  g_cond_clear (&bin->seek_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (self);
 }
 
@@ -356,6 +778,189 @@ gst_dyn_appsrc_handle_src_query (GstPad * pad, GstObject * parent,
   return res;
 }
 
+static void
+seek_task_func (gpointer data, gpointer user_data)
+{
+  GstDynAppSrcSeekTask *task = (GstDynAppSrcSeekTask *) data;
+  GstDynAppSrcSeekFanout *fanout = task->fanout;
+  gboolean res;
+
+  res = gst_pad_send_event (task->target, task->event);
+  gst_object_unref (task->target);
+  g_slice_free (GstDynAppSrcSeekTask, task);
+
+  g_mutex_lock (&fanout->lock);
+  fanout->res &= res;
+  if (--fanout->pending == 0)
+    g_cond_signal (&fanout->cond);
+  g_mutex_unlock (&fanout->lock);
+}
+
+static GstDynAppSrcSeekTask *
+new_seek_task (GstDynAppSrcSeekFanout * fanout, GstPad * target,
+    GstEvent * event)
+{
+  GstDynAppSrcSeekTask *task = g_slice_new (GstDynAppSrcSeekTask);
+
+  task->fanout = fanout;
+  task->target = target;
+  task->event = gst_event_ref (event);
+
+  return task;
+}
+
+/* appsrc elements are independent, so each of them is flushed and seeked
+ * from its own thread and the caller only waits for the slowest one */
+static gboolean
+send_seek_to_sources (GstDynAppSrc * bin, GstEvent * event)
+{
+  GstDynAppSrcSeekFanout fanout;
+  GList *targets = NULL, *item;
+  GstIterator *it;
+  GValue data = { 0, };
+  gboolean res, done = FALSE;
+
+  /* sources are added and removed while running, start over when the pads
+   * change under the iterator */
+  it = gst_element_iterate_src_pads (GST_ELEMENT_CAST (bin));
+  while (!done) {
+    switch (gst_iterator_next (it, &data)) {
+      case GST_ITERATOR_OK:
+      {
+        GstPad *srcpad = g_value_get_object (&data);
+        GstPad *target =
+            gst_ghost_pad_get_target (GST_GHOST_PAD_CAST (srcpad));
+
+        if (target)
+          targets = g_list_prepend (targets, target);
+        g_value_reset (&data);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        g_list_free_full (targets, gst_object_unref);
+        targets = NULL;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&data);
+  gst_iterator_free (it);
+
+  if (!targets) {
+    gst_event_unref (event);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (bin);
+  if (!bin->seek_pool && targets->next)
+    bin->seek_pool =
+        g_thread_pool_new (seek_task_func, bin, MAX_SEEK_THREADS, FALSE, NULL);
+  for (item = bin->appsrc_list; item; item = g_list_next (item))
+    ((GstAppSourceGroup *) item->data)->seek_data_pending = FALSE;
+  GST_OBJECT_UNLOCK (bin);
+
+  g_mutex_init (&fanout.lock);
+  g_cond_init (&fanout.cond);
+  fanout.pending = g_list_length (targets);
+  fanout.res = TRUE;
+
+  /* the other sources go to the pool first, so that they are seeked while
+   * the calling thread seeks the first one */
+  for (item = targets->next; item; item = g_list_next (item)) {
+    GstDynAppSrcSeekTask *task = new_seek_task (&fanout, item->data, event);
+
+    if (!g_thread_pool_push (bin->seek_pool, task, NULL))
+      seek_task_func (task, bin);
+  }
+  seek_task_func (new_seek_task (&fanout, targets->data, event), bin);
+  gst_event_unref (event);
+  g_list_free (targets);
+
+  g_mutex_lock (&fanout.lock);
+  while (fanout.pending > 0)
+    g_cond_wait (&fanout.cond, &fanout.lock);
+  res = fanout.res;
+  g_mutex_unlock (&fanout.lock);
+
+  g_cond_clear (&fanout.cond);
+  g_mutex_clear (&fanout.lock);
+
+  return res;
+}
+
+/* apply @event to all of sources and emit one seek-data for them */
+static gboolean
+handle_seek (GstDynAppSrc * bin, GstEvent * event)
+{
+  GArray *offsets;
+  GList *item;
+  gboolean res, seek_data = FALSE;
+
+  if (bin->directv_rvu) {
+    GstFormat format;
+    GstSeekFlags flags;
+    gboolean flush;
+    GstSeekType start_type, stop_type;
+    gint64 start, stop;
+
+    gst_event_parse_seek (event, &bin->rate, &format, &flags, &start_type,
+        &start, &stop_type, &stop);
+
+    flush = flags & GST_SEEK_FLAG_FLUSH;
+
+    if (bin->segment_event) {
+      gst_event_unref (bin->segment_event);
+      bin->segment_event = NULL;
+    }
+
+    if (bin->rate >= 2 || bin->rate < 0 || (bin->rate == 1 && !flush)) {
+      gst_event_unref (event);
+      return TRUE;
+    }
+
+    if (start_type == GST_SEEK_TYPE_SET) {
+      gst_event_unref (event);
+      event = gst_event_new_seek (bin->rate, format, flags,
+          GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE,
+          GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+    }
+  }
+
+  res = send_seek_to_sources (bin, event);
+
+  offsets = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  GST_OBJECT_LOCK (bin);
+  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
+    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
+    guint64 offset = GST_BUFFER_OFFSET_NONE;
+
+    if (appsrc_group->seek_data_pending) {
+      seek_data = TRUE;
+      offset = appsrc_group->seek_data_offset;
+      appsrc_group->seek_data_pending = FALSE;
+    }
+    g_array_append_val (offsets, offset);
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  /* one seek-data for all of sources */
+  if (seek_data && g_signal_has_handler_pending (bin,
+          gst_dyn_appsrc_signals[SIGNAL_SEEK_DATA], 0, FALSE)) {
+    gboolean ret = FALSE;
+
+    g_signal_emit (bin, gst_dyn_appsrc_signals[SIGNAL_SEEK_DATA], 0, offsets,
+        &ret);
+    res &= ret;
+  }
+  g_array_unref (offsets);
+
+  return res;
+}
+
 static gboolean
 gst_dyn_appsrc_handle_src_event (GstPad * pad, GstObject * parent,
     GstEvent * event)
@@ -363,54 +968,44 @@ gst_dyn_appsrc_handle_src_event (GstPad * pad, GstObject * parent,
   gboolean res = TRUE;
   GstPad *target;
   GstDynAppSrc *bin = GST_DYN_APPSRC (parent);
-  GstIterator *it;
-  GValue data = { 0, };
 
   /*
    * dynappsrc handle a seek event that it send to all of linked appsrce elements.
    */
   if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK) {
-    if (bin->directv_rvu) {
-      GstFormat format;
-      GstSeekFlags flags;
-      gboolean flush;
-      GstSeekType start_type, stop_type;
-      gint64 start, stop;
-
-      gst_event_parse_seek (event, &bin->rate, &format, &flags, &start_type,
-          &start, &stop_type, &stop);
-
-      flush = flags & GST_SEEK_FLAG_FLUSH;
-
-      if (bin->segment_event) {
-        gst_event_unref (bin->segment_event);
-        bin->segment_event = NULL;
-      }
-
-      if (bin->rate >= 2 || bin->rate < 0 || (bin->rate == 1 && !flush)) {
-        gst_event_unref (event);
-        return TRUE;
-      }
-
-      if (start_type == GST_SEEK_TYPE_SET) {
-        gst_event_unref (event);
-        event = gst_event_new_seek (bin->rate, format, flags,
-            GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE,
-            GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
-      }
+    guint32 seqnum = gst_event_get_seqnum (event);
+
+    /* the same seek arrives on every src pad, apply it only once. A copy
+     * arriving from another thread while it is applied waits for the
+     * result. */
+    GST_OBJECT_LOCK (bin);
+    if (bin->have_seek_seqnum && bin->seek_seqnum == seqnum) {
+      while (bin->seek_running && bin->seek_seqnum == seqnum
+          && bin->seek_thread != g_thread_self ())
+        g_cond_wait (&bin->seek_cond, GST_OBJECT_GET_LOCK (bin));
+      res = bin->seek_result;
+      GST_OBJECT_UNLOCK (bin);
+      GST_DEBUG_OBJECT (pad, "seek %u is already handled", seqnum);
+      gst_event_unref (event);
+      return res;
     }
+    bin->have_seek_seqnum = TRUE;
+    bin->seek_seqnum = seqnum;
+    bin->seek_result = TRUE;
+    bin->seek_running = TRUE;
+    bin->seek_thread = g_thread_self ();
+    GST_OBJECT_UNLOCK (bin);
 
-    it = gst_element_iterate_src_pads (GST_ELEMENT_CAST (bin));
-    while (gst_iterator_next (it, &data) == GST_ITERATOR_OK) {
-      GstPad *srcpad = g_value_get_object (&data);
-      target = gst_ghost_pad_get_target (GST_GHOST_PAD_CAST (srcpad));
-      res = gst_pad_send_event (target, gst_event_ref (event));
-      gst_object_unref (target);
-      g_value_reset (&data);
+    res = handle_seek (bin, event);
+
+    GST_OBJECT_LOCK (bin);
+    if (bin->seek_seqnum == seqnum) {
+      bin->seek_result = res;
+      bin->seek_running = FALSE;
+      bin->seek_thread = NULL;
     }
-    gst_event_unref (event);
-    g_value_unset (&data);
-    gst_iterator_free (it);
+    g_cond_broadcast (&bin->seek_cond);
+    GST_OBJECT_UNLOCK (bin);
   } else if ((target = gst_ghost_pad_get_target (GST_GHOST_PAD_CAST (pad)))) {
     res = gst_pad_send_event (target, event);
     gst_object_unref (target);
@@ -474,101 +1069,515 @@ pad_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer data)
   return ret;
 }
 
+static void
+reset_unwrap_state (GstAppSourceGroup * appsrc_group)
+{
+  appsrc_group->last_pts = GST_CLOCK_TIME_NONE;
+  appsrc_group->last_dts = GST_CLOCK_TIME_NONE;
+  appsrc_group->pts_wrap_offset = 0;
+  appsrc_group->dts_wrap_offset = 0;
+}
+
 static gboolean
-setup_source (GstDynAppSrc * bin)
+unwrap_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
 {
-  GList *item;
-  GstPadTemplate *pad_tmpl;
-  gchar *padname;
-  gboolean ret = FALSE;
+  GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) user_data;
+  GstClockTime pts, dts;
+
+  pts = gst_dyn_appsrc_unwrap_timestamp (GST_BUFFER_PTS (*buffer),
+      &appsrc_group->last_pts, &appsrc_group->pts_wrap_offset);
+  dts = gst_dyn_appsrc_unwrap_timestamp (GST_BUFFER_DTS (*buffer),
+      &appsrc_group->last_dts, &appsrc_group->dts_wrap_offset);
+
+  if (pts != GST_BUFFER_PTS (*buffer) || dts != GST_BUFFER_DTS (*buffer)) {
+    *buffer = gst_buffer_make_writable (*buffer);
+    GST_BUFFER_PTS (*buffer) = pts;
+    GST_BUFFER_DTS (*buffer) = dts;
+  }
 
-  pad_tmpl = gst_static_pad_template_get (&src_template);
+  return TRUE;
+}
 
-  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
-    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
-    GstPad *srcpad = NULL;
+static GstPadProbeReturn
+unwrap_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer data)
+{
+  GstDynAppSrc *bin = GST_DYN_APPSRC (GST_PAD_PARENT (pad));
+  GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) data;
+  gboolean unwrap;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    /* timestamps start over from wherever the application seeked to */
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP)
+      reset_unwrap_state (appsrc_group);
+    return GST_PAD_PROBE_OK;
+  }
+
+  GST_OBJECT_LOCK (bin);
+  unwrap = bin->unwrap_timestamps;
+  GST_OBJECT_UNLOCK (bin);
+
+  if (!unwrap)
+    return GST_PAD_PROBE_OK;
 
-    gst_bin_add (GST_BIN_CAST (bin), appsrc_group->appsrc);
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+    GstSegment segment;
 
-    srcpad = gst_element_get_static_pad (appsrc_group->appsrc, "src");
-    padname =
-        g_strdup_printf ("src_%u", g_list_position (bin->appsrc_list, item));
-    appsrc_group->srcpad =
-        gst_ghost_pad_new_from_template (padname, srcpad, pad_tmpl);
-    gst_pad_set_event_function (appsrc_group->srcpad,
-        gst_dyn_appsrc_handle_src_event);
-    gst_pad_set_query_function (appsrc_group->srcpad,
-        gst_dyn_appsrc_handle_src_query);
+    if (GST_EVENT_TYPE (event) != GST_EVENT_SEGMENT)
+      return GST_PAD_PROBE_OK;
 
-    gst_pad_set_active (appsrc_group->srcpad, TRUE);
-    gst_element_add_pad (GST_ELEMENT_CAST (bin), appsrc_group->srcpad);
+    /* the segment has to cover the unwrapped buffers which follow it */
+    gst_event_copy_segment (event, &segment);
+    if (segment.format == GST_FORMAT_TIME &&
+        gst_dyn_appsrc_unwrap_segment (&segment, appsrc_group->last_pts,
+            appsrc_group->pts_wrap_offset)) {
+      GstEvent *unwrapped = gst_event_new_segment (&segment);
 
-    gst_pad_add_probe (appsrc_group->srcpad,
-        GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
-        pad_probe_cb, NULL, NULL);
+      gst_event_set_seqnum (unwrapped, gst_event_get_seqnum (event));
+      gst_event_unref (event);
+      GST_PAD_PROBE_INFO_DATA (info) = unwrapped;
+    }
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
 
-    gst_object_unref (srcpad);
-    g_free (padname);
+    unwrap_buffer (&buffer, 0, appsrc_group);
+    GST_PAD_PROBE_INFO_DATA (info) = buffer;
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
 
-    ret = TRUE;
+    list = gst_buffer_list_make_writable (list);
+    gst_buffer_list_foreach (list, unwrap_buffer, appsrc_group);
+    GST_PAD_PROBE_INFO_DATA (info) = list;
   }
-  gst_object_unref (pad_tmpl);
 
-  if (ret) {
-    GST_DEBUG_OBJECT (bin, "all appsrc elements are added");
-    gst_element_no_more_pads (GST_ELEMENT_CAST (bin));
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+reset_feed_state (GstAppSourceGroup * appsrc_group)
+{
+  appsrc_group->in_time = GST_CLOCK_TIME_NONE;
+  appsrc_group->out_time = GST_CLOCK_TIME_NONE;
+}
+
+/* called with the object lock of dynappsrc, uses the cached levels */
+static gboolean
+source_needs_data (GstAppSourceGroup * appsrc_group)
+{
+  guint64 bytes = appsrc_group->level_bytes;
+  GstClockTime time = 0;
+
+  if (GST_CLOCK_TIME_IS_VALID (appsrc_group->in_time)
+      && GST_CLOCK_TIME_IS_VALID (appsrc_group->out_time)
+      && appsrc_group->in_time > appsrc_group->out_time)
+    time = appsrc_group->in_time - appsrc_group->out_time;
+
+  if (appsrc_group->need_data) {
+    if ((appsrc_group->high_bytes && bytes >= appsrc_group->high_bytes)
+        || (appsrc_group->high_time && time >= appsrc_group->high_time))
+      appsrc_group->need_data = FALSE;
+  } else {
+    if ((!appsrc_group->high_bytes || bytes <= appsrc_group->low_bytes)
+        && (!appsrc_group->high_time || time <= appsrc_group->low_time))
+      appsrc_group->need_data = TRUE;
   }
 
-  return ret;
+  return appsrc_group->need_data;
 }
 
+/* recompute which sources want data and tell the application when that
+ * changed, so that it only wakes up when there is something to do. One
+ * thread at a time emits need-data and it keeps going until the latest
+ * mask was emitted, so that the masks arrive in order. */
 static void
-remove_source (GstDynAppSrc * bin)
+update_need_data (GstDynAppSrc * bin)
 {
   GList *item;
+  guint64 mask = 0;
+  guint index = 0;
 
-  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
+  GST_OBJECT_LOCK (bin);
+  for (item = bin->appsrc_list; item && index < MAX_FEED_SOURCES;
+      item = g_list_next (item), index++) {
     GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
 
-    GST_DEBUG_OBJECT (bin, "removing appsrc element and ghostpad");
+    if (source_needs_data (appsrc_group))
+      mask |= G_GUINT64_CONSTANT (1) << index;
+  }
+  bin->need_data_mask = mask;
+
+  if (bin->need_data_emitting) {
+    GST_OBJECT_UNLOCK (bin);
+    return;
+  }
+
+  bin->need_data_emitting = TRUE;
+  while (bin->need_data_mask != bin->need_data_emitted) {
+    mask = bin->need_data_emitted = bin->need_data_mask;
+    GST_OBJECT_UNLOCK (bin);
+
+    GST_LOG_OBJECT (bin, "sources wanting data: 0x%" G_GINT64_MODIFIER "x",
+        mask);
+    g_signal_emit (bin, gst_dyn_appsrc_signals[SIGNAL_NEED_DATA], 0, mask);
+
+    GST_OBJECT_LOCK (bin);
+  }
+  bin->need_data_emitting = FALSE;
+  GST_OBJECT_UNLOCK (bin);
+}
+
+static gsize
+buffer_list_get_size (GstBufferList * list)
+{
+  guint i, len = gst_buffer_list_length (list);
+  gsize size = 0;
+
+  for (i = 0; i < len; i++)
+    size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+  return size;
+}
+
+/* account for @bytes that dynappsrc is about to push to @appsrc, @in_time
+ * is the last timestamp pushed. This happens before the push, so that the
+ * probe never sees the data leave before it was counted. A push only fails
+ * when flushing or after EOS and a flush resets the level anyway. */
+static void
+feed_push (GstDynAppSrc * bin, GstElement * appsrc, gsize bytes,
+    GstClockTime in_time)
+{
+  GList *item;
+
+  GST_OBJECT_LOCK (bin);
+  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
+    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
+
+    if (appsrc_group->appsrc == appsrc) {
+      appsrc_group->level_bytes += bytes;
+      if (GST_CLOCK_TIME_IS_VALID (in_time))
+        appsrc_group->in_time = in_time;
+      break;
+    }
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  update_need_data (bin);
+}
+
+/* keeps track of what leaves the appsrc. The level in bytes only counts
+ * data pushed through dynappsrc, data pushed to the appsrc directly is
+ * not accounted for. */
+static GstPadProbeReturn
+feed_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer data)
+{
+  GstDynAppSrc *bin = GST_DYN_APPSRC (GST_PAD_PARENT (pad));
+  GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) data;
+  GstClockTime out_time = GST_CLOCK_TIME_NONE;
+  gboolean watermarks;
+  gsize bytes = 0;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP) {
+      GST_OBJECT_LOCK (bin);
+      reset_feed_state (appsrc_group);
+      appsrc_group->level_bytes = 0;
+      GST_OBJECT_UNLOCK (bin);
+      update_need_data (bin);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    out_time = BUFFER_TIME (buffer);
+    bytes = gst_buffer_get_size (buffer);
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint len = gst_buffer_list_length (list);
+
+    if (len > 0)
+      out_time = BUFFER_TIME (gst_buffer_list_get (list, len - 1));
+    bytes = buffer_list_get_size (list);
+  }
+
+  GST_OBJECT_LOCK (bin);
+  appsrc_group->level_bytes -= MIN (appsrc_group->level_bytes, bytes);
+  if (GST_CLOCK_TIME_IS_VALID (out_time))
+    appsrc_group->out_time = out_time;
+  watermarks = appsrc_group->high_bytes || appsrc_group->high_time;
+  GST_OBJECT_UNLOCK (bin);
+
+  /* without watermarks the source always wants data */
+  if (watermarks)
+    update_need_data (bin);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* writes everything leaving the appsrc to the capture file. Sources are
+ * recorded by their id, which stays valid when other sources are removed,
+ * and the EOS pushed on the pad of a removed source is recorded too. */
+static GstPadProbeReturn
+record_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer data)
+{
+  GstDynAppSrc *bin = GST_DYN_APPSRC (GST_PAD_PARENT (pad));
+  guint id = ((GstAppSourceGroup *) data)->id;
+
+  if (!bin->recorder)
+    return GST_PAD_PROBE_OK;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    gst_dyn_appsrc_recorder_write_buffer (bin->recorder, id,
+        GST_PAD_PROBE_INFO_BUFFER (info));
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++)
+      gst_dyn_appsrc_recorder_write_buffer (bin->recorder, id,
+          gst_buffer_list_get (list, i));
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) &
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    gst_dyn_appsrc_recorder_write_event (bin->recorder, id,
+        GST_PAD_PROBE_INFO_EVENT (info));
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* notify the application about the current set of sources */
+static void
+post_stream_collection (GstDynAppSrc * bin)
+{
+  GstStructure *s;
+  GValue sources = G_VALUE_INIT;
+  GValue name = G_VALUE_INIT;
+  GList *item;
+  gint n_source;
+
+  g_value_init (&sources, GST_TYPE_ARRAY);
+  g_value_init (&name, G_TYPE_STRING);
+
+  GST_OBJECT_LOCK (bin);
+  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
+    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
+
+    g_value_set_string (&name, GST_ELEMENT_NAME (appsrc_group->appsrc));
+    gst_value_array_append_value (&sources, &name);
+  }
+  n_source = bin->n_source;
+  GST_OBJECT_UNLOCK (bin);
+
+  s = gst_structure_new ("dynappsrc-stream-collection",
+      "n-source", G_TYPE_INT, n_source, NULL);
+  gst_structure_set_value (s, "sources", &sources);
+
+  g_value_unset (&name);
+  g_value_unset (&sources);
+
+  gst_element_post_message (GST_ELEMENT_CAST (bin),
+      gst_message_new_element (GST_OBJECT_CAST (bin), s));
+  g_object_notify (G_OBJECT (bin), "n-source");
+
+  /* the indexes of the sources may have changed */
+  update_need_data (bin);
+}
+
+/* add the appsrc to the bin and expose its src pad */
+static void
+expose_appsrc (GstDynAppSrc * bin, GstAppSourceGroup * appsrc_group)
+{
+  GstPadTemplate *pad_tmpl;
+  GstPad *srcpad;
+  gchar *padname;
+
+  gst_bin_add (GST_BIN_CAST (bin), appsrc_group->appsrc);
+
+  padname = g_strdup_printf ("src_%u", appsrc_group->id);
+  pad_tmpl = gst_static_pad_template_get (&src_template);
+  srcpad = gst_element_get_static_pad (appsrc_group->appsrc, "src");
+  appsrc_group->srcpad =
+      gst_ghost_pad_new_from_template (padname, srcpad, pad_tmpl);
+  gst_pad_set_event_function (appsrc_group->srcpad,
+      gst_dyn_appsrc_handle_src_event);
+  gst_pad_set_query_function (appsrc_group->srcpad,
+      gst_dyn_appsrc_handle_src_query);
+
+  gst_pad_set_active (appsrc_group->srcpad, TRUE);
+  gst_element_add_pad (GST_ELEMENT_CAST (bin), appsrc_group->srcpad);
+
+  gst_pad_add_probe (appsrc_group->srcpad,
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      pad_probe_cb, NULL, NULL);
+
+  /* capture and feed control see the data as the application pushed it,
+   * the probes are removed before the group is freed */
+  appsrc_group->record_probe = gst_pad_add_probe (appsrc_group->srcpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, record_probe_cb, appsrc_group, NULL);
+  appsrc_group->feed_probe = gst_pad_add_probe (appsrc_group->srcpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH, feed_probe_cb, appsrc_group, NULL);
+  appsrc_group->unwrap_probe = gst_pad_add_probe (appsrc_group->srcpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      unwrap_probe_cb, appsrc_group, NULL);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (pad_tmpl);
+  g_free (padname);
+}
+
+/* collect seek-data of every appsrc, the application gets a single
+ * seek-data from dynappsrc once all of them are seeked. A seek-data
+ * handler the application connected to the appsrc itself still decides. */
+static gboolean
+appsrc_seek_data_cb (GstElement * appsrc, guint64 offset,
+    GstAppSourceGroup * appsrc_group)
+{
+  GstObject *bin = gst_object_get_parent (GST_OBJECT_CAST (appsrc));
+
+  if (!bin)
+    return TRUE;
+
+  GST_OBJECT_LOCK (bin);
+  appsrc_group->seek_data_pending = TRUE;
+  appsrc_group->seek_data_offset = offset;
+  GST_OBJECT_UNLOCK (bin);
+  gst_object_unref (bin);
+
+  return TRUE;
+}
+
+/* stop the appsrc, which drops what is still queued in it, remove its pad
+ * and take it out of the bin. When @eos is set, downstream gets EOS on the
+ * pad before it goes away. */
+static void
+release_appsrc_group (GstDynAppSrc * bin, GstAppSourceGroup * appsrc_group,
+    gboolean eos)
+{
+  GstElement *appsrc = appsrc_group->appsrc;
+
+  GST_DEBUG_OBJECT (bin, "removing appsrc element and ghostpad");
+
+  gst_cool_budget_unregister (appsrc);
+  g_signal_handlers_disconnect_by_func (appsrc, appsrc_seek_data_cb,
+      appsrc_group);
+  gst_element_set_state (appsrc, GST_STATE_NULL);
+
+  if (appsrc_group->srcpad) {
+    /* the streaming thread is stopped, we can push from here */
+    if (eos)
+      gst_pad_push_event (appsrc_group->srcpad, gst_event_new_eos ());
+
+    /* the probes use the group, which is freed below */
+    gst_pad_remove_probe (appsrc_group->srcpad, appsrc_group->record_probe);
+    gst_pad_remove_probe (appsrc_group->srcpad, appsrc_group->feed_probe);
+    gst_pad_remove_probe (appsrc_group->srcpad, appsrc_group->unwrap_probe);
 
     gst_ghost_pad_set_target (GST_GHOST_PAD_CAST (appsrc_group->srcpad), NULL);
+    gst_pad_set_active (appsrc_group->srcpad, FALSE);
     gst_element_remove_pad (GST_ELEMENT_CAST (bin), appsrc_group->srcpad);
     appsrc_group->srcpad = NULL;
+  }
+
+  if (GST_OBJECT_PARENT (appsrc) == GST_OBJECT_CAST (bin))
+    gst_bin_remove (GST_BIN_CAST (bin), appsrc);
+  else
+    gst_object_unref (gst_object_ref_sink (appsrc));
+  appsrc_group->appsrc = NULL;
+
+  g_free (appsrc_group);
+}
+
+static gboolean
+setup_source (GstDynAppSrc * bin)
+{
+  GList *item, *groups;
+  gboolean ret = FALSE;
+
+  /* sources added from now on are exposed by new-appsrc */
+  GST_OBJECT_LOCK (bin);
+  groups = g_list_copy (bin->appsrc_list);
+  bin->exposed = TRUE;
+  GST_OBJECT_UNLOCK (bin);
 
-    gst_element_set_state (appsrc_group->appsrc, GST_STATE_NULL);
-    gst_bin_remove (GST_BIN_CAST (bin), appsrc_group->appsrc);
-    appsrc_group->appsrc = NULL;
+  for (item = groups; item; item = g_list_next (item)) {
+    expose_appsrc (bin, (GstAppSourceGroup *) item->data);
+    ret = TRUE;
   }
+  g_list_free (groups);
 
-  g_list_free_full (bin->appsrc_list, g_free);
-  bin->appsrc_list = NULL;
+  if (ret) {
+    GST_DEBUG_OBJECT (bin, "all appsrc elements are added");
+    gst_element_no_more_pads (GST_ELEMENT_CAST (bin));
+    post_stream_collection (bin);
+  } else {
+    /* the state change fails, don't expose sources in READY */
+    GST_OBJECT_LOCK (bin);
+    bin->exposed = FALSE;
+    GST_OBJECT_UNLOCK (bin);
+  }
+
+  return ret;
+}
+
+static void
+remove_source (GstDynAppSrc * bin)
+{
+  GList *item, *groups;
 
+  GST_OBJECT_LOCK (bin);
+  groups = bin->appsrc_list;
+  bin->appsrc_list = NULL;
+  bin->exposed = FALSE;
   bin->n_source = 0;
+  bin->next_source_id = 0;
+  GST_OBJECT_UNLOCK (bin);
+
+  for (item = groups; item; item = g_list_next (item))
+    release_appsrc_group (bin, (GstAppSourceGroup *) item->data, FALSE);
+
+  g_list_free (groups);
 }
 
 static GstElement *
 gst_dyn_appsrc_new_appsrc (GstDynAppSrc * bin, const gchar * name)
 {
   GstAppSourceGroup *appsrc_group;
+  gboolean running, unreported;
 
-  GST_OBJECT_LOCK (bin);
-
-  if (GST_STATE (bin) >= GST_STATE_PAUSED) {
-    GST_WARNING_OBJECT (bin,
-        "deny to create appsrc when state is in PAUSED or PLAYING state");
-    GST_OBJECT_UNLOCK (bin);
-    return NULL;
-  }
   appsrc_group = g_malloc0 (sizeof (GstAppSourceGroup));
   appsrc_group->appsrc = gst_element_factory_make ("appsrc", name);
+  if (!appsrc_group->appsrc) {
+    GST_WARNING_OBJECT (bin, "failed to create appsrc element");
+    g_free (appsrc_group);
+    return NULL;
+  }
+  reset_unwrap_state (appsrc_group);
+  g_signal_connect (appsrc_group->appsrc, "seek-data",
+      G_CALLBACK (appsrc_seek_data_cb), appsrc_group);
+
+  reset_feed_state (appsrc_group);
+  appsrc_group->need_data = TRUE;
+
+  GST_OBJECT_LOCK (bin);
 
   if (bin->smart_prop)
     g_object_set (appsrc_group->appsrc, "smart-properties", bin->smart_prop,
         NULL);
 
+  appsrc_group->id = bin->next_source_id++;
   bin->appsrc_list = g_list_append (bin->appsrc_list, appsrc_group);
   bin->n_source++;
+  unreported = (bin->n_source > MAX_FEED_SOURCES);
+
+  /* sources added after setup_source() took its copy of the list are
+   * exposed right away */
+  running = bin->exposed;
 
   GST_INFO_OBJECT (bin, "appsrc %p is appended to a list",
       appsrc_group->appsrc);
@@ -576,9 +1585,67 @@ gst_dyn_appsrc_new_appsrc (GstDynAppSrc * bin, const gchar * name)
 
   GST_OBJECT_UNLOCK (bin);
 
+  if (unreported)
+    GST_ELEMENT_WARNING (bin, CORE, TOO_LAZY, (NULL),
+        ("need-data only reports the first %d sources", MAX_FEED_SOURCES));
+
+  /* max-bytes of appsrc comes from the memory budget when it is enabled */
+  gst_cool_budget_register (appsrc_group->appsrc, GST_COOL_BUDGET_WEIGHT_STREAM,
+      NULL, NULL);
+
+  if (running) {
+    GST_DEBUG_OBJECT (bin, "adding appsrc %p while running",
+        appsrc_group->appsrc);
+    expose_appsrc (bin, appsrc_group);
+    gst_element_sync_state_with_parent (appsrc_group->appsrc);
+    post_stream_collection (bin);
+  }
+
   return appsrc_group->appsrc;
 }
 
+/**
+ * gst_dyn_appsrc_remove_appsrc:
+ * @dynappsrc: a #GstDynAppSrc
+ * @appsrc: an appsrc element created by new-appsrc
+ *
+ * Removes @appsrc and its src pad. The data still queued in @appsrc is
+ * dropped. In PAUSED or PLAYING downstream gets EOS on the pad before it is
+ * removed, the other sources keep running. The index of the sources
+ * following @appsrc is decreased by one.
+ *
+ * Returns: TRUE if @appsrc was removed.
+ */
+gboolean
+gst_dyn_appsrc_remove_appsrc (GstDynAppSrc * bin, GstElement * appsrc)
+{
+  GstAppSourceGroup *appsrc_group = NULL;
+  GList *item;
+
+  g_return_val_if_fail (appsrc != NULL, FALSE);
+
+  GST_OBJECT_LOCK (bin);
+  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
+    if (((GstAppSourceGroup *) item->data)->appsrc == appsrc) {
+      appsrc_group = item->data;
+      bin->appsrc_list = g_list_delete_link (bin->appsrc_list, item);
+      bin->n_source--;
+      break;
+    }
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  if (!appsrc_group) {
+    GST_WARNING_OBJECT (bin, "appsrc %p doesn't belong to dynappsrc", appsrc);
+    return FALSE;
+  }
+
+  release_appsrc_group (bin, appsrc_group, TRUE);
+  post_stream_collection (bin);
+
+  return TRUE;
+}
+
 /**
  * gst_dyn_appsrc_end_of_stream:
  * @dynappsrc: a #GstDynAppSrc
@@ -593,22 +1660,517 @@ GstFlowReturn
 gst_dyn_appsrc_end_of_stream (GstDynAppSrc * bin)
 {
   GstFlowReturn ret = GST_FLOW_OK;
+  GList *appsrcs, *item;
+
+  GST_OBJECT_LOCK (bin);
+  appsrcs = copy_appsrcs_unlocked (bin);
+  GST_OBJECT_UNLOCK (bin);
+
+  for (item = appsrcs; item; item = g_list_next (item)) {
+    GstElement *appsrc = item->data;
+
+    GST_DEBUG_OBJECT (bin, "indicate to appsrc element for EOS");
+    g_signal_emit_by_name (appsrc, "end-of-stream", &ret);
+    GST_DEBUG_OBJECT (bin, "%s[ret:%s]", GST_ELEMENT_NAME (appsrc),
+        gst_flow_get_name (ret));
+    if (ret != GST_FLOW_OK)
+      break;
+  }
+  g_list_free_full (appsrcs, gst_object_unref);
+
+  return ret;
+}
+
+static GstElement *
+get_appsrc_by_id (GstDynAppSrc * bin, guint id)
+{
+  GstElement *appsrc = NULL;
   GList *item;
 
+  GST_OBJECT_LOCK (bin);
   for (item = bin->appsrc_list; item; item = g_list_next (item)) {
     GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
 
-    GST_DEBUG_OBJECT (bin, "indicate to appsrc element for EOS");
-    g_signal_emit_by_name (appsrc_group->appsrc, "end-of-stream", &ret);
-    GST_DEBUG_OBJECT (bin, "%s[ret:%s]",
-        GST_ELEMENT_NAME (appsrc_group->appsrc), gst_flow_get_name (ret));
-    if (ret != GST_FLOW_OK)
+    if (appsrc_group->id == id && appsrc_group->appsrc) {
+      appsrc = gst_object_ref (appsrc_group->appsrc);
       break;
+    }
   }
+  GST_OBJECT_UNLOCK (bin);
+
+  return appsrc;
+}
+
+static GstElement *
+get_appsrc_by_index (GstDynAppSrc * bin, guint index)
+{
+  GstAppSourceGroup *appsrc_group;
+  GstElement *appsrc = NULL;
+
+  GST_OBJECT_LOCK (bin);
+  appsrc_group = g_list_nth_data (bin->appsrc_list, index);
+  if (appsrc_group && appsrc_group->appsrc)
+    appsrc = gst_object_ref (appsrc_group->appsrc);
+  GST_OBJECT_UNLOCK (bin);
+
+  return appsrc;
+}
+
+static void
+release_memory (GstDynAppSrcMemory * mem)
+{
+  if (mem->map)
+    munmap (mem->map, mem->map_size);
+
+  g_signal_emit (mem->bin, gst_dyn_appsrc_signals[SIGNAL_MEMORY_RELEASED], 0,
+      mem->appsrc, mem->user_data);
+
+  gst_object_unref (mem->appsrc);
+  gst_object_unref (mem->bin);
+  g_slice_free (GstDynAppSrcMemory, mem);
+}
+
+static GstDynAppSrcMemory *
+new_memory (GstDynAppSrc * bin, GstElement * appsrc, gpointer user_data)
+{
+  GstDynAppSrcMemory *mem;
+
+  mem = g_slice_new0 (GstDynAppSrcMemory);
+  mem->bin = gst_object_ref (bin);
+  mem->appsrc = gst_object_ref (appsrc);
+  mem->user_data = user_data;
+
+  return mem;
+}
+
+/* wrap @data into a recycled buffer and push it to the appsrc of @mem,
+ * @mem is released once the buffer is not used anymore */
+static GstFlowReturn
+push_wrapped_memory (GstDynAppSrc * bin, GstDynAppSrcMemory * mem,
+    gpointer data, gsize maxsize, gsize offset, gsize size, guint64 pts,
+    guint64 dts)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstElement *appsrc = gst_object_ref (mem->appsrc);
+  GstBuffer *buffer = NULL;
+  GstBufferPool *pool;
+
+  GST_OBJECT_LOCK (bin);
+  if (!bin->pool)
+    bin->pool = gst_dyn_appsrc_pool_new ();
+  pool = bin->pool ? gst_object_ref (bin->pool) : NULL;
+  GST_OBJECT_UNLOCK (bin);
+
+  if (pool) {
+    ret = gst_buffer_pool_acquire_buffer (pool, &buffer, NULL);
+    gst_object_unref (pool);
+  }
+  if (!buffer)
+    buffer = gst_buffer_new ();
+
+  gst_buffer_append_memory (buffer,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, data, maxsize, offset,
+          size, mem, (GDestroyNotify) release_memory));
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DTS (buffer) = dts;
+
+  feed_push (bin, appsrc, gst_buffer_get_size (buffer), BUFFER_TIME (buffer));
+  g_signal_emit_by_name (appsrc, "push-buffer", buffer, &ret);
+  gst_buffer_unref (buffer);
+
+  GST_LOG_OBJECT (bin, "pushed %" G_GSIZE_FORMAT " bytes to %s [ret:%s]",
+      size, GST_ELEMENT_NAME (appsrc), gst_flow_get_name (ret));
+  gst_object_unref (appsrc);
+
+  return ret;
+}
+
+/**
+ * gst_dyn_appsrc_push_memory:
+ * @dynappsrc: a #GstDynAppSrc
+ * @index: index of the appsrc to push to
+ * @data: application-owned memory
+ * @size: size of @data
+ * @pts: presentation timestamp
+ * @dts: decoding timestamp
+ * @user_data: passed back by memory-released
+ *
+ * Wraps @data without copying and pushes it to the @index appsrc.
+ *
+ * Returns: #GST_FLOW_OK when the buffer was queued.
+ */
+GstFlowReturn
+gst_dyn_appsrc_push_memory (GstDynAppSrc * bin, guint index, gpointer data,
+    guint64 size, guint64 pts, guint64 dts, gpointer user_data)
+{
+  GstDynAppSrcMemory *mem;
+  GstElement *appsrc;
+
+  g_return_val_if_fail (data != NULL, GST_FLOW_ERROR);
+
+  if (!(appsrc = get_appsrc_by_index (bin, index))) {
+    GST_WARNING_OBJECT (bin, "no appsrc for index %u", index);
+    return GST_FLOW_ERROR;
+  }
+
+  mem = new_memory (bin, appsrc, user_data);
+  gst_object_unref (appsrc);
+
+  return push_wrapped_memory (bin, mem, data, size, 0, size, pts, dts);
+}
+
+/**
+ * gst_dyn_appsrc_push_fd:
+ * @dynappsrc: a #GstDynAppSrc
+ * @index: index of the appsrc to push to
+ * @fd: a mappable fd
+ * @offset: offset of the data in @fd
+ * @size: size of the data
+ * @pts: presentation timestamp
+ * @dts: decoding timestamp
+ * @user_data: passed back by memory-released
+ *
+ * Maps @fd and pushes the mapped range to the @index appsrc without copying.
+ *
+ * Returns: #GST_FLOW_OK when the buffer was queued.
+ */
+GstFlowReturn
+gst_dyn_appsrc_push_fd (GstDynAppSrc * bin, guint index, gint fd,
+    guint64 offset, guint64 size, guint64 pts, guint64 dts, gpointer user_data)
+{
+  GstDynAppSrcMemory *mem;
+  GstElement *appsrc;
+  gsize page_size = sysconf (_SC_PAGESIZE);
+  gsize delta = offset % page_size;
+  gpointer map;
+
+  g_return_val_if_fail (fd >= 0, GST_FLOW_ERROR);
+
+  if (!(appsrc = get_appsrc_by_index (bin, index))) {
+    GST_WARNING_OBJECT (bin, "no appsrc for index %u", index);
+    return GST_FLOW_ERROR;
+  }
+
+  /* mmap wants a page aligned offset */
+  map = mmap (NULL, size + delta, PROT_READ, MAP_SHARED, fd, offset - delta);
+  if (map == MAP_FAILED) {
+    GST_WARNING_OBJECT (bin, "failed to map fd %d: %s", fd,
+        g_strerror (errno));
+    gst_object_unref (appsrc);
+    return GST_FLOW_ERROR;
+  }
+
+  mem = new_memory (bin, appsrc, user_data);
+  gst_object_unref (appsrc);
+  mem->map = map;
+  mem->map_size = size + delta;
+
+  return push_wrapped_memory (bin, mem, map, size + delta, delta, size, pts,
+      dts);
+}
+
+/* push @list to @appsrc, as a list when appsrc supports it */
+static GstFlowReturn
+push_buffer_list (GstElement * appsrc, GstBufferList * list)
+{
+  static gsize signals_looked_up = 0;
+  static guint push_buffer_id = 0;
+  static guint push_buffer_list_id = 0;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  /* push-buffer-list only exists in newer appsrc versions */
+  if (g_once_init_enter (&signals_looked_up)) {
+    push_buffer_list_id =
+        g_signal_lookup ("push-buffer-list", G_OBJECT_TYPE (appsrc));
+    push_buffer_id = g_signal_lookup ("push-buffer", G_OBJECT_TYPE (appsrc));
+    g_once_init_leave (&signals_looked_up, 1);
+  }
+
+  if (push_buffer_list_id) {
+    g_signal_emit (appsrc, push_buffer_list_id, 0, list, &ret);
+    return ret;
+  }
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+    g_signal_emit (appsrc, push_buffer_id, 0, gst_buffer_list_get (list, i),
+        &ret);
+
+  return ret;
+}
+
+/**
+ * gst_dyn_appsrc_push_buffer_lists:
+ * @dynappsrc: a #GstDynAppSrc
+ * @lists: a #GPtrArray of #GstBufferList indexed by appsrc
+ *
+ * Pushes each list in @lists to the appsrc with the same index. The appsrc
+ * elements are looked up once for the whole batch. A failure on one source
+ * does not keep the lists of the other sources from being pushed.
+ *
+ * Returns: #GST_FLOW_OK when all lists were queued, or the first failure.
+ */
+GstFlowReturn
+gst_dyn_appsrc_push_buffer_lists (GstDynAppSrc * bin, GPtrArray * lists)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstElement **appsrcs;
+  GList *item;
+  guint i, len;
+
+  g_return_val_if_fail (lists != NULL, GST_FLOW_ERROR);
+
+  appsrcs = g_new0 (GstElement *, lists->len);
+
+  GST_OBJECT_LOCK (bin);
+  for (i = 0, item = bin->appsrc_list; i < lists->len; i++) {
+    GstAppSourceGroup *appsrc_group = item ? item->data : NULL;
+
+    if (g_ptr_array_index (lists, i) && appsrc_group && appsrc_group->appsrc)
+      appsrcs[i] = gst_object_ref (appsrc_group->appsrc);
+
+    item = item ? g_list_next (item) : NULL;
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  for (i = 0; i < lists->len; i++) {
+    GstBufferList *list = g_ptr_array_index (lists, i);
+    GstFlowReturn res;
+
+    if (!list)
+      continue;
+
+    if (!appsrcs[i]) {
+      GST_WARNING_OBJECT (bin, "no appsrc for index %u", i);
+      if (ret == GST_FLOW_OK)
+        ret = GST_FLOW_ERROR;
+      continue;
+    }
+
+    len = gst_buffer_list_length (list);
+    if (len > 0) {
+      GstBuffer *last = gst_buffer_list_get (list, len - 1);
+
+      feed_push (bin, appsrcs[i], buffer_list_get_size (list),
+          BUFFER_TIME (last));
+    }
+    res = push_buffer_list (appsrcs[i], list);
+    gst_object_unref (appsrcs[i]);
+
+    if (res != GST_FLOW_OK) {
+      GST_WARNING_OBJECT (bin, "failed to push %u buffers to %u [ret:%s]",
+          len, i, gst_flow_get_name (res));
+      if (ret == GST_FLOW_OK)
+        ret = res;
+      continue;
+    }
+
+    GST_LOG_OBJECT (bin, "pushed %u buffers to %u", len, i);
+  }
+  g_free (appsrcs);
 
   return ret;
 }
 
+/**
+ * gst_dyn_appsrc_set_watermarks:
+ * @dynappsrc: a #GstDynAppSrc
+ * @index: index of the appsrc
+ * @low_bytes: level in bytes to start wanting data again
+ * @high_bytes: level in bytes to stop wanting data, 0 for no limit
+ * @low_time: level in time to start wanting data again
+ * @high_time: level in time to stop wanting data, 0 for no limit
+ *
+ * Set the watermarks used to compute the need-data mask for a source.
+ *
+ * Returns: TRUE if @index is a valid source.
+ */
+gboolean
+gst_dyn_appsrc_set_watermarks (GstDynAppSrc * bin, guint index,
+    guint64 low_bytes, guint64 high_bytes, guint64 low_time, guint64 high_time)
+{
+  GstAppSourceGroup *appsrc_group;
+
+  GST_OBJECT_LOCK (bin);
+  appsrc_group = g_list_nth_data (bin->appsrc_list, index);
+  if (appsrc_group) {
+    appsrc_group->low_bytes = MIN (low_bytes, high_bytes);
+    appsrc_group->high_bytes = high_bytes;
+    appsrc_group->low_time = MIN (low_time, high_time);
+    appsrc_group->high_time = high_time;
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  if (!appsrc_group) {
+    GST_WARNING_OBJECT (bin, "no appsrc with index %u", index);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (bin, "watermarks of %u: bytes %" G_GUINT64_FORMAT "-%"
+      G_GUINT64_FORMAT ", time %" GST_TIME_FORMAT "-%" GST_TIME_FORMAT, index,
+      low_bytes, high_bytes, GST_TIME_ARGS (low_time),
+      GST_TIME_ARGS (high_time));
+
+  update_need_data (bin);
+
+  return TRUE;
+}
+
+static gpointer
+replay_thread_func (GstDynAppSrc * bin)
+{
+  GstDynAppSrcRecord record;
+  GstClockTime first_arrival = GST_CLOCK_TIME_NONE;
+  gint64 start = g_get_monotonic_time ();
+
+  GST_DEBUG_OBJECT (bin, "replay started");
+
+  while (gst_dyn_appsrc_replay_next (bin->replay, &record)) {
+    GstFlowReturn ret = GST_FLOW_OK;
+    GstElement *appsrc;
+
+    g_mutex_lock (&bin->replay_lock);
+    if (bin->replay_sync) {
+      gint64 deadline;
+
+      if (!GST_CLOCK_TIME_IS_VALID (first_arrival))
+        first_arrival = record.arrival;
+      deadline = start + (record.arrival - first_arrival) / GST_USECOND;
+
+      while (!bin->replay_stop) {
+        if (!g_cond_wait_until (&bin->replay_cond, &bin->replay_lock,
+                deadline))
+          break;
+      }
+    }
+    if (bin->replay_stop) {
+      g_mutex_unlock (&bin->replay_lock);
+      break;
+    }
+    g_mutex_unlock (&bin->replay_lock);
+
+    appsrc = get_appsrc_by_id (bin, record.source);
+    if (!appsrc)
+      continue;
+
+    switch (record.type) {
+      case GST_DYN_APPSRC_RECORD_CAPS:
+      {
+        GstCaps *caps = gst_dyn_appsrc_replay_get_caps (&record);
+
+        if (caps) {
+          g_object_set (appsrc, "caps", caps, NULL);
+          gst_caps_unref (caps);
+        }
+        break;
+      }
+      case GST_DYN_APPSRC_RECORD_SEGMENT:
+      {
+        GstSegment segment;
+
+        /* appsrc creates its own segment, the captured one is only logged */
+        if (gst_dyn_appsrc_replay_get_segment (&record, &segment))
+          GST_DEBUG_OBJECT (appsrc, "captured segment %" GST_SEGMENT_FORMAT,
+              &segment);
+        break;
+      }
+      case GST_DYN_APPSRC_RECORD_BUFFER:
+      {
+        GstBuffer *buffer = gst_dyn_appsrc_replay_get_buffer (bin->replay,
+            &record);
+
+        feed_push (bin, appsrc, gst_buffer_get_size (buffer),
+            BUFFER_TIME (buffer));
+        g_signal_emit_by_name (appsrc, "push-buffer", buffer, &ret);
+        gst_buffer_unref (buffer);
+        break;
+      }
+      case GST_DYN_APPSRC_RECORD_EOS:
+        g_signal_emit_by_name (appsrc, "end-of-stream", &ret);
+        break;
+      default:
+        GST_WARNING_OBJECT (bin, "unknown record type %d", record.type);
+        break;
+    }
+    gst_object_unref (appsrc);
+
+    if (ret == GST_FLOW_FLUSHING)
+      break;
+  }
+
+  GST_DEBUG_OBJECT (bin, "replay stopped");
+
+  return NULL;
+}
+
+/* create the sources of the capture file, they are fed once dynappsrc is
+ * PAUSED */
+static gboolean
+setup_replay (GstDynAppSrc * bin)
+{
+  GError *err = NULL;
+  GList *created = NULL, *item;
+  guint i, n_sources;
+
+  bin->replay = gst_dyn_appsrc_replay_new (bin->replay_location, &err);
+  if (!bin->replay) {
+    GST_ELEMENT_ERROR (bin, RESOURCE, OPEN_READ, (NULL),
+        ("%s", err->message));
+    g_error_free (err);
+    return FALSE;
+  }
+
+  /* sources get their ids in order, so source i of the capture is fed to
+   * the i-th appsrc created here. Sources that were removed while capturing
+   * get an appsrc as well and end with the EOS recorded on removal. */
+  n_sources = gst_dyn_appsrc_replay_get_n_sources (bin->replay);
+  for (i = 0; i < n_sources; i++) {
+    GstElement *appsrc = NULL;
+    GstFormat format;
+
+    g_signal_emit (bin, gst_dyn_appsrc_signals[SIGNAL_NEW_APPSRC], 0, NULL,
+        &appsrc);
+    if (!appsrc)
+      goto new_appsrc_failed;
+    created = g_list_prepend (created, appsrc);
+
+    /* push-buffer blocks when downstream doesn't keep up */
+    g_object_set (appsrc, "block", TRUE, NULL);
+
+    /* the captured appsrc produced segments in this format */
+    format = gst_dyn_appsrc_replay_get_format (bin->replay, i);
+    if (format != GST_FORMAT_UNDEFINED)
+      g_object_set (appsrc, "format", format, NULL);
+  }
+  g_list_free (created);
+
+  return TRUE;
+
+new_appsrc_failed:
+  {
+    GST_WARNING_OBJECT (bin, "failed to create source %u of the capture", i);
+    for (item = created; item; item = g_list_next (item))
+      gst_dyn_appsrc_remove_appsrc (bin, item->data);
+    g_list_free (created);
+    return FALSE;
+  }
+}
+
+static void
+stop_replay (GstDynAppSrc * bin)
+{
+  if (bin->replay_thread) {
+    g_thread_join (bin->replay_thread);
+    bin->replay_thread = NULL;
+  }
+
+  if (bin->replay) {
+    gst_dyn_appsrc_replay_free (bin->replay);
+    bin->replay = NULL;
+  }
+}
+
 static GstStateChangeReturn
 gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
 {
@@ -617,9 +2179,34 @@ gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (bin->record_location) {
+        GError *err = NULL;
+
+        bin->recorder = gst_dyn_appsrc_recorder_new (bin->record_location,
+            &err);
+        if (!bin->recorder) {
+          GST_ELEMENT_WARNING (bin, RESOURCE, OPEN_WRITE, (NULL),
+              ("%s", err->message));
+          g_error_free (err);
+        }
+      }
+
+      if (bin->replay_location && !setup_replay (bin)) {
+        stop_replay (bin);
+        return GST_STATE_CHANGE_FAILURE;
+      }
+
       if (!setup_source (bin))
         return GST_STATE_CHANGE_FAILURE;
       break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* appsrc elements are flushing after this, which unblocks a replay
+       * thread waiting in push-buffer */
+      g_mutex_lock (&bin->replay_lock);
+      bin->replay_stop = TRUE;
+      g_cond_signal (&bin->replay_cond);
+      g_mutex_unlock (&bin->replay_lock);
+      break;
     default:
       break;
   }
@@ -631,9 +2218,20 @@ gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
       GST_DEBUG_OBJECT (bin, "ready to paused");
       if (ret == GST_STATE_CHANGE_FAILURE)
         goto setup_failed;
+
+      if (bin->replay) {
+        bin->replay_stop = FALSE;
+        bin->replay_thread = g_thread_new ("dynappsrc-replay",
+            (GThreadFunc) replay_thread_func, bin);
+      }
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       GST_DEBUG_OBJECT (bin, "paused to ready");
+      stop_replay (bin);
+      if (bin->recorder) {
+        gst_dyn_appsrc_recorder_free (bin->recorder);
+        bin->recorder = NULL;
+      }
       remove_source (bin);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
@@ -648,6 +2246,11 @@ gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
 setup_failed:
   {
     /* clean up leftover groups */
+    stop_replay (bin);
+    if (bin->recorder) {
+      gst_dyn_appsrc_recorder_free (bin->recorder);
+      bin->recorder = NULL;
+    }
     return GST_STATE_CHANGE_FAILURE;
   }
 }
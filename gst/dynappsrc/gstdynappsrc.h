@@ -23,6 +23,8 @@
 
 #include <gst/gst.h>
 
+#include "gstdynappsrcrecord.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_DYN_APPSRC (gst_dyn_appsrc_get_type())
@@ -50,6 +52,10 @@ struct _GstDynAppSrc
   GList *appsrc_list;
 
   gint n_source;
+  /* id of the next source, it names the pad and the source in captures */
+  guint next_source_id;
+  /* the sources are exposed, new sources get their pad right away */
+  gboolean exposed;
 
   GstStructure *smart_prop;
 
@@ -57,6 +63,38 @@ struct _GstDynAppSrc
   GstSegment segment;
   GstEvent *segment_event;
   gdouble rate;
+
+  /* unwrap 33-bit MPEG timestamps of every source */
+  gboolean unwrap_timestamps;
+
+  /* recycled buffer shells for wrapped application memory */
+  GstBufferPool *pool;
+
+  /* seek fan-out, a seek is applied once per seqnum */
+  GThreadPool *seek_pool;
+  gboolean have_seek_seqnum;
+  guint32 seek_seqnum;
+  gboolean seek_result;
+  /* a copy of the running seek waits for its result */
+  gboolean seek_running;
+  GThread *seek_thread;
+  GCond seek_cond;
+
+  /* bit n is set while the source with index n wants data */
+  guint64 need_data_mask;
+  guint64 need_data_emitted;
+  gboolean need_data_emitting;
+
+  /* capture and replay of the feeds */
+  gchar *record_location;
+  GstDynAppSrcRecorder *recorder;
+  gchar *replay_location;
+  gboolean replay_sync;
+  GstDynAppSrcReplay *replay;
+  GThread *replay_thread;
+  GMutex replay_lock;
+  GCond replay_cond;
+  gboolean replay_stop;
 };
 
 struct _GstDynAppSrcClass
@@ -66,19 +104,76 @@ struct _GstDynAppSrcClass
   /* create a appsrc element */
   GstElement *(*new_appsrc) (GstDynAppSrc * dynappsrc, const gchar * name);
 
+  /* signals */
+  void (*memory_released) (GstDynAppSrc * dynappsrc, GstElement * appsrc,
+      gpointer user_data);
+  gboolean (*seek_data) (GstDynAppSrc * dynappsrc, GArray * offsets);
+  void (*need_data) (GstDynAppSrc * dynappsrc, guint64 mask);
+
   /* actions */
+    gboolean (*remove_appsrc) (GstDynAppSrc * dynappsrc, GstElement * appsrc);
     GstFlowReturn (*end_of_stream) (GstDynAppSrc * dynappsrc);
+    GstFlowReturn (*push_memory) (GstDynAppSrc * dynappsrc, guint index,
+      gpointer data, guint64 size, guint64 pts, guint64 dts,
+      gpointer user_data);
+    GstFlowReturn (*push_fd) (GstDynAppSrc * dynappsrc, guint index, gint fd,
+      guint64 offset, guint64 size, guint64 pts, guint64 dts,
+      gpointer user_data);
+    GstFlowReturn (*push_buffer_lists) (GstDynAppSrc * dynappsrc,
+      GPtrArray * lists);
+    gboolean (*set_watermarks) (GstDynAppSrc * dynappsrc, guint index,
+      guint64 low_bytes, guint64 high_bytes, guint64 low_time,
+      guint64 high_time);
 };
 
 struct _GstAppSourceGroup
 {
   GstElement *appsrc;
   GstPad *srcpad;
+  /* stays the same when other sources are removed */
+  guint id;
+  gulong record_probe;
+  gulong feed_probe;
+  gulong unwrap_probe;
+
+  /* offset of the last seek-data of the appsrc, protected by the object
+   * lock of dynappsrc */
+  gboolean seek_data_pending;
+  guint64 seek_data_offset;
+
+  /* timestamp unwrapping state, only used from the streaming thread */
+  GstClockTime last_pts;
+  GstClockTime last_dts;
+  GstClockTime pts_wrap_offset;
+  GstClockTime dts_wrap_offset;
+
+  /* feed control, a watermark of 0 is not used */
+  guint64 low_bytes;
+  guint64 high_bytes;
+  GstClockTime low_time;
+  GstClockTime high_time;
+  guint64 level_bytes;
+  GstClockTime in_time;
+  GstClockTime out_time;
+  gboolean need_data;
 };
 
 GType gst_dyn_appsrc_get_type (void);
 
+gboolean gst_dyn_appsrc_remove_appsrc (GstDynAppSrc * dynappsrc,
+    GstElement * appsrc);
 GstFlowReturn gst_dyn_appsrc_end_of_stream (GstDynAppSrc * dynappsrc);
+GstFlowReturn gst_dyn_appsrc_push_memory (GstDynAppSrc * dynappsrc,
+    guint index, gpointer data, guint64 size, guint64 pts, guint64 dts,
+    gpointer user_data);
+GstFlowReturn gst_dyn_appsrc_push_fd (GstDynAppSrc * dynappsrc, guint index,
+    gint fd, guint64 offset, guint64 size, guint64 pts, guint64 dts,
+    gpointer user_data);
+GstFlowReturn gst_dyn_appsrc_push_buffer_lists (GstDynAppSrc * dynappsrc,
+    GPtrArray * lists);
+gboolean gst_dyn_appsrc_set_watermarks (GstDynAppSrc * dynappsrc, guint index,
+    guint64 low_bytes, guint64 high_bytes, guint64 low_time,
+    guint64 high_time);
 
 G_END_DECLS
 #endif /* __GST_DYN_APPSRC_H__ */
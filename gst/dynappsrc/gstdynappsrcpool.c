@@ -0,0 +1,97 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *  Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gstdynappsrcpool.h"
+
+GST_DEBUG_CATEGORY_STATIC (dyn_appsrc_pool_debug);
+#define GST_CAT_DEFAULT dyn_appsrc_pool_debug
+
+#define parent_class gst_dyn_appsrc_pool_parent_class
+
+G_DEFINE_TYPE (GstDynAppSrcPool, gst_dyn_appsrc_pool, GST_TYPE_BUFFER_POOL);
+
+static GstFlowReturn
+gst_dyn_appsrc_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  /* memory is appended by the caller */
+  *buffer = gst_buffer_new ();
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_dyn_appsrc_pool_reset_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  /* release the wrapped memory, the application gets notified from the
+   * memory destroy notify */
+  gst_buffer_remove_all_memory (buffer);
+  GST_MINI_OBJECT_FLAG_UNSET (buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+
+  GST_BUFFER_POOL_CLASS (parent_class)->reset_buffer (pool, buffer);
+}
+
+static void
+gst_dyn_appsrc_pool_class_init (GstDynAppSrcPoolClass * klass)
+{
+  GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS (klass);
+
+  pool_class->alloc_buffer = gst_dyn_appsrc_pool_alloc_buffer;
+  pool_class->reset_buffer = gst_dyn_appsrc_pool_reset_buffer;
+
+  GST_DEBUG_CATEGORY_INIT (dyn_appsrc_pool_debug, "dynappsrcpool", 0,
+      "Dynamic App Source buffer pool");
+}
+
+static void
+gst_dyn_appsrc_pool_init (GstDynAppSrcPool * pool)
+{
+}
+
+/**
+ * gst_dyn_appsrc_pool_new:
+ *
+ * Create an unbounded and active pool of memory-less buffers.
+ *
+ * Returns: (transfer full): a new #GstBufferPool
+ */
+GstBufferPool *
+gst_dyn_appsrc_pool_new (void)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = g_object_new (GST_TYPE_DYN_APPSRC_POOL, NULL);
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, 0, 0, 0);
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (pool, "failed to activate buffer pool");
+    gst_object_unref (pool);
+    return NULL;
+  }
+
+  return pool;
+}
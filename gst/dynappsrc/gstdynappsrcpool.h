@@ -0,0 +1,57 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *  Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DYN_APPSRC_POOL_H__
+#define __GST_DYN_APPSRC_POOL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_DYN_APPSRC_POOL (gst_dyn_appsrc_pool_get_type())
+#define GST_DYN_APPSRC_POOL(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_DYN_APPSRC_POOL,GstDynAppSrcPool))
+#define GST_IS_DYN_APPSRC_POOL(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_DYN_APPSRC_POOL))
+
+typedef struct _GstDynAppSrcPool      GstDynAppSrcPool;
+typedef struct _GstDynAppSrcPoolClass GstDynAppSrcPoolClass;
+
+/**
+ * GstDynAppSrcPool:
+ *
+ * Pool of memory-less buffers which are used to wrap application-owned
+ * memory. The wrapped memory is dropped when a buffer returns to the pool,
+ * so only the buffer shells are recycled.
+ */
+struct _GstDynAppSrcPool
+{
+  GstBufferPool parent;
+};
+
+struct _GstDynAppSrcPoolClass
+{
+  GstBufferPoolClass parent_class;
+};
+
+GType gst_dyn_appsrc_pool_get_type (void);
+
+GstBufferPool *gst_dyn_appsrc_pool_new (void);
+
+G_END_DECLS
+#endif /* __GST_DYN_APPSRC_POOL_H__ */
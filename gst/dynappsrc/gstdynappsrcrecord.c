@@ -0,0 +1,555 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *  Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * A capture file starts with a 16 bytes header, the magic "DYNAPREC" and a
+ * 32 bit version. Records follow in the order they were captured, each one
+ * is a fixed size RecordHeader and a payload padded to 8 bytes, so every
+ * payload can be used in place from the mapped file. All of values are
+ * written in host byte order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gstdynappsrcrecord.h"
+
+GST_DEBUG_CATEGORY_STATIC (dyn_appsrc_record_debug);
+#define GST_CAT_DEFAULT dyn_appsrc_record_debug
+
+#define RECORD_MAGIC "DYNAPREC"
+#define RECORD_MAGIC_SIZE 8
+#define RECORD_VERSION 1
+#define RECORD_FILE_HEADER_SIZE 16
+#define RECORD_PAD(size) (((size) + 7) & ~((gsize) 7))
+
+/* replay creates an appsrc for every source id up to the highest one */
+#define RECORD_MAX_SOURCES 1024
+
+/* flags which describe the memory of the captured buffer, not its data */
+#define RECORD_FLAGS_MASK \
+    (~((guint) GST_MINI_OBJECT_FLAG_LAST - 1) & ~GST_BUFFER_FLAG_TAG_MEMORY)
+
+typedef struct
+{
+  guint32 type;
+  guint32 source;
+  guint64 arrival;
+  guint64 pts;
+  guint64 dts;
+  guint64 duration;
+  guint32 flags;
+  guint32 size;
+} RecordHeader;
+
+typedef struct
+{
+  gdouble rate;
+  gdouble applied_rate;
+  guint32 format;
+  guint32 flags;
+  guint64 base;
+  guint64 start;
+  guint64 stop;
+  guint64 time;
+  guint64 position;
+  guint64 duration;
+} RecordSegment;
+
+struct _GstDynAppSrcRecorder
+{
+  GMutex lock;
+  FILE *file;
+  gchar *location;
+  gint64 start;
+  gboolean failed;
+};
+
+struct _GstDynAppSrcReplay
+{
+  GMappedFile *file;
+  const guint8 *data;
+  gsize size;
+  gsize offset;
+  guint n_sources;
+  /* format of the first segment of each source */
+  GstFormat *formats;
+};
+
+static void
+init_debug (void)
+{
+  static gsize done = 0;
+
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (dyn_appsrc_record_debug, "dynappsrcrecord", 0,
+        "Dynamic App Source capture and replay");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+/**
+ * gst_dyn_appsrc_recorder_new:
+ * @location: path of the capture file, an existing file is overwritten
+ * @error: return location for a #GError
+ *
+ * Returns: a new #GstDynAppSrcRecorder or NULL if @location couldn't be
+ * opened.
+ */
+GstDynAppSrcRecorder *
+gst_dyn_appsrc_recorder_new (const gchar * location, GError ** error)
+{
+  GstDynAppSrcRecorder *recorder;
+  guint8 header[RECORD_FILE_HEADER_SIZE] = { 0, };
+  guint32 version = RECORD_VERSION;
+  FILE *file;
+
+  init_debug ();
+
+  file = fopen (location, "wb");
+  if (!file) {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_WRITE,
+        "Could not open \"%s\" for writing: %s", location, g_strerror (errno));
+    return NULL;
+  }
+
+  memcpy (header, RECORD_MAGIC, RECORD_MAGIC_SIZE);
+  memcpy (header + RECORD_MAGIC_SIZE, &version, sizeof (version));
+  if (fwrite (header, sizeof (header), 1, file) != 1) {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_WRITE,
+        "Could not write to \"%s\": %s", location, g_strerror (errno));
+    fclose (file);
+    return NULL;
+  }
+
+  recorder = g_new0 (GstDynAppSrcRecorder, 1);
+  g_mutex_init (&recorder->lock);
+  recorder->file = file;
+  recorder->location = g_strdup (location);
+  recorder->start = g_get_monotonic_time ();
+
+  GST_INFO ("capturing dynappsrc feeds to %s", location);
+
+  return recorder;
+}
+
+static void
+write_record (GstDynAppSrcRecorder * recorder, GstDynAppSrcRecordType type,
+    guint source, GstBuffer * buffer, gconstpointer data, gsize size)
+{
+  static const guint8 padding[8] = { 0, };
+  RecordHeader header = { 0, };
+  gsize padded = RECORD_PAD (size);
+
+  if (source >= RECORD_MAX_SOURCES) {
+    GST_WARNING ("source %u can't be captured, only %u are", source,
+        RECORD_MAX_SOURCES);
+    return;
+  }
+
+  header.type = type;
+  header.source = source;
+  header.pts = header.dts = header.duration = GST_CLOCK_TIME_NONE;
+  header.size = size;
+
+  if (buffer) {
+    header.pts = GST_BUFFER_PTS (buffer);
+    header.dts = GST_BUFFER_DTS (buffer);
+    header.duration = GST_BUFFER_DURATION (buffer);
+    header.flags = GST_BUFFER_FLAGS (buffer) & RECORD_FLAGS_MASK;
+  }
+
+  g_mutex_lock (&recorder->lock);
+  if (recorder->failed)
+    goto done;
+
+  header.arrival = (g_get_monotonic_time () - recorder->start) * GST_USECOND;
+
+  if (fwrite (&header, sizeof (header), 1, recorder->file) != 1
+      || (size > 0 && fwrite (data, size, 1, recorder->file) != 1)
+      || (padded > size
+          && fwrite (padding, padded - size, 1, recorder->file) != 1)) {
+    GST_WARNING ("failed to write to %s: %s, stop capturing",
+        recorder->location, g_strerror (errno));
+    recorder->failed = TRUE;
+  }
+
+done:
+  g_mutex_unlock (&recorder->lock);
+}
+
+/**
+ * gst_dyn_appsrc_recorder_write_buffer:
+ * @recorder: a #GstDynAppSrcRecorder
+ * @source: id of the source
+ * @buffer: a #GstBuffer coming out of the source
+ *
+ * Append the data and timing of @buffer to the capture file.
+ */
+void
+gst_dyn_appsrc_recorder_write_buffer (GstDynAppSrcRecorder * recorder,
+    guint source, GstBuffer * buffer)
+{
+  GstMapInfo map;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_WARNING ("failed to map buffer of source %u", source);
+    return;
+  }
+
+  write_record (recorder, GST_DYN_APPSRC_RECORD_BUFFER, source, buffer,
+      map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+}
+
+/**
+ * gst_dyn_appsrc_recorder_write_event:
+ * @recorder: a #GstDynAppSrcRecorder
+ * @source: id of the source
+ * @event: a #GstEvent coming out of the source
+ *
+ * Append @event to the capture file if it is a caps, segment or EOS event.
+ * Other events are ignored.
+ */
+void
+gst_dyn_appsrc_recorder_write_event (GstDynAppSrcRecorder * recorder,
+    guint source, GstEvent * event)
+{
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps;
+      gchar *str;
+
+      gst_event_parse_caps (event, &caps);
+      str = gst_caps_to_string (caps);
+      write_record (recorder, GST_DYN_APPSRC_RECORD_CAPS, source, NULL, str,
+          strlen (str) + 1);
+      g_free (str);
+      break;
+    }
+    case GST_EVENT_SEGMENT:
+    {
+      const GstSegment *segment;
+      RecordSegment s;
+
+      gst_event_parse_segment (event, &segment);
+      s.rate = segment->rate;
+      s.applied_rate = segment->applied_rate;
+      s.format = segment->format;
+      s.flags = segment->flags;
+      s.base = segment->base;
+      s.start = segment->start;
+      s.stop = segment->stop;
+      s.time = segment->time;
+      s.position = segment->position;
+      s.duration = segment->duration;
+      write_record (recorder, GST_DYN_APPSRC_RECORD_SEGMENT, source, NULL, &s,
+          sizeof (s));
+      break;
+    }
+    case GST_EVENT_EOS:
+      write_record (recorder, GST_DYN_APPSRC_RECORD_EOS, source, NULL, NULL, 0);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * gst_dyn_appsrc_recorder_free:
+ * @recorder: a #GstDynAppSrcRecorder
+ *
+ * Flush and close the capture file.
+ */
+void
+gst_dyn_appsrc_recorder_free (GstDynAppSrcRecorder * recorder)
+{
+  fclose (recorder->file);
+  g_mutex_clear (&recorder->lock);
+  g_free (recorder->location);
+  g_free (recorder);
+}
+
+/* reads the record at @offset, returns the offset of the next record or 0
+ * when there is no complete record left */
+static gsize
+read_record (const guint8 * data, gsize size, gsize offset,
+    GstDynAppSrcRecord * record)
+{
+  RecordHeader header;
+
+  if (size - offset < sizeof (header))
+    return 0;
+  memcpy (&header, data + offset, sizeof (header));
+  offset += sizeof (header);
+
+  /* a capture that was interrupted may end with a partial record */
+  if (size - offset < header.size)
+    return 0;
+
+  record->type = header.type;
+  record->source = header.source;
+  record->arrival = header.arrival;
+  record->pts = header.pts;
+  record->dts = header.dts;
+  record->duration = header.duration;
+  record->flags = header.flags;
+  record->data = data + offset;
+  record->size = header.size;
+
+  return MIN (offset + RECORD_PAD (header.size), size);
+}
+
+/**
+ * gst_dyn_appsrc_replay_new:
+ * @location: path of a capture file
+ * @error: return location for a #GError
+ *
+ * Map a capture file written by #GstDynAppSrcRecorder.
+ *
+ * Returns: a new #GstDynAppSrcReplay or NULL if @location is not a valid
+ * capture file.
+ */
+GstDynAppSrcReplay *
+gst_dyn_appsrc_replay_new (const gchar * location, GError ** error)
+{
+  GstDynAppSrcReplay *replay;
+  GstDynAppSrcRecord record;
+  GMappedFile *file;
+  const guint8 *data;
+  gsize size, offset;
+  guint32 version;
+  guint n_sources = 0;
+
+  init_debug ();
+
+  file = g_mapped_file_new (location, FALSE, error);
+  if (!file)
+    return NULL;
+
+  data = (const guint8 *) g_mapped_file_get_contents (file);
+  size = g_mapped_file_get_length (file);
+
+  if (size < RECORD_FILE_HEADER_SIZE
+      || memcmp (data, RECORD_MAGIC, RECORD_MAGIC_SIZE) != 0)
+    goto wrong_type;
+
+  memcpy (&version, data + RECORD_MAGIC_SIZE, sizeof (version));
+  if (version != RECORD_VERSION)
+    goto wrong_type;
+
+  for (offset = RECORD_FILE_HEADER_SIZE;
+      (offset = read_record (data, size, offset, &record));) {
+    if (record.source >= RECORD_MAX_SOURCES)
+      goto corrupted;
+    n_sources = MAX (n_sources, record.source + 1);
+  }
+
+  replay = g_new0 (GstDynAppSrcReplay, 1);
+  replay->file = file;
+  replay->data = data;
+  replay->size = size;
+  replay->offset = RECORD_FILE_HEADER_SIZE;
+  replay->n_sources = n_sources;
+  replay->formats = g_new0 (GstFormat, n_sources);
+
+  for (offset = RECORD_FILE_HEADER_SIZE;
+      (offset = read_record (data, size, offset, &record));) {
+    GstSegment segment;
+
+    if (record.type == GST_DYN_APPSRC_RECORD_SEGMENT
+        && replay->formats[record.source] == GST_FORMAT_UNDEFINED
+        && gst_dyn_appsrc_replay_get_segment (&record, &segment))
+      replay->formats[record.source] = segment.format;
+  }
+
+  GST_INFO ("replaying %u sources from %s", n_sources, location);
+
+  return replay;
+
+wrong_type:
+  {
+    g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_WRONG_TYPE,
+        "\"%s\" is not a dynappsrc capture file", location);
+    g_mapped_file_unref (file);
+    return NULL;
+  }
+corrupted:
+  {
+    g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_DECODE,
+        "\"%s\" has a record of source %u, source ids are below %u",
+        location, record.source, RECORD_MAX_SOURCES);
+    g_mapped_file_unref (file);
+    return NULL;
+  }
+}
+
+/**
+ * gst_dyn_appsrc_replay_get_n_sources:
+ * @replay: a #GstDynAppSrcReplay
+ *
+ * Returns: the number of sources in the capture file.
+ */
+guint
+gst_dyn_appsrc_replay_get_n_sources (GstDynAppSrcReplay * replay)
+{
+  return replay->n_sources;
+}
+
+/**
+ * gst_dyn_appsrc_replay_get_format:
+ * @replay: a #GstDynAppSrcReplay
+ * @source: id of a source
+ *
+ * Returns: the format of the first segment of @source, or
+ * #GST_FORMAT_UNDEFINED when the capture has no segment for it.
+ */
+GstFormat
+gst_dyn_appsrc_replay_get_format (GstDynAppSrcReplay * replay, guint source)
+{
+  if (source >= replay->n_sources)
+    return GST_FORMAT_UNDEFINED;
+
+  return replay->formats[source];
+}
+
+/**
+ * gst_dyn_appsrc_replay_next:
+ * @replay: a #GstDynAppSrcReplay
+ * @record: (out): the next record
+ *
+ * Returns: FALSE when all of records have been read.
+ */
+gboolean
+gst_dyn_appsrc_replay_next (GstDynAppSrcReplay * replay,
+    GstDynAppSrcRecord * record)
+{
+  gsize next;
+
+  next = read_record (replay->data, replay->size, replay->offset, record);
+  if (!next)
+    return FALSE;
+
+  replay->offset = next;
+  return TRUE;
+}
+
+/**
+ * gst_dyn_appsrc_replay_get_buffer:
+ * @replay: a #GstDynAppSrcReplay
+ * @record: a buffer record of @replay
+ *
+ * Returns: (transfer full): a #GstBuffer wrapping the data of @record in
+ * the mapped file, without copying it.
+ */
+GstBuffer *
+gst_dyn_appsrc_replay_get_buffer (GstDynAppSrcReplay * replay,
+    const GstDynAppSrcRecord * record)
+{
+  GstBuffer *buffer;
+
+  g_return_val_if_fail (record->type == GST_DYN_APPSRC_RECORD_BUFFER, NULL);
+
+  buffer = gst_buffer_new ();
+  if (record->size > 0)
+    gst_buffer_append_memory (buffer,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) record->data, record->size, 0, record->size,
+            g_mapped_file_ref (replay->file),
+            (GDestroyNotify) g_mapped_file_unref));
+
+  GST_BUFFER_PTS (buffer) = record->pts;
+  GST_BUFFER_DTS (buffer) = record->dts;
+  GST_BUFFER_DURATION (buffer) = record->duration;
+  GST_MINI_OBJECT_FLAG_SET (buffer, record->flags);
+
+  return buffer;
+}
+
+/**
+ * gst_dyn_appsrc_replay_get_caps:
+ * @record: a caps record
+ *
+ * Returns: (transfer full): the #GstCaps of @record or NULL
+ */
+GstCaps *
+gst_dyn_appsrc_replay_get_caps (const GstDynAppSrcRecord * record)
+{
+  g_return_val_if_fail (record->type == GST_DYN_APPSRC_RECORD_CAPS, NULL);
+
+  if (record->size == 0 || record->data[record->size - 1] != '\0')
+    return NULL;
+
+  return gst_caps_from_string ((const gchar *) record->data);
+}
+
+/**
+ * gst_dyn_appsrc_replay_get_segment:
+ * @record: a segment record
+ * @segment: (out): the segment of @record
+ *
+ * Returns: FALSE if @record is not a valid segment record.
+ */
+gboolean
+gst_dyn_appsrc_replay_get_segment (const GstDynAppSrcRecord * record,
+    GstSegment * segment)
+{
+  RecordSegment s;
+
+  g_return_val_if_fail (record->type == GST_DYN_APPSRC_RECORD_SEGMENT, FALSE);
+
+  if (record->size != sizeof (s))
+    return FALSE;
+  memcpy (&s, record->data, sizeof (s));
+
+  gst_segment_init (segment, s.format);
+  segment->rate = s.rate;
+  segment->applied_rate = s.applied_rate;
+  segment->flags = s.flags;
+  segment->base = s.base;
+  segment->start = s.start;
+  segment->stop = s.stop;
+  segment->time = s.time;
+  segment->position = s.position;
+  segment->duration = s.duration;
+
+  return TRUE;
+}
+
+/**
+ * gst_dyn_appsrc_replay_free:
+ * @replay: a #GstDynAppSrcReplay
+ *
+ * Release @replay. The file stays mapped until the buffers of @replay are
+ * freed.
+ */
+void
+gst_dyn_appsrc_replay_free (GstDynAppSrcReplay * replay)
+{
+  g_mapped_file_unref (replay->file);
+  g_free (replay->formats);
+  g_free (replay);
+}
@@ -0,0 +1,100 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *  Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DYN_APPSRC_RECORD_H__
+#define __GST_DYN_APPSRC_RECORD_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstDynAppSrcRecorder GstDynAppSrcRecorder;
+typedef struct _GstDynAppSrcReplay   GstDynAppSrcReplay;
+typedef struct _GstDynAppSrcRecord   GstDynAppSrcRecord;
+
+/**
+ * GstDynAppSrcRecordType:
+ * @GST_DYN_APPSRC_RECORD_CAPS: caps of the source, the payload is the caps
+ *     string
+ * @GST_DYN_APPSRC_RECORD_SEGMENT: segment of the source
+ * @GST_DYN_APPSRC_RECORD_BUFFER: a buffer, the payload is its data
+ * @GST_DYN_APPSRC_RECORD_EOS: end of stream of the source
+ *
+ * Type of a record in a dynappsrc capture file.
+ */
+typedef enum
+{
+  GST_DYN_APPSRC_RECORD_CAPS = 1,
+  GST_DYN_APPSRC_RECORD_SEGMENT,
+  GST_DYN_APPSRC_RECORD_BUFFER,
+  GST_DYN_APPSRC_RECORD_EOS
+} GstDynAppSrcRecordType;
+
+/**
+ * GstDynAppSrcRecord:
+ * @type: a #GstDynAppSrcRecordType
+ * @source: id of the source
+ * @arrival: time since the capture started when the record was written
+ * @pts: presentation timestamp of a buffer
+ * @dts: decoding timestamp of a buffer
+ * @duration: duration of a buffer
+ * @flags: flags of a buffer
+ * @data: payload, points into the mapped capture file
+ * @size: size of @data
+ *
+ * A record read from a capture file.
+ */
+struct _GstDynAppSrcRecord
+{
+  GstDynAppSrcRecordType type;
+  guint source;
+  GstClockTime arrival;
+  GstClockTime pts;
+  GstClockTime dts;
+  GstClockTime duration;
+  guint flags;
+  const guint8 *data;
+  gsize size;
+};
+
+GstDynAppSrcRecorder *gst_dyn_appsrc_recorder_new (const gchar * location,
+    GError ** error);
+void gst_dyn_appsrc_recorder_write_buffer (GstDynAppSrcRecorder * recorder,
+    guint source, GstBuffer * buffer);
+void gst_dyn_appsrc_recorder_write_event (GstDynAppSrcRecorder * recorder,
+    guint source, GstEvent * event);
+void gst_dyn_appsrc_recorder_free (GstDynAppSrcRecorder * recorder);
+
+GstDynAppSrcReplay *gst_dyn_appsrc_replay_new (const gchar * location,
+    GError ** error);
+guint gst_dyn_appsrc_replay_get_n_sources (GstDynAppSrcReplay * replay);
+GstFormat gst_dyn_appsrc_replay_get_format (GstDynAppSrcReplay * replay,
+    guint source);
+gboolean gst_dyn_appsrc_replay_next (GstDynAppSrcReplay * replay,
+    GstDynAppSrcRecord * record);
+GstBuffer *gst_dyn_appsrc_replay_get_buffer (GstDynAppSrcReplay * replay,
+    const GstDynAppSrcRecord * record);
+GstCaps *gst_dyn_appsrc_replay_get_caps (const GstDynAppSrcRecord * record);
+gboolean gst_dyn_appsrc_replay_get_segment (const GstDynAppSrcRecord * record,
+    GstSegment * segment);
+void gst_dyn_appsrc_replay_free (GstDynAppSrcReplay * replay);
+
+G_END_DECLS
+#endif /* __GST_DYN_APPSRC_RECORD_H__ */
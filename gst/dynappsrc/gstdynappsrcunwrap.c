@@ -0,0 +1,93 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *  Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gstdynappsrcunwrap.h"
+
+/**
+ * gst_dyn_appsrc_unwrap_timestamp:
+ * @ts: a timestamp on the 33-bit MPEG clock
+ * @last: the last timestamp seen, updated
+ * @offset: the offset added for the wraparounds so far, updated
+ *
+ * A jump back of more than half the wrap period is a wraparound, a jump
+ * forward of more than half of it is a late timestamp from before the
+ * last wraparound.
+ *
+ * Returns: @ts on a clock which doesn't wrap.
+ */
+GstClockTime
+gst_dyn_appsrc_unwrap_timestamp (GstClockTime ts, GstClockTime * last,
+    GstClockTime * offset)
+{
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    return ts;
+
+  if (GST_CLOCK_TIME_IS_VALID (*last)) {
+    if (ts + GST_DYN_APPSRC_WRAP_TIME / 2 < *last) {
+      *offset += GST_DYN_APPSRC_WRAP_TIME;
+    } else if (ts > *last + GST_DYN_APPSRC_WRAP_TIME / 2
+        && *offset >= GST_DYN_APPSRC_WRAP_TIME) {
+      return ts + *offset - GST_DYN_APPSRC_WRAP_TIME;
+    }
+  }
+  *last = ts;
+
+  return ts + *offset;
+}
+
+/**
+ * gst_dyn_appsrc_unwrap_segment:
+ * @segment: a #GstSegment in #GST_FORMAT_TIME
+ * @last: the last presentation timestamp seen
+ * @offset: the offset added to the presentation timestamps so far
+ *
+ * Moves the start, stop and position of @segment by the same amount as its
+ * start is moved when unwrapped after @last, the stream time is kept. A
+ * segment following a wraparound is unwrapped like the buffers after it,
+ * the unwrap state itself is left to those buffers.
+ *
+ * Returns: TRUE if @segment was changed.
+ */
+gboolean
+gst_dyn_appsrc_unwrap_segment (GstSegment * segment, GstClockTime last,
+    GstClockTime offset)
+{
+  GstClockTime start, delta;
+
+  g_return_val_if_fail (segment->format == GST_FORMAT_TIME, FALSE);
+
+  start = gst_dyn_appsrc_unwrap_timestamp (segment->start, &last, &offset);
+  if (start == segment->start)
+    return FALSE;
+
+  delta = start - segment->start;
+  segment->start = start;
+  if (GST_CLOCK_TIME_IS_VALID (segment->stop))
+    segment->stop += delta;
+  if (GST_CLOCK_TIME_IS_VALID (segment->position))
+    segment->position += delta;
+
+  return TRUE;
+}
@@ -0,0 +1,41 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *  Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_DYN_APPSRC_UNWRAP_H__
+#define __GST_DYN_APPSRC_UNWRAP_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* the 33-bit MPEG clock wraps around after about 26.5 hours */
+#define GST_DYN_APPSRC_WRAP_TIME ((((guint64) 1) << 33) * 100000 / 9)
+
+G_GNUC_INTERNAL
+GstClockTime gst_dyn_appsrc_unwrap_timestamp (GstClockTime ts,
+    GstClockTime * last, GstClockTime * offset);
+
+G_GNUC_INTERNAL
+gboolean gst_dyn_appsrc_unwrap_segment (GstSegment * segment,
+    GstClockTime last, GstClockTime offset);
+
+G_END_DECLS
+#endif /* __GST_DYN_APPSRC_UNWRAP_H__ */
@@ -0,0 +1,375 @@
+/* GStreamer httpextbin element
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *  Author : HoonHee Lee <hoonhee.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-httpcachereader
+ *
+ * httpcachereader sits between the cache (a queue2 in ring buffer mode)
+ * and the filter element of httpextbin. queue2 only serves the ranges it
+ * keeps to a peer which pulls, so httpcachereader pulls from the cache in
+ * its own task and pushes downstream. Byte seeks from downstream restart
+ * the task at the new offset, a range still in the cache is read from it
+ * and queue2 requests the other ones from the source.
+ *
+ * Downstream may pull through httpcachereader as well, no task runs then.
+ * Upstream which can't be pulled from is pushed through as is.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gsthttpcachereader.h"
+
+GST_DEBUG_CATEGORY_STATIC (http_cache_reader_debug);
+#define GST_CAT_DEFAULT http_cache_reader_debug
+
+#define parent_class gst_http_cache_reader_parent_class
+
+/* bytes pulled from the cache at once, the same as basesrc pushes */
+#define BLOCK_SIZE 4096
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static gboolean gst_http_cache_reader_sink_activate (GstPad * pad,
+    GstObject * parent);
+static gboolean gst_http_cache_reader_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static GstFlowReturn gst_http_cache_reader_chain (GstPad * pad,
+    GstObject * parent, GstBuffer * buffer);
+static gboolean gst_http_cache_reader_src_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static GstFlowReturn gst_http_cache_reader_getrange (GstPad * pad,
+    GstObject * parent, guint64 offset, guint length, GstBuffer ** buffer);
+static gboolean gst_http_cache_reader_src_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static gboolean gst_http_cache_reader_src_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+static void gst_http_cache_reader_loop (GstHttpCacheReader * reader);
+
+G_DEFINE_TYPE (GstHttpCacheReader, gst_http_cache_reader, GST_TYPE_ELEMENT);
+
+static void
+gst_http_cache_reader_class_init (GstHttpCacheReaderClass * klass)
+{
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "HTTP Cache Reader", "Generic",
+      "Push from the cache of httpextbin and serve seeks from it",
+      "HoonHee Lee <hoonhee.lee@lge.com>");
+
+  GST_DEBUG_CATEGORY_INIT (http_cache_reader_debug, "httpcachereader", 0,
+      "HTTP Cache Reader");
+}
+
+static void
+gst_http_cache_reader_init (GstHttpCacheReader * reader)
+{
+  reader->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_activate_function (reader->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_http_cache_reader_sink_activate));
+  gst_pad_set_activatemode_function (reader->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_http_cache_reader_sink_activate_mode));
+  gst_pad_set_chain_function (reader->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_http_cache_reader_chain));
+  gst_element_add_pad (GST_ELEMENT (reader), reader->sinkpad);
+
+  reader->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_activatemode_function (reader->srcpad,
+      GST_DEBUG_FUNCPTR (gst_http_cache_reader_src_activate_mode));
+  gst_pad_set_getrange_function (reader->srcpad,
+      GST_DEBUG_FUNCPTR (gst_http_cache_reader_getrange));
+  gst_pad_set_event_function (reader->srcpad,
+      GST_DEBUG_FUNCPTR (gst_http_cache_reader_src_event));
+  gst_pad_set_query_function (reader->srcpad,
+      GST_DEBUG_FUNCPTR (gst_http_cache_reader_src_query));
+  gst_element_add_pad (GST_ELEMENT (reader), reader->srcpad);
+
+  reader->stop = -1;
+}
+
+/* pull from the cache when it can seek, push through otherwise */
+static gboolean
+gst_http_cache_reader_sink_activate (GstPad * pad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull = FALSE;
+
+  query = gst_query_new_scheduling ();
+  if (gst_pad_peer_query (pad, query))
+    pull = gst_query_has_scheduling_mode_with_flags (query,
+        GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+  gst_query_unref (query);
+
+  GST_DEBUG_OBJECT (parent, "activating in %s mode", pull ? "pull" : "push");
+
+  return gst_pad_activate_mode (pad, pull ? GST_PAD_MODE_PULL :
+      GST_PAD_MODE_PUSH, TRUE);
+}
+
+static gboolean
+gst_http_cache_reader_sink_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstHttpCacheReader *reader = GST_HTTP_CACHE_READER (parent);
+
+  if (mode != GST_PAD_MODE_PULL)
+    return TRUE;
+
+  if (!active)
+    return gst_pad_stop_task (pad);
+
+  /* downstream pulls through us */
+  if (reader->pulled)
+    return TRUE;
+
+  reader->offset = 0;
+  reader->stop = -1;
+  reader->need_segment = TRUE;
+  reader->seqnum = gst_util_seqnum_next ();
+
+  return gst_pad_start_task (pad, (GstTaskFunction) gst_http_cache_reader_loop,
+      reader, NULL);
+}
+
+static GstFlowReturn
+gst_http_cache_reader_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer)
+{
+  GstHttpCacheReader *reader = GST_HTTP_CACHE_READER (parent);
+
+  return gst_pad_push (reader->srcpad, buffer);
+}
+
+static gboolean
+gst_http_cache_reader_src_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstHttpCacheReader *reader = GST_HTTP_CACHE_READER (parent);
+
+  if (mode != GST_PAD_MODE_PULL)
+    return TRUE;
+
+  GST_DEBUG_OBJECT (reader, "%s pulling through",
+      active ? "start" : "stop");
+  reader->pulled = active;
+
+  return gst_pad_activate_mode (reader->sinkpad, mode, active);
+}
+
+static GstFlowReturn
+gst_http_cache_reader_getrange (GstPad * pad, GstObject * parent,
+    guint64 offset, guint length, GstBuffer ** buffer)
+{
+  GstHttpCacheReader *reader = GST_HTTP_CACHE_READER (parent);
+
+  return gst_pad_pull_range (reader->sinkpad, offset, length, buffer);
+}
+
+static void
+push_segment (GstHttpCacheReader * reader)
+{
+  GstSegment segment;
+  GstEvent *event;
+  GstCaps *caps;
+  gint64 duration;
+  gchar *stream_id;
+
+  if (!(event = gst_pad_get_sticky_event (reader->srcpad,
+              GST_EVENT_STREAM_START, 0))) {
+    stream_id = gst_pad_create_stream_id (reader->srcpad,
+        GST_ELEMENT_CAST (reader), NULL);
+    event = gst_event_new_stream_start (stream_id);
+    gst_event_set_group_id (event, gst_util_group_id_next ());
+    gst_pad_push_event (reader->srcpad, event);
+    g_free (stream_id);
+
+    /* the source usually has no caps, forward them when it has */
+    caps = gst_pad_peer_query_caps (reader->sinkpad, NULL);
+    if (caps && gst_caps_is_fixed (caps))
+      gst_pad_push_event (reader->srcpad, gst_event_new_caps (caps));
+    if (caps)
+      gst_caps_unref (caps);
+  } else {
+    gst_event_unref (event);
+  }
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  segment.start = segment.position = segment.time = reader->offset;
+  segment.stop = reader->stop;
+  if (gst_pad_peer_query_duration (reader->sinkpad, GST_FORMAT_BYTES,
+          &duration))
+    segment.duration = duration;
+
+  event = gst_event_new_segment (&segment);
+  gst_event_set_seqnum (event, reader->seqnum);
+  gst_pad_push_event (reader->srcpad, event);
+}
+
+static void
+gst_http_cache_reader_loop (GstHttpCacheReader * reader)
+{
+  GstBuffer *buffer = NULL;
+  GstFlowReturn ret;
+  GstEvent *event;
+  guint length = BLOCK_SIZE;
+
+  if (reader->need_segment) {
+    push_segment (reader);
+    reader->need_segment = FALSE;
+  }
+
+  if (reader->stop != -1) {
+    if (reader->offset >= reader->stop) {
+      ret = GST_FLOW_EOS;
+      goto pause;
+    }
+    length = MIN (length, reader->stop - reader->offset);
+  }
+
+  ret = gst_pad_pull_range (reader->sinkpad, reader->offset, length, &buffer);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  GST_BUFFER_OFFSET (buffer) = reader->offset;
+  reader->offset += gst_buffer_get_size (buffer);
+  GST_BUFFER_OFFSET_END (buffer) = reader->offset;
+
+  ret = gst_pad_push (reader->srcpad, buffer);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  GST_DEBUG_OBJECT (reader, "pausing task, reason %s",
+      gst_flow_get_name (ret));
+  gst_pad_pause_task (reader->sinkpad);
+
+  if (ret == GST_FLOW_EOS) {
+    event = gst_event_new_eos ();
+    gst_event_set_seqnum (event, reader->seqnum);
+    gst_pad_push_event (reader->srcpad, event);
+  } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+    GST_ELEMENT_ERROR (reader, STREAM, FAILED, (NULL),
+        ("Internal data flow error, reason %s", gst_flow_get_name (ret)));
+    gst_pad_push_event (reader->srcpad, gst_event_new_eos ());
+  }
+}
+
+/* restart the task at the new offset, the cache serves it when it still
+ * has the range */
+static gboolean
+gst_http_cache_reader_seek (GstHttpCacheReader * reader, GstEvent * event)
+{
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+  gdouble rate;
+  gboolean flush;
+  guint32 seqnum;
+  GstEvent *flush_event;
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type, &start,
+      &stop_type, &stop);
+  seqnum = gst_event_get_seqnum (event);
+  gst_event_unref (event);
+
+  if (format != GST_FORMAT_BYTES || rate != 1.0
+      || start_type != GST_SEEK_TYPE_SET || start < 0) {
+    GST_DEBUG_OBJECT (reader, "only forward byte seeks are supported");
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (reader, "seeking to %" G_GINT64_FORMAT, start);
+
+  flush = (flags & GST_SEEK_FLAG_FLUSH) != 0;
+  if (flush) {
+    flush_event = gst_event_new_flush_start ();
+    gst_event_set_seqnum (flush_event, seqnum);
+    gst_pad_push_event (reader->srcpad, flush_event);
+    /* unblocks a pull waiting for the cache */
+    gst_pad_push_event (reader->sinkpad, gst_event_new_flush_start ());
+  } else {
+    gst_pad_pause_task (reader->sinkpad);
+  }
+
+  GST_PAD_STREAM_LOCK (reader->sinkpad);
+
+  if (flush) {
+    gst_pad_push_event (reader->sinkpad, gst_event_new_flush_stop (TRUE));
+    flush_event = gst_event_new_flush_stop (TRUE);
+    gst_event_set_seqnum (flush_event, seqnum);
+    gst_pad_push_event (reader->srcpad, flush_event);
+  }
+
+  reader->offset = start;
+  reader->stop = (stop_type == GST_SEEK_TYPE_SET && stop >= 0) ? stop : -1;
+  reader->need_segment = TRUE;
+  reader->seqnum = seqnum;
+
+  gst_pad_start_task (reader->sinkpad,
+      (GstTaskFunction) gst_http_cache_reader_loop, reader, NULL);
+
+  GST_PAD_STREAM_UNLOCK (reader->sinkpad);
+
+  return TRUE;
+}
+
+static gboolean
+gst_http_cache_reader_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstHttpCacheReader *reader = GST_HTTP_CACHE_READER (parent);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK && !reader->pulled
+      && GST_PAD_MODE (reader->sinkpad) == GST_PAD_MODE_PULL)
+    return gst_http_cache_reader_seek (reader, event);
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_http_cache_reader_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstHttpCacheReader *reader = GST_HTTP_CACHE_READER (parent);
+
+  /* downstream may pull through when the cache can be pulled */
+  if (GST_QUERY_TYPE (query) == GST_QUERY_SCHEDULING)
+    return gst_pad_peer_query (reader->sinkpad, query);
+
+  return gst_pad_query_default (pad, parent, query);
+}
@@ -0,0 +1,67 @@
+/* GStreamer httpextbin element
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *  Author : HoonHee Lee <hoonhee.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_HTTP_CACHE_READER_H__
+#define __GST_HTTP_CACHE_READER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_HTTP_CACHE_READER (gst_http_cache_reader_get_type())
+#define GST_HTTP_CACHE_READER(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_HTTP_CACHE_READER,GstHttpCacheReader))
+#define GST_HTTP_CACHE_READER_CLASS(obj) (G_TYPE_CHECK_CLASS_CAST((obj),GST_TYPE_HTTP_CACHE_READER,GstHttpCacheReaderClass))
+#define GST_IS_HTTP_CACHE_READER(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_HTTP_CACHE_READER))
+#define GST_IS_HTTP_CACHE_READER_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE((obj),GST_TYPE_HTTP_CACHE_READER))
+typedef struct _GstHttpCacheReader GstHttpCacheReader;
+typedef struct _GstHttpCacheReaderClass GstHttpCacheReaderClass;
+
+/**
+ * GstHttpCacheReader:
+ *
+ * Element which pulls from the cache of httpextbin and pushes downstream,
+ * so a filter element in push mode gets its seeks served from the cache.
+ */
+struct _GstHttpCacheReader
+{
+  GstElement parent;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  /* downstream pulls through, no task is running */
+  gboolean pulled;
+
+  /* next offset to read and end of the current segment, protected by the
+   * stream lock of the sink pad */
+  guint64 offset;
+  guint64 stop;
+  gboolean need_segment;
+  guint32 seqnum;
+};
+
+struct _GstHttpCacheReaderClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_http_cache_reader_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_HTTP_CACHE_READER_H__ */
@@ -28,21 +28,63 @@
 
 #include "gsthttpextbin.h"
 
+#include <gst/cool/gstcool.h>
+
 GST_DEBUG_CATEGORY_STATIC (http_ext_bin_debug);
 #define GST_CAT_DEFAULT http_ext_bin_debug
 
 #define parent_class gst_http_ext_bin_parent_class
 
 #define DEFAULT_PROP_URI NULL
+#define DEFAULT_PROP_CACHE_SIZE 0
+#define DEFAULT_PROP_READ_AHEAD (2 * 1024 * 1024)
+#define DEFAULT_PROP_CACHE_LOCATION NULL
+#define DEFAULT_PROP_CONNECTIONS 1
+#define DEFAULT_PROP_CHUNK_SIZE (1024 * 1024)
+#define DEFAULT_PROP_STATS_INTERVAL 1000
+
+/* rates are measured over this window when no stats are posted */
+#define DEFAULT_RATE_WINDOW (G_USEC_PER_SEC)
 enum
 {
   PROP_0,
   PROP_SOURCE,
   PROP_URI,
   PROP_SMART_PROPERTIES,
+  PROP_CACHE_SIZE,
+  PROP_READ_AHEAD,
+  PROP_CACHE_LOCATION,
+  PROP_CONNECTIONS,
+  PROP_CHUNK_SIZE,
+  PROP_STATS_INTERVAL,
+  PROP_DOWNLOAD_RATE,
+  PROP_FIRST_BYTE_LATENCY,
   PROP_LAST
 };
 
+/* transport -> source element, the [httpextbin_source] section of the
+ * configuration adds to and overrides these */
+static const struct
+{
+  const gchar *transport;
+  const gchar *element;
+} default_sources[] = {
+  {"http", "souphttpsrc"},
+  {"https", "souphttpsrc"},
+  {"file", "filesrc"},
+  {"fd", "fdsrc"},
+  {NULL, NULL}
+};
+
+/* suffix handled when the [httpextbin_filter] section has none */
+#define DEFAULT_FILTER_SUFFIX "bbts"
+
+/* protocol suffix -> filter factory, shared by all of httpextbin elements.
+ * It is dropped when the feature list cookie of the registry changes. */
+static GMutex filter_cache_lock;
+static GHashTable *filter_cache = NULL;
+static guint32 filter_cache_cookie = 0;
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -58,6 +100,8 @@ static GstStateChangeReturn gst_http_ext_bin_change_state (GstElement *
 static void gst_http_ext_bin_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 static gboolean gst_http_ext_bin_query (GstElement * element, GstQuery * query);
+static gboolean gst_http_ext_bin_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query);
 
 static gboolean connect_filter_element (GstHttpExtBin * bin);
 G_DEFINE_TYPE_WITH_CODE (GstHttpExtBin, gst_http_ext_bin, GST_TYPE_BIN,
@@ -97,6 +141,91 @@ gst_http_ext_bin_class_init (GstHttpExtBinClass * klass)
           "Hold various property values for reply custom query",
           GST_TYPE_STRUCTURE, G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstHttpExtBin:cache-size
+   *
+   * Size in bytes of the range cache between the source and the filter
+   * element, 0 disables the cache. Recently downloaded ranges stay in the
+   * cache, so backward seeks and re-reads don't go to the server again.
+   *
+   * The cache is read by a httpcachereader element, so a filter element
+   * in push mode gets its byte seeks served from the cache too.
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_SIZE,
+      g_param_spec_uint64 ("cache-size", "Cache Size",
+          "Size of the range cache in bytes (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_PROP_CACHE_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpExtBin:read-ahead
+   *
+   * Number of bytes the cache downloads ahead of the filter element, so
+   * that a stall in the filter doesn't stall the download.
+   */
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD,
+      g_param_spec_uint ("read-ahead", "Read Ahead",
+          "Bytes to download ahead of the filter element", 0, G_MAXUINT,
+          DEFAULT_PROP_READ_AHEAD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpExtBin:cache-location
+   *
+   * Template of a file to keep the cache in instead of memory, it should
+   * end with XXXXXX. The cache is kept in memory when this is NULL.
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_LOCATION,
+      g_param_spec_string ("cache-location", "Cache Location",
+          "Template of the file backing the cache (NULL = memory)",
+          DEFAULT_PROP_CACHE_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpExtBin:connections
+   *
+   * Number of concurrent byte range requests used to download the
+   * resource. With more than one, httpsegmentsrc is used instead of
+   * souphttpsrc and the ranges are put back in order before the filter
+   * element. The download rate is available from the throughput property
+   * of the source.
+   */
+  g_object_class_install_property (gobject_class, PROP_CONNECTIONS,
+      g_param_spec_uint ("connections", "Connections",
+          "Number of concurrent range requests", 1, 16,
+          DEFAULT_PROP_CONNECTIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CHUNK_SIZE,
+      g_param_spec_uint ("chunk-size", "Chunk Size",
+          "Size of a range request in bytes when connections > 1", 1024,
+          G_MAXINT, DEFAULT_PROP_CHUNK_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpExtBin:stats-interval
+   *
+   * Interval in milliseconds of the "http-ext-bin-stats" element messages,
+   * 0 disables them. Each message has the total bytes, the download rate
+   * of the last interval, its moving average and the latency to the first
+   * byte of the last request. The average download rate also answers
+   * buffering queries on the src pad. Rates above G_MAXINT bytes per
+   * second are reported as G_MAXINT.
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Stats Interval",
+          "Interval of bandwidth statistics messages in ms (0 = disabled)", 0,
+          G_MAXUINT, DEFAULT_PROP_STATS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DOWNLOAD_RATE,
+      g_param_spec_int ("download-rate", "Download Rate",
+          "Average download rate in bytes per second (-1 = unknown)", -1,
+          G_MAXINT, -1, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FIRST_BYTE_LATENCY,
+      g_param_spec_uint64 ("first-byte-latency", "First Byte Latency",
+          "Time from the last request to its first byte", 0, G_MAXUINT64,
+          GST_CLOCK_TIME_NONE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_http_ext_bin_change_state);
 
@@ -117,6 +246,7 @@ gst_http_ext_bin_init (GstHttpExtBin * bin)
   /* get src pad template */
   pad_tmpl = gst_static_pad_template_get (&src_template);
   bin->srcpad = gst_ghost_pad_new_no_target_from_template ("src", pad_tmpl);
+  gst_pad_set_query_function (bin->srcpad, gst_http_ext_bin_src_query);
   gst_pad_set_active (bin->srcpad, TRUE);
   /* add src ghost pad */
   gst_element_add_pad (GST_ELEMENT (bin), bin->srcpad);
@@ -127,6 +257,19 @@ gst_http_ext_bin_init (GstHttpExtBin * bin)
 
   bin->smart_prop = NULL;
 
+  bin->cache_size = DEFAULT_PROP_CACHE_SIZE;
+  bin->read_ahead = DEFAULT_PROP_READ_AHEAD;
+  bin->cache_location = g_strdup (DEFAULT_PROP_CACHE_LOCATION);
+
+  bin->connections = DEFAULT_PROP_CONNECTIONS;
+  bin->chunk_size = DEFAULT_PROP_CHUNK_SIZE;
+
+  bin->stats_interval = DEFAULT_PROP_STATS_INTERVAL;
+  bin->request_time = -1;
+  bin->first_byte_latency = GST_CLOCK_TIME_NONE;
+  bin->download_rate = -1;
+  bin->avg_download_rate = -1;
+
   GST_OBJECT_FLAG_SET (bin, GST_ELEMENT_FLAG_SOURCE);
 }
 
@@ -166,11 +309,44 @@ gst_http_ext_bin_set_property (GObject * object, guint prop_id,
       else
         bin->smart_prop = gst_structure_copy (s);
 
-      if (bin->source_elem)
+      if (bin->source_elem
+          && g_object_class_find_property (G_OBJECT_GET_CLASS
+              (bin->source_elem), "smart-properties"))
         g_object_set (bin->source_elem, "smart-properties", bin->smart_prop,
             NULL);
       break;
     }
+    case PROP_CACHE_SIZE:
+      GST_OBJECT_LOCK (bin);
+      bin->cache_size = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_READ_AHEAD:
+      GST_OBJECT_LOCK (bin);
+      bin->read_ahead = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_CACHE_LOCATION:
+      GST_OBJECT_LOCK (bin);
+      g_free (bin->cache_location);
+      bin->cache_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_CONNECTIONS:
+      GST_OBJECT_LOCK (bin);
+      bin->connections = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_CHUNK_SIZE:
+      GST_OBJECT_LOCK (bin);
+      bin->chunk_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_STATS_INTERVAL:
+      GST_OBJECT_LOCK (bin);
+      bin->stats_interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -192,6 +368,46 @@ gst_http_ext_bin_get_property (GObject * object, guint prop_id,
     case PROP_URI:
       g_value_set_string (value, bin->uri);
       break;
+    case PROP_CACHE_SIZE:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->cache_size);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_READ_AHEAD:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint (value, bin->read_ahead);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_CACHE_LOCATION:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_string (value, bin->cache_location);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_CONNECTIONS:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint (value, bin->connections);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_CHUNK_SIZE:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint (value, bin->chunk_size);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_STATS_INTERVAL:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint (value, bin->stats_interval);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_DOWNLOAD_RATE:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_int (value, bin->avg_download_rate);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_FIRST_BYTE_LATENCY:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->first_byte_latency);
+      GST_OBJECT_UNLOCK (bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -210,15 +426,13 @@ gst_http_ext_bin_finalize (GObject * self)
     gst_caps_unref (bin->caps);
   bin->caps = NULL;
 
-  if (bin->list)
-    gst_plugin_feature_list_free (bin->list);
-  bin->list = NULL;
-
   if (bin->smart_prop) {
     gst_structure_free (bin->smart_prop);
     bin->smart_prop = NULL;
   }
 
+  g_free (bin->cache_location);
+  g_free (bin->source_origin);
 
   G_OBJECT_CLASS (parent_class)->finalize (self);
 }
@@ -256,6 +470,145 @@ gst_http_ext_bin_query (GstElement * element, GstQuery * query)
   return ret;
 }
 
+/* the upstream answer is completed with the measured download rate */
+static gboolean
+gst_http_ext_bin_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstHttpExtBin *bin = GST_HTTP_EXT_BIN (parent);
+  gboolean ret;
+
+  ret = gst_proxy_pad_query_default (pad, parent, query);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_BUFFERING) {
+    GstBufferingMode mode = GST_BUFFERING_STREAM;
+    gint avg_in, avg_out = -1;
+    gint64 buffering_left = -1;
+
+    if (ret)
+      gst_query_parse_buffering_stats (query, &mode, NULL, &avg_out,
+          &buffering_left);
+
+    GST_OBJECT_LOCK (bin);
+    avg_in = bin->avg_download_rate;
+    GST_OBJECT_UNLOCK (bin);
+
+    if (avg_in >= 0) {
+      GST_LOG_OBJECT (bin, "estimated download rate:%d", avg_in);
+      gst_query_set_buffering_stats (query, mode, avg_in, avg_out,
+          buffering_left);
+      ret = TRUE;
+    }
+  }
+
+  return ret;
+}
+
+/* the source is about to issue a new request, the next buffer is its
+ * first byte */
+static void
+reset_stats (GstHttpExtBin * bin)
+{
+  GST_OBJECT_LOCK (bin);
+  bin->request_time = g_get_monotonic_time ();
+  bin->window_start = bin->request_time;
+  bin->window_bytes = 0;
+  GST_OBJECT_UNLOCK (bin);
+}
+
+static GstPadProbeReturn
+stats_probe_cb (GstPad * pad, GstPadProbeInfo * info, GstHttpExtBin * bin)
+{
+  GstStructure *s = NULL;
+  gint64 now, elapsed, window;
+  gsize size;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & (GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+          GST_PAD_PROBE_TYPE_EVENT_FLUSH)) {
+    /* the source requests right after it started streaming, and again
+     * after a seek */
+    switch (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info))) {
+      case GST_EVENT_STREAM_START:
+      case GST_EVENT_FLUSH_STOP:
+        reset_stats (bin);
+        break;
+      default:
+        break;
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0, size = 0; i < len; i++)
+      size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+  } else {
+    size = gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  }
+
+  now = g_get_monotonic_time ();
+
+  GST_OBJECT_LOCK (bin);
+  if (bin->request_time >= 0) {
+    bin->first_byte_latency =
+        (now - bin->request_time) * (GST_SECOND / G_USEC_PER_SEC);
+    bin->request_time = -1;
+    GST_DEBUG_OBJECT (bin, "first byte latency:%" GST_TIME_FORMAT,
+        GST_TIME_ARGS (bin->first_byte_latency));
+  }
+
+  bin->total_bytes += size;
+  bin->window_bytes += size;
+
+  window = bin->stats_interval > 0 ?
+      (gint64) bin->stats_interval * 1000 : DEFAULT_RATE_WINDOW;
+  elapsed = now - bin->window_start;
+
+  if (elapsed >= window) {
+    /* the rates are gint like the buffering stats, clamp them */
+    bin->download_rate = MIN (gst_util_uint64_scale (bin->window_bytes,
+            G_USEC_PER_SEC, elapsed), G_MAXINT);
+    /* moving average, weights the last window by 1/4 */
+    if (bin->avg_download_rate < 0)
+      bin->avg_download_rate = bin->download_rate;
+    else
+      bin->avg_download_rate =
+          (3 * (gint64) bin->avg_download_rate + bin->download_rate) / 4;
+    bin->window_start = now;
+    bin->window_bytes = 0;
+
+    if (bin->stats_interval > 0)
+      s = gst_structure_new ("http-ext-bin-stats",
+          "bytes", G_TYPE_UINT64, bin->total_bytes,
+          "download-rate", G_TYPE_INT, bin->download_rate,
+          "avg-download-rate", G_TYPE_INT, bin->avg_download_rate,
+          "first-byte-latency", G_TYPE_UINT64, bin->first_byte_latency, NULL);
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  if (s)
+    gst_element_post_message (GST_ELEMENT_CAST (bin),
+        gst_message_new_element (GST_OBJECT_CAST (bin), s));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+add_stats_probe (GstHttpExtBin * bin)
+{
+  GstPad *srcpad;
+
+  if (!(srcpad = gst_element_get_static_pad (bin->source_elem, "src")))
+    return;
+
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) stats_probe_cb, bin, NULL);
+  gst_object_unref (srcpad);
+}
+
 static gboolean
 set_uri_to_source (GstHttpExtBin * bin, const gchar * new_uri)
 {
@@ -283,7 +636,7 @@ _http_ext_bin_compare_factories_func (gconstpointer p1, gconstpointer p2)
 static GList *
 gst_http_ext_bin_update_factories_list (GstHttpExtBin * bin)
 {
-  GList *factories;
+  GList *factories, *list;
 
   /* list up elements with given caps */
   factories =
@@ -295,28 +648,182 @@ gst_http_ext_bin_update_factories_list (GstHttpExtBin * bin)
     return NULL;
   }
 
-  if (bin->list)
-    gst_plugin_feature_list_free (bin->list);
-  bin->list =
+  list =
       gst_element_factory_list_filter (factories, bin->caps, GST_PAD_SINK,
       gst_caps_is_fixed (bin->caps));
   gst_plugin_feature_list_free (factories);
 
-  if (!bin->list) {
+  if (!list) {
     GST_WARNING_OBJECT (bin->caps,
         "Couldn't list up any of element which handles caps");
     return NULL;
   }
 
-  return g_list_sort (bin->list, _http_ext_bin_compare_factories_func);
+  return g_list_sort (list, _http_ext_bin_compare_factories_func);
+}
+
+/* scan the registry for the best filter whose sink template has bin->caps
+ * as a subset */
+static GstElementFactory *
+gst_http_ext_bin_find_filter_factory (GstHttpExtBin * bin)
+{
+  GList *list, *tmp;
+  GstElementFactory *factory = NULL;
+
+  list = gst_http_ext_bin_update_factories_list (bin);
+
+  for (tmp = list; tmp && !factory; tmp = tmp->next) {
+    const GList *templs;
+    GstElementFactory *fac = GST_ELEMENT_FACTORY_CAST (tmp->data);
+    templs = gst_element_factory_get_static_pad_templates (fac);
+
+    while (templs) {
+      GstStaticPadTemplate *templ = (GstStaticPadTemplate *) templs->data;
+
+      if (templ->direction == GST_PAD_SINK) {
+        GstCaps *templcaps = gst_static_caps_get (&templ->static_caps);
+        if (!gst_caps_is_any (templcaps)
+            && gst_caps_is_subset (bin->caps, templcaps)) {
+          GST_INFO_OBJECT (bin,
+              "caps %" GST_PTR_FORMAT " subset of %" GST_PTR_FORMAT, bin->caps,
+              templcaps);
+          factory = gst_object_ref (fac);
+          gst_caps_unref (templcaps);
+          break;
+        }
+        gst_caps_unref (templcaps);
+      }
+      templs = g_list_next (templs);
+    }
+  }
+
+  gst_plugin_feature_list_free (list);
+
+  return factory;
+}
+
+/* filter factory named for @suffix in the [httpextbin_filter] section of
+ * the configuration */
+static GstElementFactory *
+get_configured_filter_factory (GstHttpExtBin * bin, const gchar * suffix)
+{
+  GKeyFile *config = gst_cool_get_configuration ();
+  GstElementFactory *factory;
+  gchar *name;
+
+  if (!config
+      || !(name = g_key_file_get_string (config, "httpextbin_filter", suffix,
+              NULL)))
+    return NULL;
+
+  if (!(factory = gst_element_factory_find (name)))
+    GST_WARNING_OBJECT (bin, "configured filter %s for %s is not available",
+        name, suffix);
+  g_free (name);
+
+  return factory;
+}
+
+static void
+unref_cached_factory (gpointer factory)
+{
+  if (factory)
+    gst_object_unref (factory);
+}
+
+/* resolve @suffix to a filter factory. The registry is only scanned the
+ * first time a suffix is used after the registry changed, the result
+ * (including no factory) is cached otherwise. */
+static GstElementFactory *
+gst_http_ext_bin_lookup_filter_factory (GstHttpExtBin * bin,
+    const gchar * suffix)
+{
+  GstElementFactory *factory;
+  gpointer cached;
+  guint32 cookie;
+
+  g_mutex_lock (&filter_cache_lock);
+
+  cookie = gst_registry_get_feature_list_cookie (gst_registry_get ());
+  if (!filter_cache) {
+    filter_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        unref_cached_factory);
+  } else if (cookie != filter_cache_cookie) {
+    GST_DEBUG_OBJECT (bin, "registry changed, dropping filter cache");
+    g_hash_table_remove_all (filter_cache);
+  }
+  filter_cache_cookie = cookie;
+
+  if (g_hash_table_lookup_extended (filter_cache, suffix, NULL, &cached)) {
+    GST_DEBUG_OBJECT (bin, "cached filter for %s: %s", suffix,
+        cached ? GST_OBJECT_NAME (cached) : "none");
+    factory = cached ? gst_object_ref (cached) : NULL;
+  } else {
+    if (!(factory = get_configured_filter_factory (bin, suffix)))
+      factory = gst_http_ext_bin_find_filter_factory (bin);
+    g_hash_table_insert (filter_cache, g_strdup (suffix),
+        factory ? gst_object_ref (factory) : NULL);
+  }
+
+  g_mutex_unlock (&filter_cache_lock);
+
+  return factory;
+}
+
+/* a queue2 in ring buffer mode keeps the downloaded ranges and serves
+ * reads inside of them without going to the server. That only works when
+ * its peer pulls, so a httpcachereader pulls from it for the filter. */
+static GstElement *
+create_cache_element (GstHttpExtBin * bin)
+{
+  GstElement *cache;
+
+  if (!(cache = gst_element_factory_make ("queue2", "cache"))) {
+    GST_WARNING_OBJECT (bin, "Could not create a queue2 element for cache");
+    return NULL;
+  }
+
+  GST_OBJECT_LOCK (bin);
+  GST_INFO_OBJECT (bin, "cache size:%" G_GUINT64_FORMAT ", read ahead:%u, "
+      "location:%s", bin->cache_size, bin->read_ahead,
+      GST_STR_NULL (bin->cache_location));
+  g_object_set (cache, "max-size-buffers", 0, "max-size-time",
+      (guint64) 0, "max-size-bytes", bin->read_ahead, "ring-buffer-max-size",
+      bin->cache_size, "use-buffering", FALSE, NULL);
+  if (bin->cache_location)
+    g_object_set (cache, "temp-template", bin->cache_location, NULL);
+  GST_OBJECT_UNLOCK (bin);
+
+  return cache;
 }
 
 static gboolean
 connect_filter_element (GstHttpExtBin * bin)
 {
   GstPad *srcpad, *sinkpad;
+  GstElement *upstream = bin->source_elem;
   gboolean ret = TRUE;
 
+  /* read-ahead cache goes between source and filter element */
+  if (bin->cache_size > 0 && (bin->cache_elem = create_cache_element (bin))) {
+    if (!gst_bin_add (GST_BIN_CAST (bin), bin->cache_elem)
+        || !gst_element_link_pads (bin->source_elem, "src", bin->cache_elem,
+            "sink")) {
+      GST_WARNING_OBJECT (bin, "Couldn't link cache element");
+      return FALSE;
+    }
+
+    if (!(bin->reader_elem =
+            gst_element_factory_make ("httpcachereader", "reader"))
+        || !gst_bin_add (GST_BIN_CAST (bin), bin->reader_elem)
+        || !gst_element_link_pads (bin->cache_elem, "src", bin->reader_elem,
+            "sink")) {
+      GST_WARNING_OBJECT (bin, "Couldn't link cache reader element");
+      return FALSE;
+    }
+    upstream = bin->reader_elem;
+  }
+
   /* add filter element to bin */
   if (!(gst_bin_add (GST_BIN_CAST (bin), bin->filter_elem))) {
     GST_WARNING_OBJECT (bin, "Couldn't add %s to the bin",
@@ -324,10 +831,10 @@ connect_filter_element (GstHttpExtBin * bin)
     return FALSE;
   }
 
-  /* try to get src pad from source element */
-  if (!(srcpad = gst_element_get_static_pad (bin->source_elem, "src"))) {
+  /* try to get src pad from source or cache reader element */
+  if (!(srcpad = gst_element_get_static_pad (upstream, "src"))) {
     GST_WARNING_OBJECT (bin, "Element %s doesn't have a src pad",
-        GST_ELEMENT_NAME (bin->source_elem));
+        GST_ELEMENT_NAME (upstream));
     return FALSE;
   }
 
@@ -373,6 +880,20 @@ remove_source (GstHttpExtBin * bin)
     bin->source_elem = NULL;
   }
 
+  if (bin->cache_elem) {
+    GST_DEBUG_OBJECT (bin, "removing old cache element");
+    gst_element_set_state (bin->cache_elem, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN_CAST (bin), bin->cache_elem);
+    bin->cache_elem = NULL;
+  }
+
+  if (bin->reader_elem) {
+    GST_DEBUG_OBJECT (bin, "removing old cache reader element");
+    gst_element_set_state (bin->reader_elem, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN_CAST (bin), bin->reader_elem);
+    bin->reader_elem = NULL;
+  }
+
   if (bin->filter_elem) {
     GST_DEBUG_OBJECT (bin, "removing old filter element");
     gst_element_set_state (bin->filter_elem, GST_STATE_NULL);
@@ -380,18 +901,100 @@ remove_source (GstHttpExtBin * bin)
     bin->filter_elem = NULL;
   }
 
-  if (bin->caps)
-    gst_caps_unref (bin->caps);
-  bin->caps = NULL;
-
-  if (bin->list)
-    gst_plugin_feature_list_free (bin->list);
-  bin->list = NULL;
+  g_free (bin->source_origin);
+  bin->source_origin = NULL;
 
   /* Don't loose the SOURCE flag */
   GST_OBJECT_FLAG_SET (bin, GST_ELEMENT_FLAG_SOURCE);
 }
 
+/* scheme, host and port of @uri, e.g. "http://example.com:8080". Without
+ * a host, e.g. "file:///path", the whole uri is the origin. */
+static gchar *
+get_uri_origin (const gchar * uri)
+{
+  const gchar *host, *path;
+
+  if (!(host = strstr (uri, "://")))
+    return NULL;
+  host += 3;
+
+  if ((path = strchr (host, '/')) && path != host)
+    return g_strndup (uri, path - uri);
+
+  return g_strdup (uri);
+}
+
+/* name of the source element for @transport, the configuration takes
+ * precedence over the built-in table */
+static gchar *
+get_source_element_name (GstHttpExtBin * bin, const gchar * transport)
+{
+  GKeyFile *config = gst_cool_get_configuration ();
+  gchar *name = NULL;
+  gint i;
+
+  if (config)
+    name = g_key_file_get_string (config, "httpextbin_source", transport,
+        NULL);
+
+  for (i = 0; !name && default_sources[i].transport; i++) {
+    if (g_strcmp0 (default_sources[i].transport, transport) == 0)
+      name = g_strdup (default_sources[i].element);
+  }
+
+  /* segmented download replaces souphttpsrc only */
+  if (name && bin->connections > 1 && g_strcmp0 (name, "souphttpsrc") == 0) {
+    g_free (name);
+    name = g_strdup ("httpsegmentsrc");
+  }
+
+  return name;
+}
+
+/* the elements of the previous uri are kept when the new one is on the
+ * same origin and needs the same filter, source and cache, so only the
+ * location of the source has to be changed. This saves creating, looking
+ * up and linking the elements, not the connection: souphttpsrc creates its
+ * soup session when it starts and closes it when it stops, so the next uri
+ * still pays for a new TCP and TLS handshake. */
+static gboolean
+can_reuse_source (GstHttpExtBin * bin, const gchar * origin,
+    const gchar * source_name, GstElementFactory * factory)
+{
+  GstElementFactory *source_factory;
+
+  if (!bin->source_elem || !bin->filter_elem || !bin->source_origin)
+    return FALSE;
+
+  if (g_strcmp0 (bin->source_origin, origin) != 0)
+    return FALSE;
+
+  /* the registry may have a better filter since then */
+  if (gst_element_get_factory (bin->filter_elem) != factory)
+    return FALSE;
+
+  source_factory = gst_element_get_factory (bin->source_elem);
+  if (g_strcmp0 (GST_OBJECT_NAME (source_factory), source_name) != 0)
+    return FALSE;
+
+  if ((bin->cache_size > 0) != (bin->cache_elem != NULL))
+    return FALSE;
+
+  if (g_strcmp0 (source_name, "httpsegmentsrc") == 0)
+    g_object_set (bin->source_elem, "connections", bin->connections,
+        "chunk-size", bin->chunk_size, NULL);
+
+  if (bin->cache_elem) {
+    GST_OBJECT_LOCK (bin);
+    g_object_set (bin->cache_elem, "max-size-bytes", bin->read_ahead,
+        "ring-buffer-max-size", bin->cache_size, NULL);
+    GST_OBJECT_UNLOCK (bin);
+  }
+
+  return TRUE;
+}
+
 static gboolean
 setup_source (GstHttpExtBin * bin)
 {
@@ -400,16 +1003,13 @@ setup_source (GstHttpExtBin * bin)
   gchar **protocols = NULL;
   gchar *real_protocol;
   gchar *new_uri;
-  GList *tmp;
+  gchar *origin;
+  gchar *source_name;
   GstElementFactory *factory = NULL;
-  gboolean skip = FALSE;
   gchar *caps_str;
 
   GST_DEBUG_OBJECT (bin, "setup source");
 
-  /* delete old src */
-  remove_source (bin);
-
   protocol = gst_uri_get_protocol (bin->uri);
   location = gst_uri_get_location (bin->uri);
 
@@ -423,40 +1023,14 @@ setup_source (GstHttpExtBin * bin)
 
   real_protocol = g_strdup (protocols[0]);
   caps_str = g_strdup_printf ("application/%s", protocols[1]);
+  if (bin->caps)
+    gst_caps_unref (bin->caps);
   bin->caps = gst_caps_from_string (caps_str);
 
   GST_INFO_OBJECT (bin->caps, "created caps");
 
-  /* list up elements with given caps */
-  bin->list = gst_http_ext_bin_update_factories_list (bin);
-
-  for (tmp = bin->list; tmp; tmp = tmp->next) {
-    const GList *templs;
-    GstElementFactory *fac = GST_ELEMENT_FACTORY_CAST (tmp->data);
-    templs = gst_element_factory_get_static_pad_templates (fac);
-
-    while (templs) {
-      GstStaticPadTemplate *templ = (GstStaticPadTemplate *) templs->data;
-
-      if (templ->direction == GST_PAD_SINK) {
-        GstCaps *templcaps = gst_static_caps_get (&templ->static_caps);
-        if (!gst_caps_is_any (templcaps)
-            && gst_caps_is_subset (bin->caps, templcaps)) {
-          GST_INFO_OBJECT (bin,
-              "caps %" GST_PTR_FORMAT " subset of %" GST_PTR_FORMAT, bin->caps,
-              templcaps);
-          factory = fac;
-          gst_caps_unref (templcaps);
-          skip = TRUE;
-          break;
-        }
-        gst_caps_unref (templcaps);
-      }
-      templs = g_list_next (templs);
-    }
-    if (skip)
-      break;
-  }
+  /* resolve the filter element, usually from the cache */
+  factory = gst_http_ext_bin_lookup_filter_factory (bin, protocols[1]);
 
   if (!factory) {
     ret = FALSE;
@@ -466,42 +1040,95 @@ setup_source (GstHttpExtBin * bin)
   g_free (caps_str);
   g_strfreev (protocols);
 
-  /* generate souphttpsrc element */
-  if (!(bin->source_elem = gst_element_factory_make ("souphttpsrc", NULL))) {
-    GST_WARNING_OBJECT (bin, "Could not create a souphttpsrc element ");
+  /* the source element is mapped from the transport */
+  if (!(source_name = get_source_element_name (bin, real_protocol))) {
+    GST_ELEMENT_ERROR (bin, CORE, MISSING_PLUGIN, (NULL),
+        ("No source element for transport:%s", real_protocol));
+    g_free (location);
+    g_free (real_protocol);
+    gst_object_unref (factory);
+    remove_source (bin);
     return FALSE;
   }
 
-  if (bin->smart_prop)
-    g_object_set (bin->source_elem, "smart-properties", bin->smart_prop, NULL);
-
   new_uri = g_strdup_printf ("%s://%s", real_protocol, location);
-  GST_INFO_OBJECT (bin, "new_uri:%s", new_uri);
+  GST_INFO_OBJECT (bin, "new_uri:%s, source:%s", new_uri, source_name);
   g_free (location);
   g_free (real_protocol);
 
-  /* set converted uri to souphttpsrc element */
+  origin = get_uri_origin (new_uri);
+
+  /* same origin as the previous uri, only the location is changed */
+  if (can_reuse_source (bin, origin, source_name, factory)) {
+    if (set_uri_to_source (bin, new_uri)) {
+      GST_INFO_OBJECT (bin, "reusing elements of %s", origin);
+      g_free (origin);
+      g_free (new_uri);
+      g_free (source_name);
+      gst_object_unref (factory);
+      goto done;
+    }
+    GST_DEBUG_OBJECT (bin, "source refused new uri, recreating elements");
+  }
+
+  /* delete old src */
+  remove_source (bin);
+  bin->source_origin = origin;
+
+  bin->source_elem = gst_element_factory_make (source_name, NULL);
+  if (!bin->source_elem) {
+    GST_WARNING_OBJECT (bin, "Could not create a %s element", source_name);
+    g_free (source_name);
+    g_free (new_uri);
+    gst_object_unref (factory);
+    return FALSE;
+  }
+
+  if (g_strcmp0 (source_name, "httpsegmentsrc") == 0) {
+    g_object_set (bin->source_elem, "connections", bin->connections,
+        "chunk-size", bin->chunk_size, NULL);
+  } else if (g_strcmp0 (source_name, "souphttpsrc") == 0) {
+    /* the connection is kept open across the requests of one session,
+     * e.g. for seeks, the session itself ends when the source stops */
+    g_object_set (bin->source_elem, "keep-alive", TRUE, NULL);
+  }
+  g_free (source_name);
+
+  if (bin->smart_prop
+      && g_object_class_find_property (G_OBJECT_GET_CLASS (bin->source_elem),
+          "smart-properties"))
+    g_object_set (bin->source_elem, "smart-properties", bin->smart_prop, NULL);
+
+  /* set converted uri to source element */
   ret = set_uri_to_source (bin, new_uri);
   if (!ret) {
-    GST_WARNING_OBJECT (bin, "Failed to set uri:%s to souphttpsrc element",
+    GST_WARNING_OBJECT (bin, "Failed to set uri:%s to source element",
         new_uri);
+    g_free (new_uri);
+    gst_object_unref (factory);
     return FALSE;
   }
 
   g_free (new_uri);
 
   if (!(gst_bin_add (GST_BIN_CAST (bin), bin->source_elem))) {
-    GST_WARNING_OBJECT (bin, "Couldn't add souphttp element to bin");
+    GST_WARNING_OBJECT (bin, "Couldn't add source element to bin");
+    gst_object_unref (factory);
     return FALSE;
   }
 
+  add_stats_probe (bin);
+
   /* generate filter element */
   GST_INFO_OBJECT (bin, "filtered factory:%s", GST_OBJECT_NAME (factory));
-  if ((bin->filter_elem = gst_element_factory_create (factory, NULL)) == NULL) {
+  bin->filter_elem = gst_element_factory_create (factory, NULL);
+  if (bin->filter_elem == NULL) {
     GST_WARNING_OBJECT (bin, "Could not create an element from %s",
         gst_plugin_feature_get_name (GST_PLUGIN_FEATURE (factory)));
+    gst_object_unref (factory);
     return FALSE;
   }
+  gst_object_unref (factory);
 
   /* connent filter element */
   ret = connect_filter_element (bin);
@@ -525,11 +1152,15 @@ no_filter:
       gst_caps_unref (bin->caps);
     bin->caps = NULL;
 
+    remove_source (bin);
     goto done;
   }
 
 invalid_protocols:
   GST_ELEMENT_ERROR (bin, CORE, FAILED, (NULL), ("protocol is invalid"));
+  g_free (location);
+  g_strfreev (protocols);
+  remove_source (bin);
   ret = FALSE;
   goto done;
 }
@@ -546,6 +1177,14 @@ gst_http_ext_bin_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       if (!setup_source (bin))
         goto source_failed;
+      GST_OBJECT_LOCK (bin);
+      bin->total_bytes = 0;
+      bin->first_byte_latency = GST_CLOCK_TIME_NONE;
+      bin->download_rate = -1;
+      bin->avg_download_rate = -1;
+      /* timed from the stream-start of the source, see stats_probe_cb() */
+      bin->request_time = -1;
+      GST_OBJECT_UNLOCK (bin);
       break;
     default:
       break;
@@ -561,6 +1200,10 @@ gst_http_ext_bin_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       GST_DEBUG ("paused to ready");
+      /* elements are kept for the next uri, see setup_source() */
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      GST_DEBUG ("ready to null");
       remove_source (bin);
       break;
     default:
@@ -588,12 +1231,35 @@ gst_http_ext_bin_uri_get_type (GType type)
   return GST_URI_SRC;
 }
 
+/* every transport of the built-in source table combined with the built-in
+ * suffix, e.g. "http+bbts" or "file+bbts". The protocols are queried when
+ * the plugin is registered, usually in gst-plugin-scanner without the
+ * configuration, so entries of [httpextbin_source] and [httpextbin_filter]
+ * are not advertised. Such uris still work on an httpextbin made by name. */
+static gpointer
+build_protocols (gpointer data)
+{
+  GPtrArray *protocols;
+  guint i;
+
+  protocols = g_ptr_array_new ();
+
+  for (i = 0; default_sources[i].transport; i++)
+    g_ptr_array_add (protocols, g_strdup_printf ("%s+%s",
+            default_sources[i].transport, DEFAULT_FILTER_SUFFIX));
+  g_ptr_array_add (protocols, NULL);
+
+  return g_ptr_array_free (protocols, FALSE);
+}
+
 static const gchar *const *
 gst_http_ext_bin_uri_get_protocols (GType type)
 {
-  static const gchar *protocols[] = { "http+bbts", NULL };
+  static GOnce protocols_once = G_ONCE_INIT;
+
+  g_once (&protocols_once, build_protocols, NULL);
 
-  return protocols;
+  return (const gchar * const *) protocols_once.retval;
 }
 
 static gchar *
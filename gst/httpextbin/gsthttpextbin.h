@@ -39,14 +39,36 @@ struct _GstHttpExtBin
   GstPad *srcpad;
 
   GstElement *source_elem;
+  GstElement *cache_elem;
+  GstElement *reader_elem;
   GstElement *filter_elem;
 
   gchar *uri;
   GstCaps *caps;
 
-  GList *list;                  /* list we can use for selecting elements */
+  /* scheme, host and port the current elements were set up for */
+  gchar *source_origin;
 
   GstStructure *smart_prop;
+
+  /* read-ahead cache between source and filter */
+  guint64 cache_size;
+  guint read_ahead;
+  gchar *cache_location;
+
+  /* segmented download over several connections */
+  guint connections;
+  guint chunk_size;
+
+  /* download statistics, measured on the src pad of the source */
+  guint stats_interval;
+  gint64 request_time;
+  GstClockTime first_byte_latency;
+  guint64 total_bytes;
+  guint64 window_bytes;
+  gint64 window_start;
+  gint download_rate;
+  gint avg_download_rate;
 };
 
 struct _GstHttpExtBinClass
@@ -0,0 +1,706 @@
+/* GStreamer httpextbin element
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *  Author : HoonHee Lee <hoonhee.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-httpsegmentsrc
+ *
+ * httpsegmentsrc downloads a HTTP resource over several connections at
+ * once. The resource is split into chunks of #GstHttpSegmentSrc:chunk-size
+ * bytes and each connection requests the next chunk with a byte range
+ * request as soon as it is done with the previous one. Chunks are pushed
+ * downstream in order, so downstream sees a plain byte stream.
+ *
+ * Each connection is a souphttpsrc element driven in pull mode. At most
+ * two chunks per connection are downloaded ahead of downstream.
+ *
+ * Downstream may pull as well. A read at another offset than the last one
+ * ended at restarts the download there, like a seek does.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gsthttpsegmentsrc.h"
+
+GST_DEBUG_CATEGORY_STATIC (http_segment_src_debug);
+#define GST_CAT_DEFAULT http_segment_src_debug
+
+#define parent_class gst_http_segment_src_parent_class
+
+#define DEFAULT_PROP_LOCATION NULL
+#define DEFAULT_PROP_CONNECTIONS 4
+#define DEFAULT_PROP_CHUNK_SIZE (1024 * 1024)
+
+#define SIZE_UNKNOWN G_MAXUINT64
+
+/* how far connections may download ahead of downstream */
+#define FETCH_WINDOW(src) ((guint64) (src)->connections * (src)->chunk_size * 2)
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_CONNECTIONS,
+  PROP_CHUNK_SIZE,
+  PROP_THROUGHPUT,
+  PROP_SMART_PROPERTIES,
+  PROP_LAST
+};
+
+typedef struct
+{
+  GstHttpSegmentSrc *src;
+  GstElement *soup;
+  GstPad *pad;
+  GThread *thread;
+} GstHttpSegmentWorker;
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_http_segment_src_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_http_segment_src_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_http_segment_src_finalize (GObject * object);
+static gboolean gst_http_segment_src_start (GstBaseSrc * bsrc);
+static gboolean gst_http_segment_src_stop (GstBaseSrc * bsrc);
+static gboolean gst_http_segment_src_get_size (GstBaseSrc * bsrc,
+    guint64 * size);
+static gboolean gst_http_segment_src_is_seekable (GstBaseSrc * bsrc);
+static gboolean gst_http_segment_src_do_seek (GstBaseSrc * bsrc,
+    GstSegment * segment);
+static gboolean gst_http_segment_src_unlock (GstBaseSrc * bsrc);
+static gboolean gst_http_segment_src_unlock_stop (GstBaseSrc * bsrc);
+static GstFlowReturn gst_http_segment_src_create (GstBaseSrc * bsrc,
+    guint64 offset, guint length, GstBuffer ** buf);
+static void gst_http_segment_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_DEFINE_TYPE_WITH_CODE (GstHttpSegmentSrc, gst_http_segment_src,
+    GST_TYPE_BASE_SRC, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_http_segment_src_uri_handler_init));
+
+static void
+gst_http_segment_src_class_init (GstHttpSegmentSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseSrcClass *gstbasesrc_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gstelement_class = GST_ELEMENT_CLASS (klass);
+  gstbasesrc_class = GST_BASE_SRC_CLASS (klass);
+
+  gobject_class->set_property = gst_http_segment_src_set_property;
+  gobject_class->get_property = gst_http_segment_src_get_property;
+  gobject_class->finalize = gst_http_segment_src_finalize;
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "Location",
+          "Location to read from", DEFAULT_PROP_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CONNECTIONS,
+      g_param_spec_uint ("connections", "Connections",
+          "Number of concurrent range requests", 1, 16,
+          DEFAULT_PROP_CONNECTIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CHUNK_SIZE,
+      g_param_spec_uint ("chunk-size", "Chunk Size",
+          "Size of a range request in bytes", 1024, G_MAXINT,
+          DEFAULT_PROP_CHUNK_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpSegmentSrc:throughput
+   *
+   * Download rate of all of connections together in bytes per second,
+   * measured since the first request.
+   */
+  g_object_class_install_property (gobject_class, PROP_THROUGHPUT,
+      g_param_spec_uint64 ("throughput", "Throughput",
+          "Aggregate download rate in bytes per second", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SMART_PROPERTIES,
+      g_param_spec_boxed ("smart-properties", "Smart Properties",
+          "Hold various property values for reply custom query",
+          GST_TYPE_STRUCTURE, G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
+
+  gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_http_segment_src_start);
+  gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_http_segment_src_stop);
+  gstbasesrc_class->get_size =
+      GST_DEBUG_FUNCPTR (gst_http_segment_src_get_size);
+  gstbasesrc_class->is_seekable =
+      GST_DEBUG_FUNCPTR (gst_http_segment_src_is_seekable);
+  gstbasesrc_class->do_seek = GST_DEBUG_FUNCPTR (gst_http_segment_src_do_seek);
+  gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_http_segment_src_unlock);
+  gstbasesrc_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_http_segment_src_unlock_stop);
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_http_segment_src_create);
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "Segmented HTTP Source", "Source/Network/Protocol",
+      "Download over several concurrent HTTP range requests",
+      "HoonHee Lee <hoonhee.lee@lge.com>");
+
+  GST_DEBUG_CATEGORY_INIT (http_segment_src_debug, "httpsegmentsrc", 0,
+      "Segmented HTTP Source");
+}
+
+static void
+gst_http_segment_src_init (GstHttpSegmentSrc * src)
+{
+  src->location = g_strdup (DEFAULT_PROP_LOCATION);
+  src->connections = DEFAULT_PROP_CONNECTIONS;
+  src->chunk_size = DEFAULT_PROP_CHUNK_SIZE;
+  src->smart_prop = NULL;
+
+  g_mutex_init (&src->lock);
+  g_cond_init (&src->cond);
+
+  src->workers = g_ptr_array_new ();
+  src->chunks = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free,
+      (GDestroyNotify) gst_buffer_unref);
+  src->size = SIZE_UNKNOWN;
+  src->eos_offset = SIZE_UNKNOWN;
+
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_BYTES);
+}
+
+static void
+gst_http_segment_src_finalize (GObject * object)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (object);
+
+  g_free (src->location);
+  if (src->smart_prop)
+    gst_structure_free (src->smart_prop);
+
+  g_ptr_array_free (src->workers, TRUE);
+  g_hash_table_destroy (src->chunks);
+  g_cond_clear (&src->cond);
+  g_mutex_clear (&src->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_http_segment_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      GST_OBJECT_LOCK (src);
+      g_free (src->location);
+      src->location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_CONNECTIONS:
+      src->connections = g_value_get_uint (value);
+      break;
+    case PROP_CHUNK_SIZE:
+      src->chunk_size = g_value_get_uint (value);
+      break;
+    case PROP_SMART_PROPERTIES:
+      GST_OBJECT_LOCK (src);
+      if (src->smart_prop)
+        gst_structure_free (src->smart_prop);
+      src->smart_prop = gst_structure_copy (gst_value_get_structure (value));
+      GST_OBJECT_UNLOCK (src);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_http_segment_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      GST_OBJECT_LOCK (src);
+      g_value_set_string (value, src->location);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_CONNECTIONS:
+      g_value_set_uint (value, src->connections);
+      break;
+    case PROP_CHUNK_SIZE:
+      g_value_set_uint (value, src->chunk_size);
+      break;
+    case PROP_THROUGHPUT:
+      g_mutex_lock (&src->lock);
+      g_value_set_uint64 (value, src->throughput);
+      g_mutex_unlock (&src->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* download [offset, offset + size), souphttpsrc may return less than asked
+ * so this keeps reading from the same response until the chunk is full */
+static GstFlowReturn
+fetch_chunk (GstHttpSegmentWorker * worker, guint64 offset, guint size,
+    GstBuffer ** chunk)
+{
+  GstBuffer *result = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint got = 0;
+
+  while (got < size) {
+    GstBuffer *buf = NULL;
+    gsize len;
+
+    ret = gst_pad_get_range (worker->pad, offset + got, size - got, &buf);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    len = gst_buffer_get_size (buf);
+    if (len == 0) {
+      gst_buffer_unref (buf);
+      ret = GST_FLOW_EOS;
+      break;
+    }
+
+    got += len;
+    result = result ? gst_buffer_append (result, buf) : buf;
+  }
+
+  /* a short chunk is the last one */
+  if (result && ret == GST_FLOW_EOS)
+    ret = GST_FLOW_OK;
+
+  if (ret != GST_FLOW_OK && result) {
+    gst_buffer_unref (result);
+    result = NULL;
+  }
+
+  *chunk = result;
+  return ret;
+}
+
+static gpointer
+worker_func (GstHttpSegmentWorker * worker)
+{
+  GstHttpSegmentSrc *src = worker->src;
+
+  g_mutex_lock (&src->lock);
+  while (src->running) {
+    GstBuffer *chunk = NULL;
+    GstFlowReturn ret;
+    guint64 offset;
+    gint64 duration;
+    guint generation;
+
+    if (src->error != GST_FLOW_OK
+        || src->fetch_offset >= MIN (src->size, src->eos_offset)
+        || src->fetch_offset >= src->read_offset + FETCH_WINDOW (src)) {
+      g_cond_wait (&src->cond, &src->lock);
+      continue;
+    }
+
+    offset = src->fetch_offset;
+    src->fetch_offset += src->chunk_size;
+    generation = src->generation;
+    if (!src->start_time)
+      src->start_time = g_get_monotonic_time ();
+    g_mutex_unlock (&src->lock);
+
+    GST_LOG_OBJECT (worker->soup, "fetching %" G_GUINT64_FORMAT "+%u", offset,
+        src->chunk_size);
+    ret = fetch_chunk (worker, offset, src->chunk_size, &chunk);
+
+    if (!gst_pad_query_duration (worker->pad, GST_FORMAT_BYTES, &duration))
+      duration = -1;
+
+    g_mutex_lock (&src->lock);
+    if (duration > 0)
+      src->size = duration;
+
+    if (generation != src->generation) {
+      /* seeked away in the meantime */
+      if (chunk)
+        gst_buffer_unref (chunk);
+      continue;
+    }
+
+    if (chunk) {
+      gsize len = gst_buffer_get_size (chunk);
+      gint64 elapsed = g_get_monotonic_time () - src->start_time;
+
+      if (len < src->chunk_size)
+        src->eos_offset = MIN (src->eos_offset, offset + len);
+
+      src->bytes += len;
+      if (elapsed > 0)
+        src->throughput = gst_util_uint64_scale (src->bytes, G_USEC_PER_SEC,
+            elapsed);
+
+      g_hash_table_insert (src->chunks, g_memdup (&offset, sizeof (offset)),
+          chunk);
+    } else if (ret == GST_FLOW_EOS) {
+      src->eos_offset = MIN (src->eos_offset, offset);
+    } else if (ret != GST_FLOW_FLUSHING) {
+      GST_WARNING_OBJECT (worker->soup, "fetching %" G_GUINT64_FORMAT
+          " failed: %s", offset, gst_flow_get_name (ret));
+      src->error = ret;
+    }
+    g_cond_broadcast (&src->cond);
+  }
+  g_mutex_unlock (&src->lock);
+
+  return NULL;
+}
+
+static GstHttpSegmentWorker *
+create_worker (GstHttpSegmentSrc * src)
+{
+  GstHttpSegmentWorker *worker;
+  GstElement *soup;
+
+  if (!(soup = gst_element_factory_make ("souphttpsrc", NULL))) {
+    GST_WARNING_OBJECT (src, "Could not create a souphttpsrc element");
+    return NULL;
+  }
+  gst_object_ref_sink (soup);
+
+  GST_OBJECT_LOCK (src);
+  g_object_set (soup, "location", src->location, NULL);
+  if (src->smart_prop
+      && g_object_class_find_property (G_OBJECT_GET_CLASS (soup),
+          "smart-properties"))
+    g_object_set (soup, "smart-properties", src->smart_prop, NULL);
+  GST_OBJECT_UNLOCK (src);
+
+  worker = g_new0 (GstHttpSegmentWorker, 1);
+  worker->src = src;
+  worker->soup = soup;
+  worker->pad = gst_element_get_static_pad (soup, "src");
+
+  /* driving souphttpsrc in pull mode makes it issue range requests */
+  if (!gst_pad_activate_mode (worker->pad, GST_PAD_MODE_PULL, TRUE)) {
+    GST_WARNING_OBJECT (src, "souphttpsrc doesn't support range requests");
+    gst_object_unref (worker->pad);
+    gst_object_unref (worker->soup);
+    g_free (worker);
+    return NULL;
+  }
+
+  return worker;
+}
+
+static void
+free_workers (GstHttpSegmentSrc * src)
+{
+  guint i;
+
+  /* deactivating the pads cancels the pending requests */
+  for (i = 0; i < src->workers->len; i++) {
+    GstHttpSegmentWorker *worker = g_ptr_array_index (src->workers, i);
+
+    gst_pad_activate_mode (worker->pad, GST_PAD_MODE_PULL, FALSE);
+  }
+
+  for (i = 0; i < src->workers->len; i++) {
+    GstHttpSegmentWorker *worker = g_ptr_array_index (src->workers, i);
+
+    if (worker->thread)
+      g_thread_join (worker->thread);
+    gst_object_unref (worker->pad);
+    gst_object_unref (worker->soup);
+    g_free (worker);
+  }
+  g_ptr_array_set_size (src->workers, 0);
+}
+
+static gboolean
+gst_http_segment_src_start (GstBaseSrc * bsrc)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (bsrc);
+  guint i;
+
+  if (!src->location) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("No location set"));
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (src, "downloading %s over %u connections in chunks of %u",
+      src->location, src->connections, src->chunk_size);
+
+  src->running = TRUE;
+  src->flushing = FALSE;
+  src->error = GST_FLOW_OK;
+  src->read_offset = src->fetch_offset = 0;
+  src->size = src->eos_offset = SIZE_UNKNOWN;
+  src->bytes = 0;
+  src->start_time = 0;
+  src->throughput = 0;
+
+  for (i = 0; i < src->connections; i++) {
+    GstHttpSegmentWorker *worker = create_worker (src);
+
+    if (!worker) {
+      src->running = FALSE;
+      free_workers (src);
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+          ("Could not open %s for range requests", src->location));
+      return FALSE;
+    }
+    g_ptr_array_add (src->workers, worker);
+  }
+
+  for (i = 0; i < src->workers->len; i++) {
+    GstHttpSegmentWorker *worker = g_ptr_array_index (src->workers, i);
+
+    worker->thread = g_thread_new ("httpsegment",
+        (GThreadFunc) worker_func, worker);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_http_segment_src_stop (GstBaseSrc * bsrc)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  src->running = FALSE;
+  g_cond_broadcast (&src->cond);
+  g_mutex_unlock (&src->lock);
+
+  free_workers (src);
+  g_hash_table_remove_all (src->chunks);
+
+  return TRUE;
+}
+
+static gboolean
+gst_http_segment_src_get_size (GstBaseSrc * bsrc, guint64 * size)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (bsrc);
+  gboolean ret = FALSE;
+
+  g_mutex_lock (&src->lock);
+  if (src->size != SIZE_UNKNOWN) {
+    *size = src->size;
+    ret = TRUE;
+  }
+  g_mutex_unlock (&src->lock);
+
+  return ret;
+}
+
+static gboolean
+gst_http_segment_src_is_seekable (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+/* drop the downloaded chunks and go on from @offset, called with the lock */
+static void
+restart_download (GstHttpSegmentSrc * src, guint64 offset)
+{
+  src->generation++;
+  g_hash_table_remove_all (src->chunks);
+  src->read_offset = src->fetch_offset = offset;
+  src->eos_offset = SIZE_UNKNOWN;
+  src->error = GST_FLOW_OK;
+  g_cond_broadcast (&src->cond);
+}
+
+static gboolean
+gst_http_segment_src_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (bsrc);
+
+  GST_DEBUG_OBJECT (src, "seek to %" G_GUINT64_FORMAT, segment->start);
+
+  g_mutex_lock (&src->lock);
+  restart_download (src, segment->start);
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_http_segment_src_unlock (GstBaseSrc * bsrc)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  src->flushing = TRUE;
+  g_cond_broadcast (&src->cond);
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_http_segment_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  src->flushing = FALSE;
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+/* push the chunks in order, whichever connection finished first. When
+ * downstream pulls, at most @length bytes are returned and the rest of the
+ * chunk is kept for the next read. */
+static GstFlowReturn
+gst_http_segment_src_create (GstBaseSrc * bsrc, guint64 offset, guint length,
+    GstBuffer ** buf)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (bsrc);
+  GstFlowReturn ret = GST_FLOW_OK;
+  gpointer key, chunk = NULL;
+  gboolean pull;
+
+  pull = GST_PAD_MODE (GST_BASE_SRC_PAD (bsrc)) == GST_PAD_MODE_PULL;
+
+  g_mutex_lock (&src->lock);
+  if (offset != src->read_offset) {
+    GST_DEBUG_OBJECT (src, "read at %" G_GUINT64_FORMAT " instead of %"
+        G_GUINT64_FORMAT ", restarting", offset, src->read_offset);
+    restart_download (src, offset);
+  }
+
+  while (TRUE) {
+    if (src->flushing) {
+      ret = GST_FLOW_FLUSHING;
+      break;
+    }
+    if (g_hash_table_lookup_extended (src->chunks, &src->read_offset, &key,
+            &chunk)) {
+      g_hash_table_steal (src->chunks, key);
+      g_free (key);
+      break;
+    }
+    if (src->error != GST_FLOW_OK) {
+      ret = src->error;
+      break;
+    }
+    if (src->read_offset >= MIN (src->size, src->eos_offset)) {
+      ret = GST_FLOW_EOS;
+      break;
+    }
+    g_cond_wait (&src->cond, &src->lock);
+  }
+
+  if (chunk && pull && gst_buffer_get_size (chunk) > length) {
+    gsize size = gst_buffer_get_size (chunk);
+    guint64 rest_offset = src->read_offset + length;
+    GstBuffer *head;
+
+    g_hash_table_insert (src->chunks, g_memdup (&rest_offset,
+            sizeof (rest_offset)), gst_buffer_copy_region (chunk,
+            GST_BUFFER_COPY_ALL, length, size - length));
+    head = gst_buffer_copy_region (chunk, GST_BUFFER_COPY_ALL, 0, length);
+    gst_buffer_unref (chunk);
+    chunk = head;
+  }
+
+  if (chunk) {
+    GST_BUFFER_OFFSET (chunk) = src->read_offset;
+    src->read_offset += gst_buffer_get_size (chunk);
+    GST_BUFFER_OFFSET_END (chunk) = src->read_offset;
+    /* let the connections go on */
+    g_cond_broadcast (&src->cond);
+  }
+  g_mutex_unlock (&src->lock);
+
+  *buf = chunk;
+  return ret;
+}
+
+static GstURIType
+gst_http_segment_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_http_segment_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { "http", "https", NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_http_segment_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (handler);
+  gchar *uri;
+
+  GST_OBJECT_LOCK (src);
+  uri = g_strdup (src->location);
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_http_segment_src_uri_set_uri (GstURIHandler * handler, const gchar * uri,
+    GError ** error)
+{
+  GstHttpSegmentSrc *src = GST_HTTP_SEGMENT_SRC (handler);
+
+  GST_OBJECT_LOCK (src);
+  g_free (src->location);
+  src->location = g_strdup (uri);
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static void
+gst_http_segment_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_http_segment_src_uri_get_type;
+  iface->get_protocols = gst_http_segment_src_uri_get_protocols;
+  iface->get_uri = gst_http_segment_src_uri_get_uri;
+  iface->set_uri = gst_http_segment_src_uri_set_uri;
+}
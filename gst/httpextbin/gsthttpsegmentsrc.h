@@ -0,0 +1,84 @@
+/* GStreamer httpextbin element
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *  Author : HoonHee Lee <hoonhee.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_HTTP_SEGMENT_SRC_H__
+#define __GST_HTTP_SEGMENT_SRC_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesrc.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_HTTP_SEGMENT_SRC (gst_http_segment_src_get_type())
+#define GST_HTTP_SEGMENT_SRC(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_HTTP_SEGMENT_SRC,GstHttpSegmentSrc))
+#define GST_HTTP_SEGMENT_SRC_CLASS(obj) (G_TYPE_CHECK_CLASS_CAST((obj),GST_TYPE_HTTP_SEGMENT_SRC,GstHttpSegmentSrcClass))
+#define GST_IS_HTTP_SEGMENT_SRC(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_HTTP_SEGMENT_SRC))
+#define GST_IS_HTTP_SEGMENT_SRC_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE((obj),GST_TYPE_HTTP_SEGMENT_SRC))
+typedef struct _GstHttpSegmentSrc GstHttpSegmentSrc;
+typedef struct _GstHttpSegmentSrcClass GstHttpSegmentSrcClass;
+
+/**
+ * GstHttpSegmentSrc:
+ *
+ * Source which downloads a resource over several concurrent byte range
+ * requests and pushes the data in order.
+ */
+struct _GstHttpSegmentSrc
+{
+  GstBaseSrc parent;
+
+  gchar *location;
+  guint connections;
+  guint chunk_size;
+  GstStructure *smart_prop;
+
+  GMutex lock;
+  GCond cond;
+
+  GPtrArray *workers;
+  gboolean running;
+  gboolean flushing;
+  GstFlowReturn error;
+
+  /* next offset to push and next offset to download */
+  guint64 read_offset;
+  guint64 fetch_offset;
+  guint64 size;
+  guint64 eos_offset;
+  /* chunks downloaded before a seek are dropped */
+  guint generation;
+
+  /* chunk offset -> downloaded GstBuffer */
+  GHashTable *chunks;
+
+  /* throughput of all of connections */
+  guint64 bytes;
+  gint64 start_time;
+  guint64 throughput;
+};
+
+struct _GstHttpSegmentSrcClass
+{
+  GstBaseSrcClass parent_class;
+};
+
+GType gst_http_segment_src_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_HTTP_SEGMENT_SRC_H__ */
@@ -25,12 +25,22 @@
 #include <gst/gst.h>
 
 #include "gsthttpextbin.h"
+#include "gsthttpsegmentsrc.h"
+#include "gsthttpcachereader.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
-  return gst_element_register (plugin, "httpextbin",
-      GST_RANK_NONE, GST_TYPE_HTTP_EXT_BIN);
+  if (!gst_element_register (plugin, "httpextbin",
+          GST_RANK_NONE, GST_TYPE_HTTP_EXT_BIN))
+    return FALSE;
+
+  if (!gst_element_register (plugin, "httpsegmentsrc",
+          GST_RANK_NONE, GST_TYPE_HTTP_SEGMENT_SRC))
+    return FALSE;
+
+  return gst_element_register (plugin, "httpcachereader",
+      GST_RANK_NONE, GST_TYPE_HTTP_CACHE_READER);
 }
 
 GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
@@ -37,6 +37,8 @@
 
 #include "gststreamiddemux.h"
 
+#include <gst/cool/gstcool.h>
+
 GST_DEBUG_CATEGORY_STATIC (streamid_demux_debug);
 #define GST_CAT_DEFAULT streamid_demux_debug
 
@@ -44,9 +46,44 @@ enum
 {
   PROP_0,
   PROP_ACTIVE_PAD,
+  PROP_INTERLEAVED,
+  PROP_IDLE_TIMEOUT,
+  PROP_RECYCLE_PADS,
+  PROP_STATS,
+  PROP_SELECTED_STREAMS,
   PROP_LAST
 };
 
+#define DEFAULT_IDLE_TIMEOUT 0
+#define DEFAULT_RECYCLE_PADS FALSE
+
+/* buffers between two reads of the clock while a stream waits to time out */
+#define IDLE_CHECK_INTERVAL 32
+
+/* a stream and the srcpad it goes out of */
+struct _GstStreamidDemuxStream
+{
+  gchar *stream_id;
+  GstPad *srcpad;
+
+  /* time at which the stream stopped being active, see
+   * gst_streamid_demux_now() */
+  GstClockTime last_active;
+  /* srcpad of a pruned stream, downstream didn't accept the caps yet */
+  gboolean recycled;
+
+  /* traffic, only written by the streaming thread */
+  guint64 buffers;
+  guint64 bytes;
+  guint64 events;
+  GstClockTime last_timestamp;
+
+  /* an unselected stream has no srcpad until it's selected, its data is
+   * dropped and its sticky events are kept for the srcpad */
+  gboolean selected;
+  GList *sticky_events;
+};
+
 static GstStaticPadTemplate gst_streamid_demux_sink_factory =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -67,18 +104,25 @@ G_DEFINE_TYPE_WITH_CODE (GstStreamidDemux, gst_streamid_demux,
     GST_TYPE_ELEMENT, _do_init);
 
 static void gst_streamid_demux_dispose (GObject * object);
+static void gst_streamid_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
 static void gst_streamid_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static GstFlowReturn gst_streamid_demux_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_streamid_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_streamid_demux_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstStateChangeReturn gst_streamid_demux_change_state (GstElement *
     element, GstStateChange transition);
-static GstPad *gst_streamid_demux_get_srcpad_by_stream_id (GstStreamidDemux *
+static GstStreamidDemuxStream *gst_streamid_demux_get_stream (GstStreamidDemux *
     demux, const gchar * stream_id);
-static void gst_streamid_demux_srcpad_create (GstStreamidDemux * demux,
-    GstPad * pad, const gchar * stream_id);
+static GstStreamidDemuxStream
+    * gst_streamid_demux_stream_create (GstStreamidDemux * demux,
+    const gchar * stream_id, gboolean recycle);
+static void gst_streamid_demux_stream_free (GstStreamidDemuxStream * stream);
+static GstStructure *gst_streamid_demux_get_stats (GstStreamidDemux * demux);
 static void gst_streamid_demux_reset (GstStreamidDemux * demux);
 static void gst_streamid_demux_release_srcpad (const GValue * item,
     GstStreamidDemux * demux);
@@ -89,6 +133,7 @@ gst_streamid_demux_class_init (GstStreamidDemuxClass * klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->set_property = gst_streamid_demux_set_property;
   gobject_class->get_property = gst_streamid_demux_get_property;
   gobject_class->dispose = gst_streamid_demux_dispose;
 
@@ -97,6 +142,81 @@ gst_streamid_demux_class_init (GstStreamidDemuxClass * klass)
           "The currently active src pad", GST_TYPE_PAD,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstStreamidDemux:interleaved
+   *
+   * Route each buffer by the stream-id of its #GstCoolStreamMeta instead of
+   * the last stream-start. Buffers of streams which are interleaved on the
+   * sink pad then go to their own src pad without a stream-start per
+   * switch. A stream-start is still needed once per stream to create its
+   * pad, buffers of a stream without a pad are dropped. Buffers without
+   * the meta go to the active pad.
+   */
+  g_object_class_install_property (gobject_class, PROP_INTERLEAVED,
+      g_param_spec_boolean ("interleaved", "Interleaved",
+          "Route buffers by the stream-id meta on them", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux:idle-timeout
+   *
+   * Streams which haven't been active for this long are pruned, their
+   * srcpads get EOS and are removed. This is checked on every stream-start
+   * and, once the timeout of a stream ran out, with the next data, so the
+   * streams left behind go even when the active one never switches again.
+   * The time is taken from the clock of the element, or from the system
+   * clock when there is none. A new value applies to the streams which
+   * become inactive afterwards. 0 keeps every stream until PAUSED->READY.
+   */
+  g_object_class_install_property (gobject_class, PROP_IDLE_TIMEOUT,
+      g_param_spec_uint64 ("idle-timeout", "Idle timeout",
+          "Prune streams not active for this long in ns (0 = never)", 0,
+          G_MAXUINT64, DEFAULT_IDLE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux:recycle-pads
+   *
+   * Keep the srcpads of pruned streams, linked as they are, and hand them
+   * to new streams instead of adding new srcpads. A recycled srcpad is
+   * replaced by a new one when downstream doesn't accept the caps of its
+   * new stream.
+   */
+  g_object_class_install_property (gobject_class, PROP_RECYCLE_PADS,
+      g_param_spec_boolean ("recycle-pads", "Recycle pads",
+          "Reuse the srcpads of pruned streams for new streams",
+          DEFAULT_RECYCLE_PADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux:stats
+   *
+   * A "streamiddemux-stats" structure with the number of "switches" of the
+   * active pad and a "streams" array. It has a "stream" structure for each
+   * stream holding its "stream-id", the "srcpad" name, if any, whether it's
+   * "selected" and the "buffers", "bytes", "events" and "last-timestamp" it
+   * output. The counters are
+   * read while streaming goes on, so they are a snapshot. They restart on
+   * PAUSED->READY.
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Stats",
+          "Traffic statistics of each stream", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux:selected-streams
+   *
+   * Stream-ids which are output, NULL for all of them. The data of other
+   * streams is dropped and they get no srcpad. Once selected, a stream gets
+   * its srcpad with the next data, starting with the last sticky events of
+   * the stream. A deselected stream keeps its srcpad but its data is
+   * dropped.
+   */
+  g_object_class_install_property (gobject_class, PROP_SELECTED_STREAMS,
+      g_param_spec_boxed ("selected-streams", "Selected streams",
+          "Stream-ids to output (NULL = all)", G_TYPE_STRV,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Streamid Demux",
       "Generic", "1-to-N output stream by stream-id",
       "HoonHee Lee <hoonhee.lee@lge.com>");
@@ -117,6 +237,8 @@ gst_streamid_demux_init (GstStreamidDemux * demux)
       "sink");
   gst_pad_set_chain_function (demux->sinkpad,
       GST_DEBUG_FUNCPTR (gst_streamid_demux_chain));
+  gst_pad_set_chain_list_function (demux->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_streamid_demux_chain_list));
   gst_pad_set_event_function (demux->sinkpad,
       GST_DEBUG_FUNCPTR (gst_streamid_demux_event));
 
@@ -126,10 +248,14 @@ gst_streamid_demux_init (GstStreamidDemux * demux)
   demux->active_srcpad = NULL;
   demux->nb_srcpads = 0;
 
-  /* initialize hash table for srcpad */
+  /* initialize hash table for srcpad, the key is owned by the stream */
   demux->stream_id_pairs =
-      g_hash_table_new_full (g_str_hash, g_str_equal, (GDestroyNotify) g_free,
-      (GDestroyNotify) gst_object_unref);
+      g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) gst_streamid_demux_stream_free);
+
+  demux->idle_timeout = DEFAULT_IDLE_TIMEOUT;
+  demux->recycle_pads = DEFAULT_RECYCLE_PADS;
+  demux->next_idle_check = GST_CLOCK_TIME_NONE;
 }
 
 static void
@@ -139,9 +265,52 @@ gst_streamid_demux_dispose (GObject * object)
 
   gst_streamid_demux_reset (demux);
 
+  if (demux->stream_id_pairs != NULL) {
+    g_hash_table_unref (demux->stream_id_pairs);
+    demux->stream_id_pairs = NULL;
+  }
+
+  g_strfreev (demux->selected_streams);
+  demux->selected_streams = NULL;
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_streamid_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstStreamidDemux *demux = GST_STREAMID_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INTERLEAVED:
+      g_atomic_int_set (&demux->interleaved, g_value_get_boolean (value));
+      break;
+    case PROP_IDLE_TIMEOUT:
+      GST_OBJECT_LOCK (demux);
+      demux->idle_timeout = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_RECYCLE_PADS:
+      GST_OBJECT_LOCK (demux);
+      demux->recycle_pads = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_SELECTED_STREAMS:
+      GST_OBJECT_LOCK (demux);
+      g_strfreev (demux->selected_streams);
+      demux->selected_streams = g_value_dup_boxed (value);
+      GST_OBJECT_UNLOCK (demux);
+      /* the streaming thread applies it, see
+       * gst_streamid_demux_apply_selection() */
+      g_atomic_int_inc (&demux->selection_cookie);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_streamid_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -154,30 +323,178 @@ gst_streamid_demux_get_property (GObject * object, guint prop_id,
       g_value_set_object (value, demux->active_srcpad);
       GST_OBJECT_UNLOCK (demux);
       break;
+    case PROP_INTERLEAVED:
+      g_value_set_boolean (value, g_atomic_int_get (&demux->interleaved));
+      break;
+    case PROP_IDLE_TIMEOUT:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->idle_timeout);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_RECYCLE_PADS:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_boolean (value, demux->recycle_pads);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_streamid_demux_get_stats (demux));
+      break;
+    case PROP_SELECTED_STREAMS:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_boxed (value, demux->selected_streams);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* The active route is read by the streaming thread without any lock. It is
+ * only replaced from the streaming thread, on stream-start, or after the
+ * streaming stopped, so the pad can't be released under a push. Other
+ * threads read it with the object lock held. */
 static gboolean
-forward_sticky_events (GstPad * pad, GstEvent ** event, gpointer user_data)
+gst_streamid_demux_set_active_srcpad (GstStreamidDemux * demux,
+    GstPad * srcpad)
 {
-  GstPad *srcpad = GST_PAD_CAST (user_data);
+  GstPad *old_srcpad;
 
-  gst_pad_push_event (srcpad, gst_event_ref (*event));
+  GST_OBJECT_LOCK (demux);
+  old_srcpad = g_atomic_pointer_get (&demux->active_srcpad);
+  if (old_srcpad == srcpad) {
+    GST_OBJECT_UNLOCK (demux);
+    return FALSE;
+  }
+  g_atomic_pointer_set (&demux->active_srcpad,
+      srcpad ? gst_object_ref (srcpad) : NULL);
+  GST_OBJECT_UNLOCK (demux);
+
+  /* the previous route is released once nobody can reach it anymore */
+  if (old_srcpad)
+    gst_object_unref (old_srcpad);
 
   return TRUE;
 }
 
 static void
-gst_streamid_demux_srcpad_create (GstStreamidDemux * demux, GstPad * pad,
+gst_streamid_demux_stream_free (GstStreamidDemuxStream * stream)
+{
+  if (stream->srcpad)
+    gst_object_unref (stream->srcpad);
+  g_list_free_full (stream->sticky_events, (GDestroyNotify) gst_event_unref);
+  g_free (stream->stream_id);
+  g_slice_free (GstStreamidDemuxStream, stream);
+}
+
+/* idle time is taken from the clock of the element, so that it follows a
+ * test clock, or from the system clock before there is one */
+static GstClockTime
+gst_streamid_demux_now (GstStreamidDemux * demux)
+{
+  GstClock *clock;
+  GstClockTime now;
+
+  if (!(clock = gst_element_get_clock (GST_ELEMENT_CAST (demux))))
+    clock = gst_system_clock_obtain ();
+
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+
+  return now;
+}
+
+static inline void
+gst_streamid_demux_stream_account (GstStreamidDemuxStream * stream,
+    GstBuffer * buf)
+{
+  stream->buffers++;
+  stream->bytes += gst_buffer_get_size (buf);
+  if (GST_BUFFER_PTS_IS_VALID (buf))
+    stream->last_timestamp = GST_BUFFER_PTS (buf);
+}
+
+static GstStructure *
+gst_streamid_demux_get_stats (GstStreamidDemux * demux)
+{
+  GstStructure *stats;
+  GHashTableIter iter;
+  GstStreamidDemuxStream *stream;
+  GValue streams = { 0, };
+
+  stats = gst_structure_new ("streamiddemux-stats",
+      "switches", G_TYPE_UINT, g_atomic_int_get (&demux->switches), NULL);
+
+  /* stream-ids are values rather than field names, which would be interned
+   * as quarks that are never freed */
+  g_value_init (&streams, GST_TYPE_ARRAY);
+
+  /* pruned streams are stolen from the table under the lock, so they
+   * aren't freed under us */
+  GST_OBJECT_LOCK (demux);
+  g_hash_table_iter_init (&iter, demux->stream_id_pairs);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stream)) {
+    GValue record = { 0, };
+
+    g_value_init (&record, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&record, gst_structure_new ("stream",
+            "stream-id", G_TYPE_STRING, stream->stream_id,
+            "srcpad", G_TYPE_STRING,
+            stream->srcpad ? GST_PAD_NAME (stream->srcpad) : NULL,
+            "selected", G_TYPE_BOOLEAN, stream->selected,
+            "buffers", G_TYPE_UINT64, stream->buffers,
+            "bytes", G_TYPE_UINT64, stream->bytes,
+            "events", G_TYPE_UINT64, stream->events,
+            "last-timestamp", G_TYPE_UINT64, stream->last_timestamp, NULL));
+    gst_value_array_append_value (&streams, &record);
+    g_value_unset (&record);
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  gst_structure_take_value (stats, "streams", &streams);
+
+  return stats;
+}
+
+static gboolean
+gst_streamid_demux_is_selected (GstStreamidDemux * demux,
     const gchar * stream_id)
+{
+  gboolean selected;
+  gchar **walk;
+
+  GST_OBJECT_LOCK (demux);
+  selected = demux->selected_streams == NULL;
+  for (walk = demux->selected_streams; !selected && walk && *walk; walk++)
+    selected = g_str_equal (*walk, stream_id);
+  GST_OBJECT_UNLOCK (demux);
+
+  return selected;
+}
+
+/* gives the stream a recycled srcpad when there is any and @recycle is
+ * set, a new one otherwise */
+static void
+gst_streamid_demux_stream_add_srcpad (GstStreamidDemux * demux,
+    GstStreamidDemuxStream * stream, gboolean recycle)
 {
   gchar *padname = NULL;
   GstPad *srcpad = NULL;
   GstPadTemplate *pad_tmpl = NULL;
 
+  if (recycle && demux->free_srcpads) {
+    GST_OBJECT_LOCK (demux);
+    stream->srcpad = demux->free_srcpads->data;
+    GST_OBJECT_UNLOCK (demux);
+    stream->recycled = TRUE;
+    demux->free_srcpads =
+        g_list_delete_link (demux->free_srcpads, demux->free_srcpads);
+
+    GST_INFO_OBJECT (stream->srcpad, "recycled for stream %s",
+        stream->stream_id);
+    return;
+  }
+
   padname = g_strdup_printf ("src_%u", demux->nb_srcpads++);
   pad_tmpl = gst_static_pad_template_get (&gst_streamid_demux_src_factory);
 
@@ -186,51 +503,459 @@ gst_streamid_demux_srcpad_create (GstStreamidDemux * demux, GstPad * pad,
   g_free (padname);
 
   GST_OBJECT_LOCK (demux);
-
-  demux->active_srcpad = srcpad;
-  g_hash_table_insert (demux->stream_id_pairs, g_strdup (stream_id),
-      gst_object_ref (srcpad));
+  stream->srcpad = gst_object_ref (srcpad);
   GST_OBJECT_UNLOCK (demux);
 
+  /* The sticky events of the sinkpad still belong to the previous stream,
+   * the new one gets its own stream-start, caps and segment as they come */
   gst_pad_set_active (srcpad, TRUE);
 
-  /* Forward sticky events to the new srcpad */
-  gst_pad_sticky_events_foreach (demux->sinkpad, forward_sticky_events, srcpad);
-
   gst_element_add_pad (GST_ELEMENT_CAST (demux), srcpad);
 }
 
+/* creates the stream and makes it active. A selected stream gets its
+ * srcpad right away, see gst_streamid_demux_stream_add_srcpad(). */
+static GstStreamidDemuxStream *
+gst_streamid_demux_stream_create (GstStreamidDemux * demux,
+    const gchar * stream_id, gboolean recycle)
+{
+  GstStreamidDemuxStream *stream;
+
+  stream = g_slice_new0 (GstStreamidDemuxStream);
+  stream->stream_id = g_strdup (stream_id);
+  stream->last_active = gst_streamid_demux_now (demux);
+  stream->last_timestamp = GST_CLOCK_TIME_NONE;
+  stream->selected = gst_streamid_demux_is_selected (demux, stream_id);
+
+  GST_OBJECT_LOCK (demux);
+  g_hash_table_insert (demux->stream_id_pairs, stream->stream_id, stream);
+  GST_OBJECT_UNLOCK (demux);
+
+  if (stream->selected)
+    gst_streamid_demux_stream_add_srcpad (demux, stream, recycle);
+  else
+    GST_INFO_OBJECT (demux, "stream %s is not selected", stream_id);
+
+  gst_streamid_demux_set_active_srcpad (demux, stream->srcpad);
+
+  return stream;
+}
+
+/* keeps the last sticky event of each type for the srcpad of an unselected
+ * stream */
+static void
+gst_streamid_demux_stream_keep_event (GstStreamidDemuxStream * stream,
+    GstEvent * event)
+{
+  GList *walk;
+
+  for (walk = stream->sticky_events; walk; walk = walk->next) {
+    if (GST_EVENT_TYPE (walk->data) == GST_EVENT_TYPE (event)) {
+      gst_event_unref (walk->data);
+      walk->data = event;
+      return;
+    }
+  }
+  stream->sticky_events = g_list_append (stream->sticky_events, event);
+}
+
+static void
+gst_streamid_demux_stream_select (GstStreamidDemux * demux,
+    GstStreamidDemuxStream * stream)
+{
+  GList *walk;
+
+  stream->selected = TRUE;
+  if (stream->srcpad)
+    return;
+
+  GST_INFO_OBJECT (demux, "stream %s is selected", stream->stream_id);
+
+  gst_streamid_demux_stream_add_srcpad (demux, stream, FALSE);
+
+  for (walk = stream->sticky_events; walk; walk = walk->next)
+    gst_pad_push_event (stream->srcpad, walk->data);
+  g_list_free (stream->sticky_events);
+  stream->sticky_events = NULL;
+
+  if (stream == demux->active_stream
+      && gst_streamid_demux_set_active_srcpad (demux, stream->srcpad))
+    g_object_notify (G_OBJECT (demux), "active-pad");
+}
+
+/* srcpads are only added by the streaming thread, so a new selection is
+ * applied here once some data or a serialized event comes */
+static void
+gst_streamid_demux_apply_selection (GstStreamidDemux * demux)
+{
+  GHashTableIter iter;
+  GstStreamidDemuxStream *stream;
+  gint cookie;
+
+  cookie = g_atomic_int_get (&demux->selection_cookie);
+  if (G_LIKELY (cookie == demux->applied_cookie))
+    return;
+  demux->applied_cookie = cookie;
+
+  g_hash_table_iter_init (&iter, demux->stream_id_pairs);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stream)) {
+    if (!gst_streamid_demux_is_selected (demux, stream->stream_id))
+      stream->selected = FALSE;
+    else if (!stream->selected || !stream->srcpad)
+      gst_streamid_demux_stream_select (demux, stream);
+  }
+}
+
+/* marks @stream as no longer active and schedules the idle check for it */
+static void
+gst_streamid_demux_stream_deactivate (GstStreamidDemux * demux,
+    GstStreamidDemuxStream * stream)
+{
+  guint64 idle_timeout;
+  GstClockTime timeout;
+
+  GST_OBJECT_LOCK (demux);
+  idle_timeout = demux->idle_timeout;
+  GST_OBJECT_UNLOCK (demux);
+
+  if (idle_timeout == 0)
+    return;
+
+  stream->last_active = gst_streamid_demux_now (demux);
+
+  /* a timeout beyond the range of the clock never runs out */
+  timeout = stream->last_active + idle_timeout;
+  if (timeout < stream->last_active)
+    return;
+
+  if (!GST_CLOCK_TIME_IS_VALID (demux->next_idle_check)
+      || timeout < demux->next_idle_check)
+    demux->next_idle_check = timeout;
+}
+
+static void
+gst_streamid_demux_remove_srcpad (GstStreamidDemux * demux, GstPad * srcpad)
+{
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+  gst_pad_set_active (srcpad, FALSE);
+  gst_element_remove_pad (GST_ELEMENT_CAST (demux), srcpad);
+}
+
+/* Streams not active for idle-timeout are dropped, their srcpads are kept
+ * for new streams with recycle-pads or removed otherwise. This only runs
+ * on the streaming thread, see gst_streamid_demux_set_active_srcpad().
+ * The next check is scheduled for the first of the streams left to time
+ * out. */
+static void
+gst_streamid_demux_prune_idle_streams (GstStreamidDemux * demux,
+    GstStreamidDemuxStream * keep)
+{
+  GHashTableIter iter;
+  GstStreamidDemuxStream *stream;
+  GList *pruned = NULL, *walk;
+  gboolean recycle;
+  guint64 idle_timeout;
+  GstClockTime now, timeout;
+
+  demux->next_idle_check = GST_CLOCK_TIME_NONE;
+
+  GST_OBJECT_LOCK (demux);
+  idle_timeout = demux->idle_timeout;
+  recycle = demux->recycle_pads;
+  GST_OBJECT_UNLOCK (demux);
+
+  if (idle_timeout == 0)
+    return;
+
+  /* the clock is looked up under the object lock */
+  now = gst_streamid_demux_now (demux);
+
+  GST_OBJECT_LOCK (demux);
+  g_hash_table_iter_init (&iter, demux->stream_id_pairs);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stream)) {
+    if (stream == keep || stream == demux->active_stream
+        || stream == demux->last_stream)
+      continue;
+
+    /* the clock of the element changed meanwhile, start over */
+    if (stream->last_active > now)
+      stream->last_active = now;
+
+    timeout = stream->last_active + idle_timeout;
+    if (timeout < stream->last_active)
+      continue;
+
+    if (now < timeout) {
+      if (!GST_CLOCK_TIME_IS_VALID (demux->next_idle_check)
+          || timeout < demux->next_idle_check)
+        demux->next_idle_check = timeout;
+      continue;
+    }
+
+    g_hash_table_iter_steal (&iter);
+    pruned = g_list_prepend (pruned, stream);
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  for (walk = pruned; walk; walk = walk->next) {
+    stream = walk->data;
+
+    if (!stream->srcpad) {
+      GST_INFO_OBJECT (demux, "unselected stream %s is idle, dropping it",
+          stream->stream_id);
+      gst_streamid_demux_stream_free (stream);
+      continue;
+    }
+
+    GST_INFO_OBJECT (stream->srcpad, "stream %s is idle, %s",
+        stream->stream_id, recycle ? "recycling srcpad" : "removing srcpad");
+
+    if (recycle)
+      demux->free_srcpads =
+          g_list_prepend (demux->free_srcpads,
+          gst_object_ref (stream->srcpad));
+    else
+      gst_streamid_demux_remove_srcpad (demux, stream->srcpad);
+
+    gst_streamid_demux_stream_free (stream);
+  }
+  g_list_free (pruned);
+}
+
+/* a recycled srcpad is kept when downstream accepts the caps of its new
+ * stream, the stream moves to a new srcpad otherwise */
+static void
+gst_streamid_demux_check_recycled_caps (GstStreamidDemux * demux,
+    GstEvent * event)
+{
+  GstStreamidDemuxStream *stream = demux->active_stream;
+  GstPad *old_srcpad;
+  GstEvent *stream_start;
+  GstCaps *caps;
+  gchar *stream_id;
+
+  stream->recycled = FALSE;
+
+  gst_event_parse_caps (event, &caps);
+  if (gst_pad_peer_query_accept_caps (stream->srcpad, caps))
+    return;
+
+  GST_INFO_OBJECT (stream->srcpad, "%" GST_PTR_FORMAT " not accepted, "
+      "moving stream %s to a new srcpad", caps, stream->stream_id);
+
+  old_srcpad = gst_object_ref (stream->srcpad);
+  stream_start =
+      gst_pad_get_sticky_event (old_srcpad, GST_EVENT_STREAM_START, 0);
+  stream_id = g_strdup (stream->stream_id);
+
+  if (demux->last_stream == stream) {
+    demux->last_stream_id = 0;
+    demux->last_stream = NULL;
+  }
+  demux->active_stream = NULL;
+
+  GST_OBJECT_LOCK (demux);
+  g_hash_table_remove (demux->stream_id_pairs, stream_id);
+  GST_OBJECT_UNLOCK (demux);
+
+  gst_streamid_demux_remove_srcpad (demux, old_srcpad);
+  gst_object_unref (old_srcpad);
+
+  demux->active_stream =
+      gst_streamid_demux_stream_create (demux, stream_id, FALSE);
+  if (stream_start && demux->active_stream->srcpad)
+    gst_pad_push_event (demux->active_stream->srcpad, stream_start);
+  else if (stream_start)
+    gst_streamid_demux_stream_keep_event (demux->active_stream, stream_start);
+
+  g_free (stream_id);
+}
+
+/* prunes the streams which timed out since the last stream-start. While
+ * one of them is waiting to time out the clock is only read once every
+ * IDLE_CHECK_INTERVAL buffers, @n_buffers came in since the last call. */
+static inline void
+gst_streamid_demux_check_idle_streams (GstStreamidDemux * demux,
+    guint n_buffers)
+{
+  if (G_LIKELY (!GST_CLOCK_TIME_IS_VALID (demux->next_idle_check)))
+    return;
+
+  if (demux->idle_check_countdown > n_buffers) {
+    demux->idle_check_countdown -= n_buffers;
+    return;
+  }
+  demux->idle_check_countdown = IDLE_CHECK_INTERVAL;
+
+  if (gst_streamid_demux_now (demux) >= demux->next_idle_check)
+    gst_streamid_demux_prune_idle_streams (demux, NULL);
+}
+
+/* src pad of the stream tagged on @buf, the active pad when there is no
+ * tag. NULL when the tagged stream has no pad yet, the buffer is dropped
+ * then. The stream-id table is only changed by the streaming thread, so
+ * it's read here without lock. */
+static GstStreamidDemuxStream *
+gst_streamid_demux_route_buffer (GstStreamidDemux * demux, GstBuffer * buf)
+{
+  GstCoolStreamMeta *meta;
+  GstStreamidDemuxStream *stream;
+
+  if (!(meta = gst_buffer_get_cool_stream_meta (buf)))
+    return demux->active_stream;
+
+  if (meta->stream_id == demux->last_stream_id)
+    return demux->last_stream;
+
+  stream = g_hash_table_lookup (demux->stream_id_pairs,
+      g_quark_to_string (meta->stream_id));
+  if (!stream) {
+    GST_WARNING_OBJECT (demux, "no pad for stream %s, dropping buffer",
+        g_quark_to_string (meta->stream_id));
+    return NULL;
+  }
+
+  if (demux->last_stream)
+    gst_streamid_demux_stream_deactivate (demux, demux->last_stream);
+  demux->last_stream_id = meta->stream_id;
+  demux->last_stream = stream;
+
+  return stream;
+}
+
+static GstFlowReturn
+gst_streamid_demux_push_list (GstStreamidDemux * demux,
+    GstStreamidDemuxStream * stream, GstBufferList * list)
+{
+  guint i, len;
+
+  if (G_UNLIKELY (!stream || !stream->selected)) {
+    gst_buffer_list_unref (list);
+    return GST_FLOW_OK;
+  }
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    gst_streamid_demux_stream_account (stream, gst_buffer_list_get (list, i));
+
+  GST_LOG_OBJECT (demux, "pushing list of %u buffers to %" GST_PTR_FORMAT,
+      len, stream->srcpad);
+
+  return gst_pad_push_list (stream->srcpad, list);
+}
+
+/* a list of interleaved streams is split into runs of buffers going to the
+ * same pad, it's pushed as is when all of it goes to one pad */
+static GstFlowReturn
+gst_streamid_demux_push_interleaved_list (GstStreamidDemux * demux,
+    GstBufferList * list)
+{
+  GstFlowReturn res = GST_FLOW_OK;
+  GstBufferList *run;
+  GstStreamidDemuxStream *run_stream, *stream;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  if (len == 0)
+    return gst_streamid_demux_push_list (demux, NULL, list);
+
+  run_stream = gst_streamid_demux_route_buffer (demux,
+      gst_buffer_list_get (list, 0));
+  for (i = 1; i < len; i++) {
+    stream = gst_streamid_demux_route_buffer (demux,
+        gst_buffer_list_get (list, i));
+    if (stream != run_stream)
+      break;
+  }
+
+  if (i == len)
+    return gst_streamid_demux_push_list (demux, run_stream, list);
+
+  run = gst_buffer_list_new_sized (i);
+  for (i = 0; i < len && res == GST_FLOW_OK; i++) {
+    GstBuffer *buf = gst_buffer_list_get (list, i);
+
+    stream = gst_streamid_demux_route_buffer (demux, buf);
+    if (stream != run_stream) {
+      res = gst_streamid_demux_push_list (demux, run_stream, run);
+      run = gst_buffer_list_new ();
+      run_stream = stream;
+    }
+    gst_buffer_list_add (run, gst_buffer_ref (buf));
+  }
+
+  if (res == GST_FLOW_OK)
+    res = gst_streamid_demux_push_list (demux, run_stream, run);
+  else
+    gst_buffer_list_unref (run);
+
+  gst_buffer_list_unref (list);
+
+  return res;
+}
+
 static GstFlowReturn
 gst_streamid_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstFlowReturn res = GST_FLOW_OK;
   GstStreamidDemux *demux = NULL;
-  GstPad *srcpad = NULL;
+  GstStreamidDemuxStream *stream = NULL;
 
   demux = GST_STREAMID_DEMUX (parent);
 
-  GST_LOG_OBJECT (demux, "pushing buffer to %" GST_PTR_FORMAT,
-      demux->active_srcpad);
-
-  GST_OBJECT_LOCK (demux);
-  if (demux->active_srcpad) {
-    srcpad = gst_object_ref (demux->active_srcpad);
-    GST_OBJECT_UNLOCK (demux);
-    res = gst_pad_push (srcpad, buf);
-    gst_object_unref (srcpad);
+  gst_streamid_demux_apply_selection (demux);
+  gst_streamid_demux_check_idle_streams (demux, 1);
+
+  /* no lock and no ref, the active stream only changes on this thread,
+   * see gst_streamid_demux_set_active_srcpad() */
+  if (g_atomic_int_get (&demux->interleaved))
+    stream = gst_streamid_demux_route_buffer (demux, buf);
+  else
+    stream = demux->active_stream;
+
+  if (G_LIKELY (stream && stream->selected)) {
+    GST_LOG_OBJECT (demux, "pushing buffer to %" GST_PTR_FORMAT,
+        stream->srcpad);
+    gst_streamid_demux_stream_account (stream, buf);
+    res = gst_pad_push (stream->srcpad, buf);
   } else {
-    GST_OBJECT_UNLOCK (demux);
+    gst_buffer_unref (buf);
   }
 
   GST_LOG_OBJECT (demux, "handled buffer %s", gst_flow_get_name (res));
   return res;
 }
 
-static GstPad *
-gst_streamid_demux_get_srcpad_by_stream_id (GstStreamidDemux * demux,
+/* streams only switch on stream-start, which can't be inside of a list, so
+ * the whole list goes to the active pad in one push. Interleaved streams
+ * are split at the boundaries between them. */
+static GstFlowReturn
+gst_streamid_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstFlowReturn res = GST_FLOW_OK;
+  GstStreamidDemux *demux = NULL;
+
+  demux = GST_STREAMID_DEMUX (parent);
+
+  gst_streamid_demux_apply_selection (demux);
+  gst_streamid_demux_check_idle_streams (demux,
+      gst_buffer_list_length (list));
+
+  if (g_atomic_int_get (&demux->interleaved))
+    res = gst_streamid_demux_push_interleaved_list (demux, list);
+  else
+    res = gst_streamid_demux_push_list (demux, demux->active_stream, list);
+
+  GST_LOG_OBJECT (demux, "handled list %s", gst_flow_get_name (res));
+  return res;
+}
+
+static GstStreamidDemuxStream *
+gst_streamid_demux_get_stream (GstStreamidDemux * demux,
     const gchar * stream_id)
 {
-  GstPad *srcpad = NULL;
+  GstStreamidDemuxStream *stream = NULL;
 
   GST_DEBUG_OBJECT (demux, "stream_id = %s", stream_id);
   if (demux->stream_id_pairs == NULL || stream_id == NULL) {
@@ -238,14 +963,102 @@ gst_streamid_demux_get_srcpad_by_stream_id (GstStreamidDemux * demux,
   }
 
   GST_OBJECT_LOCK (demux);
-  srcpad = g_hash_table_lookup (demux->stream_id_pairs, stream_id);
+  stream = g_hash_table_lookup (demux->stream_id_pairs, stream_id);
   GST_OBJECT_UNLOCK (demux);
 
-  if (srcpad)
-    GST_DEBUG_OBJECT (srcpad, "srcpad matched");
+  if (stream)
+    GST_DEBUG_OBJECT (stream->srcpad, "srcpad matched");
 
 done:
-  return srcpad;
+  return stream;
+}
+
+static gboolean
+segment_is_equal (const GstSegment * s0, const GstSegment * s1)
+{
+  return s0->flags == s1->flags && s0->rate == s1->rate
+      && s0->applied_rate == s1->applied_rate && s0->format == s1->format
+      && s0->base == s1->base && s0->offset == s1->offset
+      && s0->start == s1->start && s0->stop == s1->stop
+      && s0->time == s1->time && s0->position == s1->position
+      && s0->duration == s1->duration;
+}
+
+/* Each srcpad keeps the sticky events of its own stream. When a known
+ * stream becomes active again, upstream resends its sticky events and
+ * only those which differ from the ones of the srcpad are pushed, so
+ * downstream doesn't renegotiate on every switch. */
+static gboolean
+gst_streamid_demux_sticky_event_is_cached (GstPad * srcpad, GstEvent * event)
+{
+  GstEvent *cached;
+  gboolean equal = FALSE;
+
+  if (!GST_EVENT_IS_STICKY (event) || GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    return FALSE;
+
+  if (!(cached = gst_pad_get_sticky_event (srcpad, GST_EVENT_TYPE (event), 0)))
+    return FALSE;
+
+  if (cached == event) {
+    equal = TRUE;
+    goto done;
+  }
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_STREAM_START:
+    {
+      const gchar *id0 = NULL, *id1 = NULL;
+      guint group0 = 0, group1 = 0;
+
+      gst_event_parse_stream_start (cached, &id0);
+      gst_event_parse_stream_start (event, &id1);
+      gst_event_parse_group_id (cached, &group0);
+      gst_event_parse_group_id (event, &group1);
+      equal = g_strcmp0 (id0, id1) == 0 && group0 == group1;
+      break;
+    }
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps0, *caps1;
+
+      gst_event_parse_caps (cached, &caps0);
+      gst_event_parse_caps (event, &caps1);
+      equal = gst_caps_is_equal (caps0, caps1);
+      break;
+    }
+    case GST_EVENT_SEGMENT:
+    {
+      const GstSegment *segment0, *segment1;
+
+      gst_event_parse_segment (cached, &segment0);
+      gst_event_parse_segment (event, &segment1);
+      equal = segment_is_equal (segment0, segment1);
+      break;
+    }
+    case GST_EVENT_TAG:
+    {
+      GstTagList *tags0, *tags1;
+
+      gst_event_parse_tag (cached, &tags0);
+      gst_event_parse_tag (event, &tags1);
+      equal = gst_tag_list_is_equal (tags0, tags1);
+      break;
+    }
+    default:
+    {
+      const GstStructure *s0 = gst_event_get_structure (cached);
+      const GstStructure *s1 = gst_event_get_structure (event);
+
+      equal = s0 && s1 && gst_structure_is_equal (s0, s1);
+      break;
+    }
+  }
+
+done:
+  gst_event_unref (cached);
+
+  return equal;
 }
 
 static gboolean
@@ -254,6 +1067,7 @@ gst_streamid_demux_event (GstPad * pad, GstObject * parent, GstEvent * event)
   gboolean res = TRUE;
   GstStreamidDemux *demux;
   const gchar *stream_id = NULL;
+  GstStreamidDemuxStream *stream = NULL;
   GstPad *active_srcpad = NULL;
 
   demux = GST_STREAMID_DEMUX (parent);
@@ -261,39 +1075,72 @@ gst_streamid_demux_event (GstPad * pad, GstObject * parent, GstEvent * event)
   GST_DEBUG_OBJECT (demux, "event = %s, sticky = %d",
       GST_EVENT_TYPE_NAME (event), GST_EVENT_IS_STICKY (event));
 
+  /* flush-start comes from another thread while the streaming thread may
+   * be routing, only serialized events may change the routes */
+  if (GST_EVENT_IS_SERIALIZED (event))
+    gst_streamid_demux_apply_selection (demux);
+
   if (GST_EVENT_TYPE (event) == GST_EVENT_STREAM_START) {
     gst_event_parse_stream_start (event, &stream_id);
     if (!stream_id)
       goto no_stream_id;
 
-    active_srcpad =
-        gst_streamid_demux_get_srcpad_by_stream_id (demux, stream_id);
-    if (!active_srcpad) {
-      gst_streamid_demux_srcpad_create (demux, pad, stream_id);
-    } else if (demux->active_srcpad != active_srcpad) {
+    stream = gst_streamid_demux_get_stream (demux, stream_id);
+    if (stream != demux->active_stream) {
+      gboolean recycle;
+
+      gst_streamid_demux_prune_idle_streams (demux, stream);
+
+      if (demux->active_stream)
+        gst_streamid_demux_stream_deactivate (demux, demux->active_stream);
+
       GST_OBJECT_LOCK (demux);
-      demux->active_srcpad = active_srcpad;
+      recycle = demux->recycle_pads;
       GST_OBJECT_UNLOCK (demux);
 
-      g_object_notify (G_OBJECT (demux), "active-pad");
+      if (!stream) {
+        demux->active_stream =
+            gst_streamid_demux_stream_create (demux, stream_id, recycle);
+      } else {
+        demux->active_stream = stream;
+        if (gst_streamid_demux_set_active_srcpad (demux, stream->srcpad))
+          g_object_notify (G_OBJECT (demux), "active-pad");
+      }
+      g_atomic_int_inc (&demux->switches);
     }
   }
 
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS && demux->active_stream
+      && demux->active_stream->recycled)
+    gst_streamid_demux_check_recycled_caps (demux, event);
+
+  /* read the route once, it can't change under us on this thread */
+  active_srcpad = g_atomic_pointer_get (&demux->active_srcpad);
+
   if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_START
       || GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP
       || GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
     res = gst_pad_event_default (pad, parent, event);
-  } else if (demux->active_srcpad) {
-    GstPad *srcpad = NULL;
-    GST_OBJECT_LOCK (demux);
-    srcpad = gst_object_ref (demux->active_srcpad);
-    GST_OBJECT_UNLOCK (demux);
-    res = gst_pad_push_event (srcpad, event);
-    gst_object_unref (srcpad);
+    goto done;
+  }
+
+  if (demux->active_stream)
+    demux->active_stream->events++;
+
+  if (active_srcpad
+      && gst_streamid_demux_sticky_event_is_cached (active_srcpad, event)) {
+    GST_DEBUG_OBJECT (active_srcpad, "%s is unchanged, not pushing it",
+        GST_EVENT_TYPE_NAME (event));
+    gst_event_unref (event);
+  } else if (active_srcpad) {
+    res = gst_pad_push_event (active_srcpad, event);
+  } else if (demux->active_stream && GST_EVENT_IS_STICKY (event)) {
+    gst_streamid_demux_stream_keep_event (demux->active_stream, event);
   } else {
     gst_event_unref (event);
   }
 
+done:
   return res;
 
   /* ERRORS */
@@ -325,15 +1172,23 @@ gst_streamid_demux_reset (GstStreamidDemux * demux)
   GstIterator *it = NULL;
   GstIteratorResult itret = GST_ITERATOR_OK;
 
-  GST_OBJECT_LOCK (demux);
-  if (demux->active_srcpad != NULL)
-    demux->active_srcpad = NULL;
+  gst_streamid_demux_set_active_srcpad (demux, NULL);
 
-  GST_OBJECT_UNLOCK (demux);
+  demux->active_stream = NULL;
+  g_atomic_int_set (&demux->switches, 0);
+  demux->last_stream_id = 0;
+  demux->last_stream = NULL;
+  demux->next_idle_check = GST_CLOCK_TIME_NONE;
+
+  /* the recycled srcpads are removed with the others below */
+  g_list_free_full (demux->free_srcpads, gst_object_unref);
+  demux->free_srcpads = NULL;
 
+  /* the table is kept for the next start, only the pads go */
   if (demux->stream_id_pairs != NULL) {
-    g_hash_table_unref (demux->stream_id_pairs);
-    demux->stream_id_pairs = NULL;
+    GST_OBJECT_LOCK (demux);
+    g_hash_table_remove_all (demux->stream_id_pairs);
+    GST_OBJECT_UNLOCK (demux);
   }
 
   it = gst_element_iterate_src_pads (GST_ELEMENT_CAST (demux));
@@ -41,6 +41,7 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_STREAMID_DEMUX))
 typedef struct _GstStreamidDemux GstStreamidDemux;
 typedef struct _GstStreamidDemuxClass GstStreamidDemuxClass;
+typedef struct _GstStreamidDemuxStream GstStreamidDemuxStream;
 
 struct _GstStreamidDemux
 {
@@ -49,10 +50,38 @@ struct _GstStreamidDemux
   GstPad *sinkpad;
 
   guint nb_srcpads;
+  /* holds a reference, read without lock from the streaming thread */
   GstPad *active_srcpad;
 
-  /* This table contains srcpad and stream-id */
+  /* This table contains stream-id and GstStreamidDemuxStream */
   GHashTable *stream_id_pairs;
+  /* stream of the active srcpad, only used by the streaming thread */
+  GstStreamidDemuxStream *active_stream;
+  /* number of stream-starts which changed the active stream */
+  gint switches;
+
+  /* route buffers by their GstCoolStreamMeta */
+  gint interleaved;
+  /* last stream routed by meta, only used by the streaming thread */
+  GQuark last_stream_id;
+  GstStreamidDemuxStream *last_stream;
+
+  /* streams not active for idle_timeout are pruned, with recycle_pads
+   * their srcpads wait in free_srcpads for new streams */
+  guint64 idle_timeout;
+  gboolean recycle_pads;
+  GList *free_srcpads;
+  /* when the first inactive stream times out, GST_CLOCK_TIME_NONE when
+   * none does, and the number of buffers until it is compared with the
+   * clock again. Only used by the streaming thread. */
+  GstClockTime next_idle_check;
+  guint idle_check_countdown;
+
+  /* stream-ids which get a srcpad, NULL for all. The streaming thread
+   * applies a new selection when selection_cookie changed. */
+  gchar **selected_streams;
+  gint selection_cookie;
+  gint applied_cookie;
 };
 
 struct _GstStreamidDemuxClass
@@ -31,6 +31,8 @@
 
 #include "gsttextbin.h"
 
+#include <gst/cool/gstcool.h>
+
 GST_DEBUG_CATEGORY_STATIC (text_bin_debug);
 #define GST_CAT_DEFAULT text_bin_debug
 
@@ -39,9 +41,33 @@ GST_DEBUG_CATEGORY_STATIC (text_bin_debug);
 enum
 {
   PROP_0,
+  PROP_MAX_SIZE_BYTES,
+  PROP_MAX_SIZE_TIME,
+  PROP_STATS,
+  PROP_SELECTED_STREAMS,
+  PROP_IDLE_TIMEOUT,
+  PROP_RECYCLE_PADS,
   PROP_LAST
 };
 
+#define DEFAULT_MAX_SIZE_BYTES (1024 * 1024)
+#define DEFAULT_MAX_SIZE_TIME 0
+#define DEFAULT_IDLE_TIMEOUT 0
+#define DEFAULT_RECYCLE_PADS FALSE
+
+/* leaky values of queue */
+#define QUEUE_LEAKY_DOWNSTREAM 2
+
+struct _GstTextBinStream
+{
+  GstPad *demux_srcpad;
+  GstElement *queue;
+  GstPad *tsinkbin_sinkpad;
+
+  /* times the queue was full and dropped its oldest data */
+  gint overruns;
+};
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -58,6 +84,8 @@ static GstStateChangeReturn gst_text_bin_change_state (GstElement *
 static void setup_child_element (GstTextBin * bin);
 static void release_child_element (GstTextBin * bin);
 static void pad_added_cb (GstElement * element, GstPad * pad, GstTextBin * bin);
+static void pad_removed_cb (GstElement * element, GstPad * pad,
+    GstTextBin * bin);
 
 G_DEFINE_TYPE (GstTextBin, gst_text_bin, GST_TYPE_BIN);
 
@@ -74,6 +102,84 @@ gst_text_bin_class_init (GstTextBinClass * klass)
   gobject_class->get_property = gst_text_bin_get_property;
   gobject_class->finalize = gst_text_bin_finalize;
 
+  /**
+   * GstTextBin:max-size-bytes
+   *
+   * Limit of the data queued for each text stream. When a stream stalls,
+   * e.g. because the application stopped taking subtitles, its oldest data
+   * is dropped, as it is outdated by then. A share of the memory budget
+   * lowers it further. 0 is unlimited.
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_BYTES,
+      g_param_spec_uint ("max-size-bytes", "Max. size (bytes)",
+          "Max. amount of data queued per stream, the oldest is dropped "
+          "(0=unlimited)", 0, G_MAXUINT, DEFAULT_MAX_SIZE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTextBin:max-size-time
+   *
+   * Limit of the duration queued for each text stream, the oldest data is
+   * dropped beyond it. Subtitle files pushed ahead at once span most of the
+   * movie, so it's unlimited by default.
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_TIME,
+      g_param_spec_uint64 ("max-size-time", "Max. size (ns)",
+          "Max. duration queued per stream, the oldest is dropped "
+          "(0=unlimited)", 0, G_MAXUINT64, DEFAULT_MAX_SIZE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTextBin:stats
+   *
+   * A "textbin-stats" structure with the total number of "overruns" and a
+   * "streams" array. It has a "stream" structure for each stream holding
+   * its "stream-id", the "srcpad" of streamiddemux it comes from, and the
+   * "overruns" and current "level-bytes", "level-time" and "level-buffers"
+   * of its queue.
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Stats",
+          "Queue levels and overruns of each stream", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTextBin:selected-streams
+   *
+   * Stream-ids of the text tracks which are shown, NULL for all of them.
+   * The data of other tracks is dropped by streamiddemux, and the queue
+   * and tsinkbin branch of a track are only built once it's selected, so
+   * the cost follows the tracks shown rather than the tracks present.
+   */
+  g_object_class_install_property (gobject_class, PROP_SELECTED_STREAMS,
+      g_param_spec_boxed ("selected-streams", "Selected streams",
+          "Stream-ids of the text tracks to show (NULL = all)", G_TYPE_STRV,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTextBin:idle-timeout
+   *
+   * Text tracks which haven't been active for this long are pruned by
+   * streamiddemux, and their queue and tsinkbin branch are released. 0
+   * keeps every branch until PAUSED->READY.
+   */
+  g_object_class_install_property (gobject_class, PROP_IDLE_TIMEOUT,
+      g_param_spec_uint64 ("idle-timeout", "Idle timeout",
+          "Release the branch of a track not active for this long in ns "
+          "(0 = never)", 0, G_MAXUINT64, DEFAULT_IDLE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTextBin:recycle-pads
+   *
+   * Hand the branch of a pruned track to the next new track instead of
+   * releasing it and building a new one.
+   */
+  g_object_class_install_property (gobject_class, PROP_RECYCLE_PADS,
+      g_param_spec_boolean ("recycle-pads", "Recycle pads",
+          "Reuse the branches of pruned tracks for new tracks",
+          DEFAULT_RECYCLE_PADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&sink_template));
 
@@ -105,8 +211,14 @@ gst_text_bin_init (GstTextBin * bin)
   gst_object_unref (pad_tmpl);
 
   bin->streamiddemux = NULL;
-  bin->mq = NULL;
   bin->tsinkbin = NULL;
+  bin->streams = NULL;
+  bin->selected_streams = NULL;
+
+  bin->max_size_bytes = DEFAULT_MAX_SIZE_BYTES;
+  bin->max_size_time = DEFAULT_MAX_SIZE_TIME;
+  bin->idle_timeout = DEFAULT_IDLE_TIMEOUT;
+  bin->recycle_pads = DEFAULT_RECYCLE_PADS;
 }
 
 static void
@@ -118,15 +230,148 @@ gst_text_bin_finalize (GObject * self)
 
   release_child_element (bin);
 
+  g_strfreev (bin->selected_streams);
+
   G_OBJECT_CLASS (parent_class)->finalize (self);
 }
 
+/* the configured limit, lowered by the share of the memory budget */
+static void
+queue_budget_cb (GstElement * queue, guint64 share, GstTextBin * bin)
+{
+  guint64 limit;
+
+  GST_OBJECT_LOCK (bin);
+  limit = bin->max_size_bytes;
+  GST_OBJECT_UNLOCK (bin);
+
+  if (limit == 0 || share < limit)
+    limit = share;
+
+  g_object_set (queue, "max-size-bytes", (guint) MIN (limit, G_MAXUINT), NULL);
+}
+
+static void
+apply_queue_limits (GstTextBin * bin)
+{
+  GList *walk;
+  guint max_size_bytes;
+  guint64 max_size_time;
+
+  GST_OBJECT_LOCK (bin);
+  max_size_bytes = bin->max_size_bytes;
+  max_size_time = bin->max_size_time;
+  GST_OBJECT_UNLOCK (bin);
+
+  for (walk = bin->streams; walk; walk = walk->next) {
+    GstTextBinStream *stream = walk->data;
+
+    g_object_set (stream->queue, "max-size-bytes", max_size_bytes,
+        "max-size-time", max_size_time, NULL);
+    if (gst_cool_budget_get_share (stream->queue) > 0)
+      queue_budget_cb (stream->queue, gst_cool_budget_get_share
+          (stream->queue), bin);
+  }
+}
+
+static GstStructure *
+get_stats (GstTextBin * bin)
+{
+  GstStructure *stats;
+  GValue streams = { 0, };
+  GList *walk;
+
+  stats = gst_structure_new ("textbin-stats", "overruns", G_TYPE_UINT,
+      g_atomic_int_get (&bin->overruns), NULL);
+
+  /* like streamiddemux, streams are values of an array rather than fields,
+   * which would be interned as quarks that are never freed */
+  g_value_init (&streams, GST_TYPE_ARRAY);
+
+  for (walk = bin->streams; walk; walk = walk->next) {
+    GstTextBinStream *stream = walk->data;
+    GValue record = { 0, };
+    gchar *stream_id;
+    guint level_bytes = 0, level_buffers = 0;
+    guint64 level_time = 0;
+
+    g_object_get (stream->queue, "current-level-bytes", &level_bytes,
+        "current-level-time", &level_time, "current-level-buffers",
+        &level_buffers, NULL);
+    stream_id = gst_pad_get_stream_id (stream->demux_srcpad);
+
+    g_value_init (&record, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&record, gst_structure_new ("stream",
+            "stream-id", G_TYPE_STRING, stream_id,
+            "srcpad", G_TYPE_STRING, GST_PAD_NAME (stream->demux_srcpad),
+            "overruns", G_TYPE_UINT, g_atomic_int_get (&stream->overruns),
+            "level-bytes", G_TYPE_UINT, level_bytes,
+            "level-time", G_TYPE_UINT64, level_time,
+            "level-buffers", G_TYPE_UINT, level_buffers, NULL));
+    gst_value_array_append_value (&streams, &record);
+    g_value_unset (&record);
+    g_free (stream_id);
+  }
+
+  gst_structure_take_value (stats, "streams", &streams);
+
+  return stats;
+}
+
 static void
 gst_text_bin_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
-  //GstTextBin *bin = GST_TEXT_BIN (object);
+  GstTextBin *bin = GST_TEXT_BIN (object);
+
   switch (prop_id) {
+    case PROP_MAX_SIZE_BYTES:
+      GST_TEXT_BIN_LOCK (bin);
+      GST_OBJECT_LOCK (bin);
+      bin->max_size_bytes = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (bin);
+      apply_queue_limits (bin);
+      GST_TEXT_BIN_UNLOCK (bin);
+      break;
+    case PROP_MAX_SIZE_TIME:
+      GST_TEXT_BIN_LOCK (bin);
+      GST_OBJECT_LOCK (bin);
+      bin->max_size_time = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (bin);
+      apply_queue_limits (bin);
+      GST_TEXT_BIN_UNLOCK (bin);
+      break;
+    case PROP_SELECTED_STREAMS:
+      GST_TEXT_BIN_LOCK (bin);
+      GST_OBJECT_LOCK (bin);
+      g_strfreev (bin->selected_streams);
+      bin->selected_streams = g_value_dup_boxed (value);
+      GST_OBJECT_UNLOCK (bin);
+      if (bin->streamiddemux)
+        g_object_set (bin->streamiddemux, "selected-streams",
+            bin->selected_streams, NULL);
+      GST_TEXT_BIN_UNLOCK (bin);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      GST_TEXT_BIN_LOCK (bin);
+      GST_OBJECT_LOCK (bin);
+      bin->idle_timeout = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (bin);
+      if (bin->streamiddemux)
+        g_object_set (bin->streamiddemux, "idle-timeout", bin->idle_timeout,
+            NULL);
+      GST_TEXT_BIN_UNLOCK (bin);
+      break;
+    case PROP_RECYCLE_PADS:
+      GST_TEXT_BIN_LOCK (bin);
+      GST_OBJECT_LOCK (bin);
+      bin->recycle_pads = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (bin);
+      if (bin->streamiddemux)
+        g_object_set (bin->streamiddemux, "recycle-pads", bin->recycle_pads,
+            NULL);
+      GST_TEXT_BIN_UNLOCK (bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -137,9 +382,39 @@ static void
 gst_text_bin_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-  //GstTextBin *bin = GST_TEXT_BIN (object);
+  GstTextBin *bin = GST_TEXT_BIN (object);
 
   switch (prop_id) {
+    case PROP_MAX_SIZE_BYTES:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint (value, bin->max_size_bytes);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_MAX_SIZE_TIME:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->max_size_time);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_STATS:
+      GST_TEXT_BIN_LOCK (bin);
+      g_value_take_boxed (value, get_stats (bin));
+      GST_TEXT_BIN_UNLOCK (bin);
+      break;
+    case PROP_SELECTED_STREAMS:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_boxed (value, bin->selected_streams);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->idle_timeout);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_RECYCLE_PADS:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_boolean (value, bin->recycle_pads);
+      GST_OBJECT_UNLOCK (bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -160,13 +435,22 @@ setup_child_element (GstTextBin * bin)
 
   /* generate streamiddemux */
   bin->streamiddemux = gst_element_factory_make ("streamiddemux", NULL);
+  GST_TEXT_BIN_LOCK (bin);
+  g_object_set (bin->streamiddemux, "selected-streams",
+      bin->selected_streams, "idle-timeout", bin->idle_timeout,
+      "recycle-pads", bin->recycle_pads, NULL);
+  GST_TEXT_BIN_UNLOCK (bin);
   gst_element_set_state (bin->streamiddemux, GST_STATE_PAUSED);
   gst_bin_add (GST_BIN (bin), bin->streamiddemux);
   GST_DEBUG_OBJECT (bin, "generated streamiddemux");
 
-  /* add signal for pad-added from streamiddemux */
+  /* streamiddemux only adds a srcpad for a selected stream, so the
+   * branch of a track is built when it's first selected */
   g_signal_connect (G_OBJECT (bin->streamiddemux), "pad-added",
       G_CALLBACK (pad_added_cb), bin);
+  /* and it's released when streamiddemux prunes the idle track */
+  g_signal_connect (G_OBJECT (bin->streamiddemux), "pad-removed",
+      G_CALLBACK (pad_removed_cb), bin);
 
   /* try to target from ghost sinkpad to sinkpad of streamiddemux */
   sinkpad = gst_element_get_static_pad (bin->streamiddemux, "sink");
@@ -175,37 +459,48 @@ setup_child_element (GstTextBin * bin)
   g_object_unref (sinkpad);
 }
 
+/* unlinks and frees the queue and tsinkbin branch of @stream */
+static void
+release_stream (GstTextBin * bin, GstTextBinStream * stream)
+{
+  GstPad *sinkpad, *srcpad;
+
+  /* unlink streamiddemux, queue and tsinkbin */
+  GST_DEBUG_OBJECT (bin, "release %s", GST_ELEMENT_NAME (stream->queue));
+  sinkpad = gst_element_get_static_pad (stream->queue, "sink");
+  srcpad = gst_element_get_static_pad (stream->queue, "src");
+
+  gst_pad_unlink (stream->demux_srcpad, sinkpad);
+  if (stream->tsinkbin_sinkpad) {
+    /* textsink may hold the queue thread until PLAYING, let it go before
+     * the queue is stopped */
+    gst_pad_send_event (stream->tsinkbin_sinkpad,
+        gst_event_new_flush_start ());
+    gst_pad_unlink (srcpad, stream->tsinkbin_sinkpad);
+    gst_element_release_request_pad (bin->tsinkbin, stream->tsinkbin_sinkpad);
+    gst_object_unref (stream->tsinkbin_sinkpad);
+  }
+  gst_object_unref (sinkpad);
+  gst_object_unref (srcpad);
+
+  gst_cool_budget_unregister (stream->queue);
+  gst_element_set_state (stream->queue, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN_CAST (bin), stream->queue);
+
+  gst_object_unref (stream->demux_srcpad);
+  g_slice_free (GstTextBinStream, stream);
+}
+
 static void
 release_child_element (GstTextBin * bin)
 {
   GST_DEBUG_OBJECT (bin, "starts to release child elements");
 
-  if (bin->mq) {
-    GstIterator *it;
-    GValue data = { 0, };
-    /* unlink streamiddemux, multiqueue and tsinkbin */
-    GST_DEBUG_OBJECT (bin, "unlink mq and tsinkbin");
-    it = gst_element_iterate_pads (bin->mq);
-    while (gst_iterator_next (it, &data) == GST_ITERATOR_OK) {
-      GstPad *pad = g_value_get_object (&data);
-      GstPad *peerpad = gst_pad_get_peer (pad);
-
-      if (peerpad) {
-        GST_DEBUG_OBJECT (pad, "unlink to %s", GST_OBJECT_NAME (peerpad));
-        if (gst_pad_get_direction (pad) == GST_PAD_SRC) {
-          gst_pad_unlink (pad, peerpad);
-          gst_element_release_request_pad (bin->tsinkbin, peerpad);
-        } else if (gst_pad_get_direction (pad) == GST_PAD_SINK) {
-          gst_pad_unlink (peerpad, pad);
-          gst_element_release_request_pad (bin->mq, pad);
-        }
-        gst_object_unref (peerpad);
-      }
-      g_value_reset (&data);
-    }
-    g_value_unset (&data);
-    gst_iterator_free (it);
+  while (bin->streams) {
+    release_stream (bin, bin->streams->data);
+    bin->streams = g_list_delete_link (bin->streams, bin->streams);
   }
+  g_atomic_int_set (&bin->overruns, 0);
 
   if (bin->tsinkbin) {
     GST_DEBUG_OBJECT (bin, "release tsinkbin element");
@@ -214,13 +509,6 @@ release_child_element (GstTextBin * bin)
     bin->tsinkbin = NULL;
   }
 
-  if (bin->mq) {
-    GST_DEBUG_OBJECT (bin, "release mq element");
-    gst_element_set_state (bin->mq, GST_STATE_NULL);
-    gst_bin_remove (GST_BIN_CAST (bin), bin->mq);
-    bin->mq = NULL;
-  }
-
   if (bin->streamiddemux) {
     GST_DEBUG_OBJECT (bin, "unlink ghostpad and streamiddemux");
     gst_pad_set_active (bin->sinkpad, FALSE);
@@ -234,67 +522,62 @@ release_child_element (GstTextBin * bin)
   }
 }
 
+/* called from the streaming thread of the stream */
 static void
-pad_added_cb (GstElement * element, GstPad * pad, GstTextBin * bin)
+queue_overrun_cb (GstElement * queue, GstTextBinStream * stream)
 {
-  GstPad *mq_sinkpad = NULL;
-  GstPad *mq_srcpad = NULL;
-  GstPad *tsinkbin_sinkpad = NULL;
-  gchar *padname;
-  GstIterator *it = NULL;
-  gint nb_srcpad = 0;
-  GValue item = { 0, };
-
-  GST_DEBUG_OBJECT (pad, "new pad added in streamiddemux");
+  GstTextBin *bin = GST_TEXT_BIN (GST_ELEMENT_PARENT (queue));
 
-  GST_TEXT_BIN_LOCK (bin);
+  GST_INFO_OBJECT (queue, "full, dropping the oldest data");
 
-  /* generate multiqueue */
-  if (!bin->mq) {
-    bin->mq = gst_element_factory_make ("multiqueue", NULL);
-    /* No limits */
-    g_object_set (bin->mq,
-        "max-size-bytes", (guint) 0,
-        "max-size-buffers", (guint) 0,
-        "max-size-time", (guint64) 0,
-        "extra-size-bytes", (guint) 0,
-        "extra-size-buffers", (guint) 0, "extra-size-time", (guint64) 0, NULL);
-    gst_element_set_state (bin->mq, GST_STATE_PAUSED);
-    gst_bin_add (GST_BIN (bin), bin->mq);
-    GST_DEBUG_OBJECT (bin->mq, "generated multiqueue");
-  }
-
-  /* create multiqueue request pad */
-  mq_sinkpad = gst_element_get_request_pad (bin->mq, "sink_%u");
-  if (!mq_sinkpad) {
-    GST_TEXT_BIN_UNLOCK (bin);
-    GST_WARNING_OBJECT (bin, "failed to create multiqueue request pad");
-    return;
-  }
-
-  /* link to srcpad of streamiddemux to sinkpad of mq */
-  gst_pad_link_full (pad, mq_sinkpad, GST_PAD_LINK_CHECK_NOTHING);
+  g_atomic_int_inc (&stream->overruns);
+  g_atomic_int_inc (&bin->overruns);
+}
 
-  /* get number of srcpad in mq */
-  it = gst_element_iterate_src_pads (bin->mq);
+static void
+pad_added_cb (GstElement * element, GstPad * pad, GstTextBin * bin)
+{
+  GstTextBinStream *stream;
+  GstPad *queue_sinkpad = NULL;
+  GstPad *queue_srcpad = NULL;
+  guint max_size_bytes;
+  guint64 max_size_time;
 
-  while (it && gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
-    nb_srcpad++;
-    g_value_unset (&item);
-  }
-  gst_iterator_free (it);
-  GST_DEBUG_OBJECT (bin, "current number of srcpad in mq : %d", nb_srcpad);
+  GST_DEBUG_OBJECT (pad, "new pad added in streamiddemux");
 
-  /* get srcpad of mq */
-  padname = g_strdup_printf ("src_%u", --nb_srcpad);
-  mq_srcpad = gst_element_get_static_pad (bin->mq, padname);
-  g_free (padname);
+  GST_TEXT_BIN_LOCK (bin);
 
-  if (!mq_srcpad) {
-    GST_TEXT_BIN_UNLOCK (bin);
-    GST_WARNING_OBJECT (bin, "failed to get srcpad from mq");
-    return;
-  }
+  stream = g_slice_new0 (GstTextBinStream);
+  stream->demux_srcpad = gst_object_ref (pad);
+
+  /* generate a queue which drops the oldest data when it's full, subtitles
+   * which are late are useless anyway */
+  GST_OBJECT_LOCK (bin);
+  max_size_bytes = bin->max_size_bytes;
+  max_size_time = bin->max_size_time;
+  GST_OBJECT_UNLOCK (bin);
+
+  stream->queue = gst_element_factory_make ("queue", NULL);
+  g_object_set (stream->queue,
+      "max-size-bytes", max_size_bytes,
+      "max-size-buffers", (guint) 0,
+      "max-size-time", max_size_time,
+      "leaky", QUEUE_LEAKY_DOWNSTREAM, "silent", FALSE, NULL);
+  g_signal_connect (stream->queue, "overrun", G_CALLBACK (queue_overrun_cb),
+      stream);
+  gst_bin_add (GST_BIN (bin), stream->queue);
+  gst_element_sync_state_with_parent (stream->queue);
+  GST_DEBUG_OBJECT (stream->queue, "generated queue");
+
+  gst_cool_budget_register (stream->queue, GST_COOL_BUDGET_WEIGHT_TEXT,
+      (GstCoolBudgetFunc) queue_budget_cb, bin);
+
+  bin->streams = g_list_append (bin->streams, stream);
+
+  /* link to srcpad of streamiddemux to sinkpad of queue */
+  queue_sinkpad = gst_element_get_static_pad (stream->queue, "sink");
+  gst_pad_link_full (pad, queue_sinkpad, GST_PAD_LINK_CHECK_NOTHING);
+  gst_object_unref (queue_sinkpad);
 
   /* generate tsinkbin */
   if (!bin->tsinkbin) {
@@ -305,22 +588,51 @@ pad_added_cb (GstElement * element, GstPad * pad, GstTextBin * bin)
   }
 
   /* create tsinkbin request pad */
-  tsinkbin_sinkpad = gst_element_get_request_pad (bin->tsinkbin, "text_sink%d");
+  stream->tsinkbin_sinkpad =
+      gst_element_get_request_pad (bin->tsinkbin, "text_sink%d");
 
-  if (!tsinkbin_sinkpad) {
+  if (!stream->tsinkbin_sinkpad) {
     GST_TEXT_BIN_UNLOCK (bin);
     GST_WARNING_OBJECT (bin, "failed to create tsinkbin request pad");
     return;
   }
 
-  /* link to srcpad of mq to sinkpad of tsinkbin */
-  gst_pad_link_full (mq_srcpad, tsinkbin_sinkpad, GST_PAD_LINK_CHECK_NOTHING);
+  /* link to srcpad of queue to sinkpad of tsinkbin */
+  queue_srcpad = gst_element_get_static_pad (stream->queue, "src");
+  gst_pad_link_full (queue_srcpad, stream->tsinkbin_sinkpad,
+      GST_PAD_LINK_CHECK_NOTHING);
+  gst_object_unref (queue_srcpad);
+
+  GST_DEBUG_OBJECT (bin, "configured %u path", g_list_length (bin->streams));
+
+  GST_TEXT_BIN_UNLOCK (bin);
+}
+
+/* called from the streaming thread when streamiddemux pruned an idle
+ * track */
+static void
+pad_removed_cb (GstElement * element, GstPad * pad, GstTextBin * bin)
+{
+  GList *walk;
+
+  GST_TEXT_BIN_LOCK (bin);
 
-  g_object_unref (mq_sinkpad);
-  g_object_unref (mq_srcpad);
-  g_object_unref (tsinkbin_sinkpad);
+  /* on PAUSED->READY every branch is released at once afterwards */
+  if (bin->releasing) {
+    GST_TEXT_BIN_UNLOCK (bin);
+    return;
+  }
 
-  GST_DEBUG_OBJECT (bin, "configured %d path", nb_srcpad);
+  for (walk = bin->streams; walk; walk = walk->next) {
+    GstTextBinStream *stream = walk->data;
+
+    if (stream->demux_srcpad == pad) {
+      GST_DEBUG_OBJECT (pad, "track is idle, releasing its path");
+      bin->streams = g_list_delete_link (bin->streams, walk);
+      release_stream (bin, stream);
+      break;
+    }
+  }
 
   GST_TEXT_BIN_UNLOCK (bin);
 }
@@ -336,9 +648,17 @@ gst_text_bin_change_state (GstElement * element, GstStateChange transition)
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       GST_DEBUG ("ready to paused");
+      GST_TEXT_BIN_LOCK (bin);
+      bin->releasing = FALSE;
+      GST_TEXT_BIN_UNLOCK (bin);
       /* try to generate streamiddemux */
       setup_child_element (bin);
       break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_TEXT_BIN_LOCK (bin);
+      bin->releasing = TRUE;
+      GST_TEXT_BIN_UNLOCK (bin);
+      break;
     default:
       break;
   }
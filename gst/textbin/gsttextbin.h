@@ -37,6 +37,7 @@ G_BEGIN_DECLS
 #define GST_TEXT_BIN_UNLOCK(bin) (g_rec_mutex_unlock (GST_TEXT_BIN_GET_LOCK(bin)))
 typedef struct _GstTextBin GstTextBin;
 typedef struct _GstTextBinClass GstTextBinClass;
+typedef struct _GstTextBinStream GstTextBinStream;
 
 struct _GstTextBin
 {
@@ -47,8 +48,22 @@ struct _GstTextBin
   GstPad *sinkpad;
 
   GstElement *streamiddemux;
-  GstElement *mq;
   GstElement *tsinkbin;
+
+  /* a GstTextBinStream with a leaky queue per stream of streamiddemux */
+  GList *streams;
+  guint max_size_bytes;
+  guint64 max_size_time;
+  gint overruns;
+
+  /* stream-ids which get a branch, NULL for all */
+  gchar **selected_streams;
+
+  /* given to streamiddemux, the branch of a pruned stream is released */
+  guint64 idle_timeout;
+  gboolean recycle_pads;
+  /* set on PAUSED->READY, when every branch goes at once */
+  gboolean releasing;
 };
 
 struct _GstTextBinClass
@@ -0,0 +1,743 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *	Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * textsink takes every text stream on one element. Each sample goes from the
+ * streaming thread of its pad straight to the #GstCoolSubtitleFunc set on
+ * the pipeline, without a queue, an appsink and a bus message per stream.
+ * Like the appsinks did, nothing is delivered before PLAYING. Teletext is
+ * then synchronized to the clock, the other formats are delivered as they
+ * come so that the application can schedule them itself.
+ *
+ * With a batch window, the samples of a stream whose PTS are within the
+ * window of the first one are collected and delivered together, at the
+ * latest when the window ran out in clock time. Teletext is already
+ * synchronized, so each of its samples is a batch of its own.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gsttextsink.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_text_sink_debug);
+#define GST_CAT_DEFAULT gst_text_sink_debug
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+/* props */
+enum
+{
+  PROP_0,
+  PROP_BATCH_WINDOW,
+  PROP_LAST
+};
+
+#define DEFAULT_BATCH_WINDOW 0
+
+/* state of a sink pad, only used by its streaming thread except for
+ * flushing, eos, clock_id and the batch which are protected by the sink
+ * lock */
+typedef struct
+{
+  GstCaps *caps;
+  GstSegment segment;
+  gboolean sync;
+
+  gboolean flushing;
+  gboolean eos;
+  GstClockID clock_id;
+
+  /* samples collected since batch_pts, delivered when batch_id fires */
+  GPtrArray *batch;
+  GstClockTime batch_pts;
+  GstClockID batch_id;
+} GstTextSinkPadData;
+
+static void gst_text_sink_finalize (GObject * object);
+static void gst_text_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * spec);
+static void gst_text_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * spec);
+static GstStateChangeReturn gst_text_sink_change_state (GstElement * element,
+    GstStateChange transition);
+static GstPad *gst_text_sink_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
+static void gst_text_sink_release_pad (GstElement * element, GstPad * pad);
+
+static GstFlowReturn gst_text_sink_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buf);
+static gboolean gst_text_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event);
+
+G_DEFINE_TYPE (GstTextSink, gst_text_sink, GST_TYPE_ELEMENT);
+
+#define parent_class gst_text_sink_parent_class
+
+static void
+gst_text_sink_class_init (GstTextSinkClass * klass)
+{
+  GObjectClass *gobject_klass;
+  GstElementClass *gstelement_klass;
+
+  gobject_klass = (GObjectClass *) klass;
+  gstelement_klass = (GstElementClass *) klass;
+
+  gobject_klass->finalize = gst_text_sink_finalize;
+  gobject_klass->set_property = gst_text_sink_set_property;
+  gobject_klass->get_property = gst_text_sink_get_property;
+
+  /**
+   * GstTextSink:batch-window
+   *
+   * Collect the samples of a stream whose PTS are within this window of
+   * the first one and deliver them in one batch. A batch is delivered at
+   * the latest when the window ran out in clock time. 0 delivers every
+   * sample on its own. Only applies to the formats which aren't
+   * synchronized to the clock, a teletext sample is delivered as a batch
+   * of one once its running time is reached.
+   */
+  g_object_class_install_property (gobject_klass, PROP_BATCH_WINDOW,
+      g_param_spec_uint64 ("batch-window", "Batch window",
+          "Deliver the samples within this time in one batch (0 = disabled)",
+          0, G_MAXUINT64, DEFAULT_BATCH_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_klass,
+      gst_static_pad_template_get (&sink_template));
+
+  gst_element_class_set_static_metadata (gstelement_klass,
+      "Text Sink", "Sink/Subtitle",
+      "Delivers the samples of multiple text streams to the application",
+      "Wonchul Lee <wonchul86.lee@lge.com>");
+
+  gstelement_klass->change_state =
+      GST_DEBUG_FUNCPTR (gst_text_sink_change_state);
+  gstelement_klass->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_text_sink_request_new_pad);
+  gstelement_klass->release_pad = GST_DEBUG_FUNCPTR (gst_text_sink_release_pad);
+
+  GST_DEBUG_CATEGORY_INIT (gst_text_sink_debug, "textsink", 0, "Text Sink");
+}
+
+static void
+gst_text_sink_init (GstTextSink * sink)
+{
+  g_mutex_init (&sink->deliver_lock);
+  g_mutex_init (&sink->lock);
+  g_cond_init (&sink->cond);
+  sink->batch_window = DEFAULT_BATCH_WINDOW;
+
+  GST_OBJECT_FLAG_SET (sink, GST_ELEMENT_FLAG_SINK);
+}
+
+static void
+gst_text_sink_finalize (GObject * object)
+{
+  GstTextSink *sink = GST_TEXT_SINK (object);
+
+  g_mutex_clear (&sink->deliver_lock);
+  g_mutex_clear (&sink->lock);
+  g_cond_clear (&sink->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_text_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * spec)
+{
+  GstTextSink *sink = GST_TEXT_SINK (object);
+
+  switch (prop_id) {
+    case PROP_BATCH_WINDOW:
+      g_mutex_lock (&sink->lock);
+      sink->batch_window = g_value_get_uint64 (value);
+      g_mutex_unlock (&sink->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
+      break;
+  }
+}
+
+static void
+gst_text_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * spec)
+{
+  GstTextSink *sink = GST_TEXT_SINK (object);
+
+  switch (prop_id) {
+    case PROP_BATCH_WINDOW:
+      g_mutex_lock (&sink->lock);
+      g_value_set_uint64 (value, sink->batch_window);
+      g_mutex_unlock (&sink->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
+      break;
+  }
+}
+
+static void
+gst_text_sink_pad_data_free (GstTextSinkPadData * data)
+{
+  gst_caps_replace (&data->caps, NULL);
+  g_ptr_array_unref (data->batch);
+  g_slice_free (GstTextSinkPadData, data);
+}
+
+/* takes the collected samples out of @data, with the sink lock held */
+static GPtrArray *
+pad_data_steal_batch (GstTextSinkPadData * data)
+{
+  GPtrArray *batch;
+
+  if (data->batch_id) {
+    gst_clock_id_unschedule (data->batch_id);
+    gst_clock_id_unref (data->batch_id);
+    data->batch_id = NULL;
+  }
+
+  if (data->batch->len == 0)
+    return NULL;
+
+  batch = data->batch;
+  data->batch = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_sample_unref);
+
+  return batch;
+}
+
+static void
+pad_data_drop_batch (GstTextSinkPadData * data)
+{
+  GPtrArray *batch = pad_data_steal_batch (data);
+
+  if (batch)
+    g_ptr_array_unref (batch);
+}
+
+static GstPad *
+gst_text_sink_request_new_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, const GstCaps * caps)
+{
+  GstTextSink *sink = GST_TEXT_SINK (element);
+  GstTextSinkPadData *data;
+  gchar *pad_name;
+  GstPad *pad;
+
+  g_mutex_lock (&sink->lock);
+  if (name)
+    pad_name = g_strdup (name);
+  else
+    pad_name = g_strdup_printf ("sink_%u", sink->pad_count);
+  sink->pad_count++;
+  sink->nb_pads++;
+  g_mutex_unlock (&sink->lock);
+
+  data = g_slice_new0 (GstTextSinkPadData);
+  gst_segment_init (&data->segment, GST_FORMAT_TIME);
+  data->batch =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_sample_unref);
+
+  pad = gst_pad_new_from_template (templ, pad_name);
+  g_free (pad_name);
+
+  gst_pad_set_element_private (pad, data);
+  gst_pad_set_chain_function (pad, GST_DEBUG_FUNCPTR (gst_text_sink_chain));
+  gst_pad_set_event_function (pad, GST_DEBUG_FUNCPTR (gst_text_sink_event));
+
+  gst_pad_set_active (pad, TRUE);
+  gst_element_add_pad (element, pad);
+
+  GST_DEBUG_OBJECT (sink, "added %" GST_PTR_FORMAT, pad);
+
+  return pad;
+}
+
+static void
+gst_text_sink_release_pad (GstElement * element, GstPad * pad)
+{
+  GstTextSink *sink = GST_TEXT_SINK (element);
+  GstTextSinkPadData *data = gst_pad_get_element_private (pad);
+
+  GST_DEBUG_OBJECT (sink, "release pad %" GST_PTR_FORMAT, pad);
+
+  g_mutex_lock (&sink->lock);
+  data->flushing = TRUE;
+  if (data->clock_id)
+    gst_clock_id_unschedule (data->clock_id);
+  if (data->eos)
+    sink->nb_eos--;
+  sink->nb_pads--;
+  g_cond_broadcast (&sink->cond);
+  g_mutex_unlock (&sink->lock);
+
+  /* waits for the streaming thread to leave the pad */
+  gst_pad_set_active (pad, FALSE);
+
+  /* a batch timeout running now finds no data */
+  g_mutex_lock (&sink->deliver_lock);
+  g_mutex_lock (&sink->lock);
+  pad_data_drop_batch (data);
+  gst_pad_set_element_private (pad, NULL);
+  g_mutex_unlock (&sink->lock);
+  g_mutex_unlock (&sink->deliver_lock);
+
+  gst_text_sink_pad_data_free (data);
+
+  gst_element_remove_pad (element, pad);
+}
+
+/* calls @func with the data of every sink pad, with the sink lock held */
+static void
+gst_text_sink_foreach_pad (GstTextSink * sink,
+    void (*func) (GstTextSinkPadData * data))
+{
+  GList *walk;
+
+  GST_OBJECT_LOCK (sink);
+  for (walk = GST_ELEMENT_CAST (sink)->sinkpads; walk; walk = walk->next) {
+    GstTextSinkPadData *data = gst_pad_get_element_private (walk->data);
+
+    if (data)
+      func (data);
+  }
+  GST_OBJECT_UNLOCK (sink);
+}
+
+static void
+pad_data_unschedule (GstTextSinkPadData * data)
+{
+  if (data->clock_id)
+    gst_clock_id_unschedule (data->clock_id);
+}
+
+static void
+pad_data_reset_eos (GstTextSinkPadData * data)
+{
+  data->eos = FALSE;
+}
+
+/* like a sink which doesn't preroll, holds the data until PLAYING, with
+ * the sink lock held */
+static GstFlowReturn
+gst_text_sink_wait_playing (GstTextSink * sink, GstTextSinkPadData * data)
+{
+  while (TRUE) {
+    if (sink->flushing || data->flushing)
+      return GST_FLOW_FLUSHING;
+
+    if (sink->playing)
+      return GST_FLOW_OK;
+
+    g_cond_wait (&sink->cond, &sink->lock);
+  }
+}
+
+/* Waits for the running time of @buf on the clock. Returns
+ * GST_FLOW_CUSTOM_SUCCESS when @buf is outside of the segment. */
+static GstFlowReturn
+gst_text_sink_wait (GstTextSink * sink, GstTextSinkPadData * data,
+    GstBuffer * buf)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime running_time;
+
+  if (!GST_BUFFER_PTS_IS_VALID (buf) || data->segment.format != GST_FORMAT_TIME)
+    return GST_FLOW_OK;
+
+  running_time = gst_segment_to_running_time (&data->segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buf));
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return GST_FLOW_CUSTOM_SUCCESS;
+
+  g_mutex_lock (&sink->lock);
+  while (TRUE) {
+    GstClockReturn cret;
+    GstClock *clock;
+
+    if ((ret = gst_text_sink_wait_playing (sink, data)) != GST_FLOW_OK)
+      break;
+
+    if (!(clock = gst_element_get_clock (GST_ELEMENT_CAST (sink))))
+      break;
+
+    data->clock_id = gst_clock_new_single_shot_id (clock,
+        running_time + gst_element_get_base_time (GST_ELEMENT_CAST (sink)));
+    gst_object_unref (clock);
+
+    g_mutex_unlock (&sink->lock);
+    cret = gst_clock_id_wait (data->clock_id, NULL);
+    g_mutex_lock (&sink->lock);
+
+    gst_clock_id_unref (data->clock_id);
+    data->clock_id = NULL;
+
+    /* unscheduled by a flush or by going back to PAUSED */
+    if (cret != GST_CLOCK_UNSCHEDULED)
+      break;
+  }
+  g_mutex_unlock (&sink->lock);
+
+  return ret;
+}
+
+static void
+gst_text_sink_deliver (GstTextSink * sink, GstPad * pad,
+    GstTextSinkPadData * data, GstBuffer * buf)
+{
+  GstSample *sample;
+
+  sample = gst_sample_new (buf, data->caps, &data->segment, NULL);
+  gst_buffer_unref (buf);
+
+  if (sink->func) {
+    sink->func (GST_ELEMENT_CAST (sink), pad, sample, sink->user_data);
+    gst_sample_unref (sample);
+    return;
+  }
+
+  /* no function set, the application unrefs the sample of the message as
+   * it did with the appsink of each stream */
+  gst_element_post_message (GST_ELEMENT_CAST (sink),
+      gst_message_new_application (GST_OBJECT_CAST (sink),
+          gst_structure_new ("subtitle_data", "sample", GST_TYPE_SAMPLE,
+              sample, NULL)));
+}
+
+/* one batch function call, one sample function call per sample or one
+ * message, takes @batch */
+static void
+gst_text_sink_deliver_batch (GstTextSink * sink, GstPad * pad,
+    GPtrArray * batch)
+{
+  GValue samples = { 0, };
+  guint i;
+
+  GST_LOG_OBJECT (pad, "delivering batch of %u samples", batch->len);
+
+  if (sink->batch_func) {
+    sink->batch_func (GST_ELEMENT_CAST (sink), pad,
+        (GstSample **) batch->pdata, batch->len, sink->batch_user_data);
+  } else if (sink->func) {
+    for (i = 0; i < batch->len; i++)
+      sink->func (GST_ELEMENT_CAST (sink), pad, g_ptr_array_index (batch, i),
+          sink->user_data);
+  } else {
+    g_value_init (&samples, GST_TYPE_ARRAY);
+    for (i = 0; i < batch->len; i++) {
+      GValue sample = { 0, };
+
+      g_value_init (&sample, GST_TYPE_SAMPLE);
+      g_value_set_boxed (&sample, g_ptr_array_index (batch, i));
+      gst_value_array_append_value (&samples, &sample);
+      g_value_unset (&sample);
+    }
+
+    gst_element_post_message (GST_ELEMENT_CAST (sink),
+        gst_message_new_application (GST_OBJECT_CAST (sink),
+            gst_structure_new ("subtitle_batch", "pad", G_TYPE_STRING,
+                GST_PAD_NAME (pad), "samples", GST_TYPE_ARRAY, &samples,
+                NULL)));
+    g_value_unset (&samples);
+  }
+
+  g_ptr_array_unref (batch);
+}
+
+/* delivers what @pad collected so far */
+static void
+gst_text_sink_flush_batch (GstTextSink * sink, GstPad * pad,
+    GstTextSinkPadData * data)
+{
+  GPtrArray *batch;
+
+  g_mutex_lock (&sink->deliver_lock);
+  g_mutex_lock (&sink->lock);
+  batch = pad_data_steal_batch (data);
+  g_mutex_unlock (&sink->lock);
+
+  if (batch)
+    gst_text_sink_deliver_batch (sink, pad, batch);
+  g_mutex_unlock (&sink->deliver_lock);
+}
+
+static gboolean
+batch_timeout_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    GstPad * pad)
+{
+  GstTextSink *sink;
+  GstTextSinkPadData *data;
+  GPtrArray *batch = NULL;
+
+  if (!(sink = (GstTextSink *) gst_pad_get_parent_element (pad)))
+    return TRUE;
+
+  g_mutex_lock (&sink->deliver_lock);
+  g_mutex_lock (&sink->lock);
+  data = gst_pad_get_element_private (pad);
+  /* the batch may have been delivered or dropped meanwhile */
+  if (data && data->batch_id == id)
+    batch = pad_data_steal_batch (data);
+  g_mutex_unlock (&sink->lock);
+
+  if (batch)
+    gst_text_sink_deliver_batch (sink, pad, batch);
+  g_mutex_unlock (&sink->deliver_lock);
+
+  gst_object_unref (sink);
+
+  return TRUE;
+}
+
+static void
+gst_text_sink_batch (GstTextSink * sink, GstPad * pad,
+    GstTextSinkPadData * data, GstBuffer * buf, GstClockTime window)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buf);
+  GPtrArray *batch = NULL;
+  GstSample *sample;
+
+  sample = gst_sample_new (buf, data->caps, &data->segment, NULL);
+  gst_buffer_unref (buf);
+
+  g_mutex_lock (&sink->deliver_lock);
+  g_mutex_lock (&sink->lock);
+
+  /* a sample outside of the window of the first one starts a new batch,
+   * samples without PTS only end one when the window ran out */
+  if (data->batch->len > 0 && GST_CLOCK_TIME_IS_VALID (pts)
+      && GST_CLOCK_TIME_IS_VALID (data->batch_pts)
+      && (pts < data->batch_pts || pts - data->batch_pts >= window))
+    batch = pad_data_steal_batch (data);
+
+  if (data->batch->len == 0) {
+    GstClock *clock = gst_system_clock_obtain ();
+
+    data->batch_pts = pts;
+    data->batch_id = gst_clock_new_single_shot_id (clock,
+        gst_clock_get_time (clock) + window);
+    gst_clock_id_wait_async (data->batch_id,
+        (GstClockCallback) batch_timeout_cb, gst_object_ref (pad),
+        (GDestroyNotify) gst_object_unref);
+    gst_object_unref (clock);
+  }
+  g_ptr_array_add (data->batch, sample);
+
+  g_mutex_unlock (&sink->lock);
+
+  if (batch)
+    gst_text_sink_deliver_batch (sink, pad, batch);
+  g_mutex_unlock (&sink->deliver_lock);
+}
+
+static GstFlowReturn
+gst_text_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstTextSink *sink = GST_TEXT_SINK (parent);
+  GstTextSinkPadData *data = gst_pad_get_element_private (pad);
+  GstClockTime window;
+  gboolean pending;
+  GstFlowReturn ret;
+
+  GST_LOG_OBJECT (pad, "received %" GST_PTR_FORMAT, buf);
+
+  if (data->sync) {
+    ret = gst_text_sink_wait (sink, data, buf);
+  } else {
+    g_mutex_lock (&sink->lock);
+    ret = gst_text_sink_wait_playing (sink, data);
+    g_mutex_unlock (&sink->lock);
+  }
+
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (buf);
+    return ret == GST_FLOW_CUSTOM_SUCCESS ? GST_FLOW_OK : ret;
+  }
+
+  g_mutex_lock (&sink->lock);
+  window = sink->batch_window;
+  pending = data->batch->len > 0;
+  g_mutex_unlock (&sink->lock);
+
+  /* holding a synchronized sample back for the window would show it late */
+  if (window > 0 && data->sync) {
+    GPtrArray *batch =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) gst_sample_unref);
+
+    g_ptr_array_add (batch, gst_sample_new (buf, data->caps, &data->segment,
+            NULL));
+    gst_buffer_unref (buf);
+
+    g_mutex_lock (&sink->deliver_lock);
+    gst_text_sink_deliver_batch (sink, pad, batch);
+    g_mutex_unlock (&sink->deliver_lock);
+    return GST_FLOW_OK;
+  }
+
+  if (window > 0) {
+    gst_text_sink_batch (sink, pad, data, buf, window);
+    return GST_FLOW_OK;
+  }
+
+  /* the window was turned off while samples were collected */
+  if (G_UNLIKELY (pending))
+    gst_text_sink_flush_batch (sink, pad, data);
+
+  gst_text_sink_deliver (sink, pad, data, buf);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_text_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstTextSink *sink = GST_TEXT_SINK (parent);
+  GstTextSinkPadData *data = gst_pad_get_element_private (pad);
+  gboolean post_eos = FALSE;
+
+  GST_DEBUG_OBJECT (pad, "event = %s", GST_EVENT_TYPE_NAME (event));
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      g_mutex_lock (&sink->lock);
+      data->flushing = TRUE;
+      pad_data_unschedule (data);
+      pad_data_drop_batch (data);
+      g_cond_broadcast (&sink->cond);
+      g_mutex_unlock (&sink->lock);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      g_mutex_lock (&sink->lock);
+      data->flushing = FALSE;
+      if (data->eos) {
+        data->eos = FALSE;
+        sink->nb_eos--;
+      }
+      g_mutex_unlock (&sink->lock);
+      gst_segment_init (&data->segment, GST_FORMAT_TIME);
+      break;
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps;
+      const gchar *type_name;
+
+      gst_event_parse_caps (event, &caps);
+      gst_caps_replace (&data->caps, caps);
+
+      /* only teletext is rendered in time by the sink */
+      type_name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+      data->sync = !g_strcmp0 (type_name, "application/x-teletext");
+
+      GST_DEBUG_OBJECT (pad, "[%s] sync %d", type_name, data->sync);
+      break;
+    }
+    case GST_EVENT_SEGMENT:
+      gst_event_copy_segment (event, &data->segment);
+      break;
+    case GST_EVENT_GAP:
+      /* nothing more comes for a while */
+      gst_text_sink_flush_batch (sink, pad, data);
+      break;
+    case GST_EVENT_EOS:
+      gst_text_sink_flush_batch (sink, pad, data);
+
+      g_mutex_lock (&sink->lock);
+      if (!data->eos) {
+        data->eos = TRUE;
+        post_eos = ++sink->nb_eos == sink->nb_pads;
+      }
+      g_mutex_unlock (&sink->lock);
+      break;
+    default:
+      break;
+  }
+
+  gst_event_unref (event);
+
+  /* the bin posts EOS once all of its sinks did */
+  if (post_eos)
+    gst_element_post_message (GST_ELEMENT_CAST (sink),
+        gst_message_new_eos (GST_OBJECT_CAST (sink)));
+
+  return TRUE;
+}
+
+static GstStateChangeReturn
+gst_text_sink_change_state (GstElement * element, GstStateChange transition)
+{
+  GstTextSink *sink = GST_TEXT_SINK (element);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_cool_subtitle_get_func (element, &sink->func,
+              &sink->user_data)) {
+        sink->func = NULL;
+        sink->user_data = NULL;
+      }
+      if (!gst_cool_subtitle_get_batch_func (element, &sink->batch_func,
+              &sink->batch_user_data)) {
+        sink->batch_func = NULL;
+        sink->batch_user_data = NULL;
+      }
+      GST_DEBUG_OBJECT (sink, "delivering by %s",
+          sink->func || sink->batch_func ? "function" : "message");
+
+      g_mutex_lock (&sink->lock);
+      sink->flushing = FALSE;
+      sink->nb_eos = 0;
+      gst_text_sink_foreach_pad (sink, pad_data_reset_eos);
+      g_mutex_unlock (&sink->lock);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      g_mutex_lock (&sink->lock);
+      sink->playing = TRUE;
+      g_cond_broadcast (&sink->cond);
+      g_mutex_unlock (&sink->lock);
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      g_mutex_lock (&sink->lock);
+      sink->playing = FALSE;
+      gst_text_sink_foreach_pad (sink, pad_data_unschedule);
+      g_mutex_unlock (&sink->lock);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* release the streaming threads before the pads are deactivated */
+      g_mutex_lock (&sink->lock);
+      sink->flushing = TRUE;
+      gst_text_sink_foreach_pad (sink, pad_data_unschedule);
+      gst_text_sink_foreach_pad (sink, pad_data_drop_batch);
+      g_cond_broadcast (&sink->cond);
+      g_mutex_unlock (&sink->lock);
+      break;
+    default:
+      break;
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
@@ -0,0 +1,77 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *	Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_TEXT_SINK_H__
+#define __GST_TEXT_SINK_H__
+
+#include <gst/gst.h>
+#include <gst/cool/gstcool.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_TEXT_SINK (gst_text_sink_get_type())
+#define GST_TEXT_SINK(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_TEXT_SINK,GstTextSink))
+#define GST_TEXT_SINK_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_TEXT_SINK,GstTextSinkClass))
+#define GST_IS_TEXT_SINK(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_TEXT_SINK))
+#define GST_IS_TEXT_SINK_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_TEXT_SINK))
+#define GST_TEXT_SINK_CAST(obj) ((GstTextSink*)(obj))
+typedef struct _GstTextSink GstTextSink;
+typedef struct _GstTextSinkClass GstTextSinkClass;
+
+/**
+ * GstTextSink:
+ *
+ * Sink with a request pad per text stream which hands each sample to the
+ * #GstCoolSubtitleFunc of the pipeline from the streaming thread.
+ */
+struct _GstTextSink
+{
+  GstElement parent;
+
+  /* serializes the delivery of batches, taken before lock */
+  GMutex deliver_lock;
+
+  /* protects the fields below and the clock waits of the pads */
+  GMutex lock;
+  GCond cond;
+  gboolean playing;
+  gboolean flushing;
+  guint nb_pads;
+  guint nb_eos;
+  guint pad_count;
+  GstClockTime batch_window;
+
+  /* looked up at READY->PAUSED, only read by the streaming threads */
+  GstCoolSubtitleFunc func;
+  gpointer user_data;
+  GstCoolSubtitleBatchFunc batch_func;
+  gpointer batch_user_data;
+};
+
+struct _GstTextSinkClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_text_sink_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_TEXT_SINK_H__ */
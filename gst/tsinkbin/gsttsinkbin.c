@@ -26,6 +26,8 @@
 #include <string.h>
 #include "gsttsinkbin.h"
 
+#include <gst/cool/gstcool.h>
+
 GST_DEBUG_CATEGORY_STATIC (gst_tsink_bin_debug);
 #define GST_CAT_DEFAULT gst_tsink_bin_debug
 
@@ -39,10 +41,12 @@ GST_STATIC_PAD_TEMPLATE ("text_sink%d",
 enum
 {
   PROP_0,
+  PROP_BATCH_WINDOW,
   PROP_LAST
 };
 
 #define DEFAULT_THUMBNAIL_MODE FALSE
+#define DEFAULT_BATCH_WINDOW 0
 
 static void gst_tsink_bin_finalize (GObject * object);
 static void gst_tsink_bin_set_property (GObject * object, guint prop_id,
@@ -55,12 +59,7 @@ static GstPad *gst_tsink_bin_request_new_pad (GstElement * element,
 static void gst_tsink_bin_release_request_pad (GstElement * element,
     GstPad * pad);
 
-static gboolean activate_chain (GstElement * sink, GstTextGroup * tgoup,
-    gboolean activate);
-static GstFlowReturn gst_tsink_bin_new_sample (GstElement * sink);
 static gboolean gst_tsink_bin_query (GstElement * element, GstQuery * query);
-static GstPadProbeReturn gst_tsink_appsink_event_probe_cb (GstPad * pad,
-    GstPadProbeInfo * info, gpointer user_data);
 
 G_DEFINE_TYPE (GstTSinkBin, gst_tsink_bin, GST_TYPE_BIN);
 
@@ -79,6 +78,19 @@ gst_tsink_bin_class_init (GstTSinkBinClass * klass)
   gobject_klass->set_property = gst_tsink_bin_set_property;
   gobject_klass->get_property = gst_tsink_bin_get_property;
 
+  /**
+   * GstTSinkBin:batch-window
+   *
+   * Deliver the samples of a text stream whose PTS are within this window
+   * in one batch, see #GstCoolSubtitleBatchFunc. 0 delivers each sample on
+   * its own.
+   */
+  g_object_class_install_property (gobject_klass, PROP_BATCH_WINDOW,
+      g_param_spec_uint64 ("batch-window", "Batch window",
+          "Deliver the samples within this time in one batch (0 = disabled)",
+          0, G_MAXUINT64, DEFAULT_BATCH_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (gstelement_klass,
       gst_static_pad_template_get (&text_template));
 
@@ -100,7 +112,9 @@ gst_tsink_bin_init (GstTSinkBin * tsinkbin)
   GST_DEBUG_CATEGORY_INIT (gst_tsink_bin_debug, "tsinkbin", 0, "Text Sink Bin");
   g_rec_mutex_init (&tsinkbin->lock);
 
-  tsinkbin->sink_list = g_list_alloc ();
+  tsinkbin->textsink = NULL;
+  tsinkbin->nb_pads = 0;
+  tsinkbin->batch_window = DEFAULT_BATCH_WINDOW;
 }
 
 static void
@@ -112,106 +126,90 @@ gst_tsink_bin_finalize (GObject * obj)
 
   g_rec_mutex_clear (&tsinkbin->lock);
 
-  g_list_free (tsinkbin->sink_list);
-
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
+/* Every text stream gets a request pad of the same textsink, which hands
+ * the samples to the application. textbin puts a queue in front of each
+ * request pad, which gives each stream its own thread, so no queue is
+ * needed here. */
 static GstPad *
 gst_tsink_bin_request_new_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * name, const GstCaps * caps)
 {
   GstTSinkBin *tsinkbin;
-  const gchar *pad_name;
+  gchar *pad_name;
   GstPad *pad;
-  GstTextGroup *t_group;
-  GstPad *queue_sinkpad;
-  GstPad *appsinkpad = NULL;
+  GstPad *sinkpad;
 
   g_return_val_if_fail (templ != NULL, NULL);
   GST_DEBUG_OBJECT (element, "name: %s", name);
 
   tsinkbin = GST_TSINK_BIN (element);
 
-  t_group = g_malloc0 (sizeof (GstTextGroup));
-
-  t_group->queue = gst_element_factory_make ("queue", NULL);
-  g_object_set (G_OBJECT (t_group->queue), "silent", TRUE, NULL);
-  if (t_group->queue == NULL) {
-    GST_WARNING_OBJECT (element, "fail to create queue element");
-    goto fail;
-  }
-
-  t_group->appsink = gst_element_factory_make ("appsink", NULL);
-  if (t_group->appsink == NULL) {
-    GST_WARNING_OBJECT (element, "fail to create appsink element");
-    goto fail;
+  GST_TSINK_BIN_LOCK (tsinkbin);
+  if (!tsinkbin->textsink) {
+    tsinkbin->textsink = gst_element_factory_make ("textsink", NULL);
+    if (tsinkbin->textsink == NULL) {
+      GST_TSINK_BIN_UNLOCK (tsinkbin);
+      GST_WARNING_OBJECT (element, "fail to create textsink element");
+      return NULL;
+    }
+
+    g_object_set (tsinkbin->textsink, "batch-window", tsinkbin->batch_window,
+        NULL);
+    gst_bin_add (GST_BIN_CAST (tsinkbin), tsinkbin->textsink);
+    gst_element_sync_state_with_parent (tsinkbin->textsink);
   }
-  // FIXME: Needs to mutex lock when properties are set in appsink.
-  // If not, it may cause crash problem in h15 platform.
-  // issue address : [BHV-15451] Crash problem when playing internal subtitle
 
-  GST_TSINK_BIN_LOCK (tsinkbin);
-  g_object_set (t_group->appsink, "emit-signals", TRUE, "sync", FALSE,
-      "ts-offset", 1000 * 1000, NULL);
-  /* disable async enable */
-  g_object_set (t_group->appsink, "async", FALSE, NULL);
+  sinkpad = gst_element_get_request_pad (tsinkbin->textsink, "sink_%u");
+  pad_name = g_strdup_printf ("text_sink%u", tsinkbin->nb_pads++);
   GST_TSINK_BIN_UNLOCK (tsinkbin);
 
-  g_signal_connect (t_group->appsink, "new-sample",
-      G_CALLBACK (gst_tsink_bin_new_sample), NULL);
-
-  /* get the appsink sink pad */
-  appsinkpad = gst_element_get_static_pad (t_group->appsink, "sink");
-
-  /* add the probe function to receive the downstream events */
-  gst_pad_add_probe (appsinkpad,
-      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
-      gst_tsink_appsink_event_probe_cb, t_group->appsink, NULL);
-
-  gst_object_unref (appsinkpad);
-
-  gst_element_set_state (t_group->appsink, GST_STATE_READY);
-
-  gst_bin_add (GST_BIN_CAST (tsinkbin), t_group->queue);
-  gst_bin_add (GST_BIN_CAST (tsinkbin), t_group->appsink);
-
-  gst_element_link_pads (t_group->queue, "src", t_group->appsink, "sink");
-
-  queue_sinkpad = gst_element_get_static_pad (t_group->queue, "sink");
-  pad_name =
-      g_strdup_printf ("text_sink%d", g_list_length (tsinkbin->sink_list));
-  pad = gst_ghost_pad_new (pad_name, queue_sinkpad);
+  pad = gst_ghost_pad_new (pad_name, sinkpad);
+  g_free (pad_name);
+  gst_object_unref (sinkpad);
 
   gst_pad_set_active (pad, TRUE);
   gst_element_add_pad (element, pad);
 
-  activate_chain (element, t_group, TRUE);
-
-  tsinkbin->sink_list = g_list_append (tsinkbin->sink_list, t_group);
-
   return pad;
-
-fail:
-  GST_WARNING_OBJECT (element, "internal element creation fail");
-  return NULL;
 }
 
 static void
 gst_tsink_bin_release_request_pad (GstElement * element, GstPad * pad)
 {
   GstTSinkBin *tsinkbin = GST_TSINK_BIN (element);
+  GstPad *target;
 
   GST_DEBUG_OBJECT (tsinkbin, "release pad %" GST_PTR_FORMAT, pad);
+
+  target = gst_ghost_pad_get_target (GST_GHOST_PAD_CAST (pad));
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+
+  if (target) {
+    gst_element_release_request_pad (tsinkbin->textsink, target);
+    gst_object_unref (target);
+  }
 }
 
 static void
 gst_tsink_bin_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * spec)
 {
-  //GstTSinkBin *tsinkbin = GST_TSINK_BIN (object);
+  GstTSinkBin *tsinkbin = GST_TSINK_BIN (object);
 
   switch (prop_id) {
+    case PROP_BATCH_WINDOW:
+      GST_TSINK_BIN_LOCK (tsinkbin);
+      tsinkbin->batch_window = g_value_get_uint64 (value);
+      if (tsinkbin->textsink)
+        g_object_set (tsinkbin->textsink, "batch-window",
+            tsinkbin->batch_window, NULL);
+      GST_TSINK_BIN_UNLOCK (tsinkbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
       break;
@@ -222,62 +220,20 @@ static void
 gst_tsink_bin_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * spec)
 {
-  //GstTSinkBin *tsinkbin = GST_TSINK_BIN (object);
+  GstTSinkBin *tsinkbin = GST_TSINK_BIN (object);
+
   switch (prop_id) {
+    case PROP_BATCH_WINDOW:
+      GST_TSINK_BIN_LOCK (tsinkbin);
+      g_value_set_uint64 (value, tsinkbin->batch_window);
+      GST_TSINK_BIN_UNLOCK (tsinkbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
       break;
   }
 }
 
-static gboolean
-activate_chain (GstElement * sink, GstTextGroup * tgroup, gboolean activate)
-{
-  GstState state;
-  GstElement *parent;
-
-  parent = GST_ELEMENT (gst_element_get_parent (sink));
-
-  GST_OBJECT_LOCK (sink);
-  state = GST_STATE_TARGET (parent);
-  GST_OBJECT_UNLOCK (sink);
-  if (activate == FALSE)
-    state = GST_STATE_NULL;
-
-  gst_element_set_state (tgroup->queue, state);
-  gst_element_set_state (tgroup->appsink, state);
-
-  gst_object_unref (parent);
-
-  return TRUE;
-}
-
-static GstFlowReturn
-gst_tsink_bin_new_sample (GstElement * sink)
-{
-  GstSample *sample = NULL;
-  GstStructure *structure;
-
-  g_signal_emit_by_name (sink, "pull-sample", &sample);
-
-  if (sample == NULL) {
-    GST_WARNING_OBJECT (sink, "pull-sample returns NULL");
-    return GST_FLOW_CUSTOM_ERROR;
-  }
-
-  structure =
-      gst_structure_new ("subtitle_data", "sample", GST_TYPE_SAMPLE,
-      sample, NULL);
-
-  gst_element_post_message (sink,
-      gst_message_new_application (GST_OBJECT_CAST (sink), structure));
-
-  //gst_sample_unref (sample);
-
-  return GST_FLOW_OK;
-}
-
-
 static gboolean
 gst_tsink_bin_query (GstElement * element, GstQuery * query)
 {
@@ -294,47 +250,3 @@ gst_tsink_bin_query (GstElement * element, GstQuery * query)
 
   return ret;
 }
-
-/* Process the appsink downstream events */
-static GstPadProbeReturn
-gst_tsink_appsink_event_probe_cb (GstPad * pad, GstPadProbeInfo * info,
-    gpointer user_data)
-{
-  GstElement *self = GST_ELEMENT (user_data);
-  GstEvent *event = GST_EVENT (GST_PAD_PROBE_INFO_DATA (info));
-  GstStructure *tmp_structure;
-  const gchar *type_name;
-  GstCaps *caps = NULL;
-
-  GST_DEBUG_OBJECT (self, "event = %s, sticky = %d",
-      GST_EVENT_TYPE_NAME (event), GST_EVENT_IS_STICKY (event));
-
-  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) != GST_EVENT_CAPS) {
-    GST_DEBUG_OBJECT (pad, "Passing stream start event");
-    return GST_PAD_PROBE_OK;
-  }
-
-  gst_event_parse_caps (event, &caps);
-  gst_event_unref (event);
-
-  /* Get the first gst structure from the caps */
-  g_return_val_if_fail (caps != NULL, GST_PAD_PROBE_OK);
-  tmp_structure = gst_caps_get_structure (caps, 0);
-
-  g_return_val_if_fail (tmp_structure != NULL, GST_PAD_PROBE_OK);
-  type_name = gst_structure_get_name (tmp_structure);
-
-  GST_DEBUG_OBJECT (pad, "[%s]- app sink configured as Sync %p", type_name,
-      self);
-
-  /* check the mime type */
-  if (!g_strcmp0 (type_name, "application/x-teletext"))
-    g_object_set (self, "sync", TRUE, "async", FALSE, "ts-offset", 0, NULL);
-  else if (!g_strcmp0 (type_name, "subpicture/x-dvb"))
-    g_object_set (self, "sync", FALSE, "async", FALSE, "ts-offset", 0, NULL);
-
-  /* remove the probe function from appsink sink pad */
-  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
-
-  return GST_PAD_PROBE_REMOVE;
-}
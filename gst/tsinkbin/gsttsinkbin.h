@@ -35,24 +35,21 @@ G_BEGIN_DECLS
 #define GST_TSINK_BIN_GET_LOCK(bin) (&((GstTSinkBin*)(bin))->lock)
 #define GST_TSINK_BIN_LOCK(bin) (g_rec_mutex_lock (GST_TSINK_BIN_GET_LOCK(bin)))
 #define GST_TSINK_BIN_UNLOCK(bin) (g_rec_mutex_unlock (GST_TSINK_BIN_GET_LOCK(bin)))
-typedef struct _GstTextGroup GstTextGroup;
 typedef struct _GstTSinkBinClass GstTSinkBinClass;
 typedef struct _GstTSinkBin GstTSinkBin;
 typedef struct _GstTSinkBinClass GstTSinkBinClass;
 
-struct _GstTextGroup
-{
-  GstElement *appsink;
-  GstElement *queue;
-};
-
 struct _GstTSinkBin
 {
   GstBin parent;
 
   GRecMutex lock;               /* to protect group switching */
 
-  GList *sink_list;
+  /* one textsink for all of the text streams */
+  GstElement *textsink;
+  guint nb_pads;
+
+  GstClockTime batch_window;
 };
 
 struct _GstTSinkBinClass
@@ -26,6 +26,7 @@
 #include <gst/gst.h>
 
 #include "gsttsinkbin.h"
+#include "gsttextsink.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -34,6 +35,10 @@ plugin_init (GstPlugin * plugin)
           GST_TYPE_TSINK_BIN))
     return FALSE;
 
+  if (!gst_element_register (plugin, "textsink", GST_RANK_NONE,
+          GST_TYPE_TEXT_SINK))
+    return FALSE;
+
   return TRUE;
 }
 
@@ -33,6 +33,71 @@ GST_START_TEST (test_cool_init)
 
 GST_END_TEST;
 
+/* the record of the element at @path in the "elements" array */
+static const GstStructure *
+find_record (const GstStructure * snapshot, const gchar * path)
+{
+  const GValue *elements;
+  guint i;
+
+  elements = gst_structure_get_value (snapshot, "elements");
+  fail_unless (elements != NULL);
+
+  for (i = 0; i < gst_value_array_get_size (elements); i++) {
+    const GstStructure *record =
+        gst_value_get_structure (gst_value_array_get_value (elements, i));
+
+    if (!g_strcmp0 (gst_structure_get_string (record, "path"), path))
+      return record;
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_cool_playbin_snapshot)
+{
+  GstElement *bin, *queue, *inner;
+  GstStructure *snapshot;
+  const GstStructure *record;
+  guint level_bytes = G_MAXUINT;
+  gint state = -1;
+
+  bin = gst_bin_new ("bin");
+  queue = gst_element_factory_make ("queue", "q");
+  fail_unless (queue != NULL);
+  gst_bin_add (GST_BIN (bin), queue);
+
+  /* a nested element with the same name gets its own record */
+  inner = gst_bin_new ("inner");
+  queue = gst_element_factory_make ("queue", "q");
+  gst_bin_add (GST_BIN (inner), queue);
+  gst_bin_add (GST_BIN (bin), inner);
+
+  snapshot = gst_cool_playbin_snapshot (bin);
+  fail_unless (snapshot != NULL);
+  fail_unless (gst_structure_has_name (snapshot, "cool-snapshot"));
+  fail_unless (gst_structure_has_field (snapshot, "timestamp"));
+
+  fail_unless (find_record (snapshot, "/bin/inner/q") != NULL);
+  fail_unless (find_record (snapshot, "/bin/inner") != NULL);
+
+  /* element names aren't used as field names */
+  fail_if (gst_structure_has_field (snapshot, "/bin/q"));
+
+  record = find_record (snapshot, "/bin/q");
+  fail_unless (record != NULL);
+  fail_unless (gst_structure_has_field_typed (record, "pads", GST_TYPE_ARRAY));
+  fail_unless (gst_structure_get_int (record, "state", &state));
+  fail_unless_equals_int (state, GST_STATE_NULL);
+  fail_unless (gst_structure_get_uint (record, "level-bytes", &level_bytes));
+  fail_unless_equals_int (level_bytes, 0);
+
+  gst_structure_free (snapshot);
+  gst_object_unref (bin);
+}
+
+GST_END_TEST;
+
 static Suite *
 gstcool_suite (void)
 {
@@ -41,6 +106,7 @@ gstcool_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_cool_init);
+  tcase_add_test (tc_chain, test_cool_playbin_snapshot);
 
   return s;
 }
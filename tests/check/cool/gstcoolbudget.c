@@ -0,0 +1,140 @@
+/* GStreamer Plugins Cool
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *	Author : Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/cool/gstcool.h>
+
+static guint
+get_max_size_bytes (GstElement * queue)
+{
+  guint bytes = 0;
+
+  g_object_get (queue, "max-size-bytes", &bytes, NULL);
+  return bytes;
+}
+
+GST_START_TEST (test_budget_apportion)
+{
+  GstElement *q1, *q2;
+
+  q1 = gst_element_factory_make ("queue", NULL);
+  q2 = gst_element_factory_make ("queue", NULL);
+  fail_unless (q1 != NULL && q2 != NULL);
+
+  gst_cool_budget_set_ceiling (3000);
+
+  gst_cool_budget_register (q1, 1, NULL, NULL);
+  fail_unless_equals_int (get_max_size_bytes (q1), 3000);
+
+  gst_cool_budget_register (q2, 2, NULL, NULL);
+  fail_unless_equals_int (get_max_size_bytes (q1), 1000);
+  fail_unless_equals_int (get_max_size_bytes (q2), 2000);
+  fail_unless_equals_uint64 (gst_cool_budget_get_share (q2), 2000);
+
+  /* destroying an element gives its share back */
+  gst_object_unref (q2);
+  fail_unless_equals_int (get_max_size_bytes (q1), 3000);
+
+  gst_cool_budget_unregister (q1);
+  fail_unless_equals_uint64 (gst_cool_budget_get_share (q1), 0);
+
+  gst_cool_budget_set_ceiling (0);
+  gst_object_unref (q1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_budget_disabled)
+{
+  GstElement *q;
+  guint bytes;
+
+  q = gst_element_factory_make ("queue", NULL);
+  fail_unless (q != NULL);
+  bytes = get_max_size_bytes (q);
+
+  gst_cool_budget_set_ceiling (0);
+  gst_cool_budget_register (q, 1, NULL, NULL);
+  fail_unless_equals_int (get_max_size_bytes (q), bytes);
+
+  gst_object_unref (q);
+}
+
+GST_END_TEST;
+
+static GstElement *nested_element = NULL;
+
+/* applies the share, then registers another element from the callback */
+static void
+nested_budget_cb (GstElement * element, guint64 share, gpointer user_data)
+{
+  GstElement *nested = nested_element;
+
+  g_object_set (element, "max-size-bytes", (guint) share, NULL);
+
+  nested_element = NULL;
+  if (nested)
+    gst_cool_budget_register (nested, 1, NULL, NULL);
+}
+
+GST_START_TEST (test_budget_nested_rebalance)
+{
+  GstElement *q1, *q2, *q3;
+
+  q1 = gst_element_factory_make ("queue", NULL);
+  q2 = gst_element_factory_make ("queue", NULL);
+  q3 = gst_element_factory_make ("queue", NULL);
+  fail_unless (q1 != NULL && q2 != NULL && q3 != NULL);
+
+  gst_cool_budget_set_ceiling (3000);
+  gst_cool_budget_register (q2, 1, NULL, NULL);
+  gst_cool_budget_register (q1, 1, nested_budget_cb, NULL);
+  fail_unless_equals_int (get_max_size_bytes (q2), 1500);
+
+  /* q1 is applied first and registers q3, the stale share of 1500 which
+   * the outer rebalance still holds for q2 must not be applied after */
+  nested_element = q3;
+  gst_cool_budget_set_ceiling (3000);
+  fail_unless_equals_int (get_max_size_bytes (q1), 1000);
+  fail_unless_equals_int (get_max_size_bytes (q2), 1000);
+  fail_unless_equals_int (get_max_size_bytes (q3), 1000);
+
+  gst_cool_budget_set_ceiling (0);
+  gst_object_unref (q1);
+  gst_object_unref (q2);
+  gst_object_unref (q3);
+}
+
+GST_END_TEST;
+
+static Suite *
+gstcoolbudget_suite (void)
+{
+  Suite *s = suite_create ("GstCoolBudget");
+  TCase *tc_chain = tcase_create ("gst cool budget tests");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_budget_apportion);
+  tcase_add_test (tc_chain, test_budget_disabled);
+  tcase_add_test (tc_chain, test_budget_nested_rebalance);
+  return s;
+}
+
+GST_CHECK_MAIN (gstcoolbudget);
@@ -0,0 +1,1061 @@
+/* GStreamer unit tests for the dynappsrc
+ *
+ * Copyright 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gstdynappsrcrecord.h"
+#include "gstdynappsrcunwrap.h"
+
+#define MAX_SOURCES 4
+
+/* a buffer that reached a sink, its data is copied so that the wrapped
+ * memory can be released */
+typedef struct
+{
+  guint source;
+  GstClockTime pts;
+  guint n_memory;
+  GBytes *data;
+} Received;
+
+struct TestData
+{
+  GstElement *pipeline;
+  GstElement *dynappsrc;
+  GstElement *appsrc[MAX_SOURCES];
+  guint n_sources;
+
+  GMutex lock;
+  GCond cond;
+  GList *received;
+  guint n_received;
+  guint n_pads_added;
+  guint n_pads_removed;
+  guint n_released;
+  GstElement *released_appsrc;
+  gpointer released_user_data;
+  GArray *masks;
+  GstFormat segment_format[MAX_SOURCES];
+};
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    struct TestData *td)
+{
+  Received *r = g_slice_new0 (Received);
+  GstMapInfo map;
+
+  r->source = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (sink),
+          "source"));
+  r->pts = GST_BUFFER_PTS (buffer);
+  r->n_memory = gst_buffer_n_memory (buffer);
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  r->data = g_bytes_new (map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+
+  g_mutex_lock (&td->lock);
+  td->received = g_list_append (td->received, r);
+  td->n_received++;
+  g_cond_broadcast (&td->cond);
+  g_mutex_unlock (&td->lock);
+}
+
+static GstPadProbeReturn
+segment_probe_cb (GstPad * pad, GstPadProbeInfo * info, struct TestData *td)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstObject *sink = gst_pad_get_parent (pad);
+  guint source;
+
+  source = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (sink), "source"));
+  gst_object_unref (sink);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT && source < MAX_SOURCES) {
+    const GstSegment *segment;
+
+    gst_event_parse_segment (event, &segment);
+    g_mutex_lock (&td->lock);
+    td->segment_format[source] = segment->format;
+    g_mutex_unlock (&td->lock);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+pad_added_cb (GstElement * dynappsrc, GstPad * pad, struct TestData *td)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+  guint source = 0;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (sink != NULL);
+  g_object_set (sink, "sync", FALSE, "enable-last-sample", FALSE,
+      "signal-handoffs", TRUE, NULL);
+
+  g_mutex_lock (&td->lock);
+  td->n_pads_added++;
+  g_mutex_unlock (&td->lock);
+
+  sscanf (GST_PAD_NAME (pad), "src_%u", &source);
+  g_object_set_data (G_OBJECT (sink), "source", GUINT_TO_POINTER (source));
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), td);
+
+  gst_bin_add (GST_BIN (td->pipeline), sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) segment_probe_cb, td, NULL);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (pad, sinkpad)));
+  gst_object_unref (sinkpad);
+  gst_element_sync_state_with_parent (sink);
+}
+
+static void
+pad_removed_cb (GstElement * dynappsrc, GstPad * pad, struct TestData *td)
+{
+  g_mutex_lock (&td->lock);
+  td->n_pads_removed++;
+  g_mutex_unlock (&td->lock);
+}
+
+static void
+memory_released_cb (GstElement * dynappsrc, GstElement * appsrc,
+    gpointer user_data, struct TestData *td)
+{
+  g_mutex_lock (&td->lock);
+  td->n_released++;
+  td->released_appsrc = appsrc;
+  td->released_user_data = user_data;
+  g_cond_broadcast (&td->cond);
+  g_mutex_unlock (&td->lock);
+}
+
+static void
+need_data_cb (GstElement * dynappsrc, guint64 mask, struct TestData *td)
+{
+  g_mutex_lock (&td->lock);
+  g_array_append_val (td->masks, mask);
+  g_cond_broadcast (&td->cond);
+  g_mutex_unlock (&td->lock);
+}
+
+static void
+setup_test_objects (struct TestData *td, guint n_sources)
+{
+  guint i;
+
+  memset (td, 0, sizeof (struct TestData));
+  g_mutex_init (&td->lock);
+  g_cond_init (&td->cond);
+  td->masks = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  td->pipeline = gst_pipeline_new (NULL);
+  td->dynappsrc = gst_element_factory_make ("dynappsrc", NULL);
+  fail_unless (td->dynappsrc != NULL);
+  gst_bin_add (GST_BIN (td->pipeline), td->dynappsrc);
+
+  g_signal_connect (td->dynappsrc, "pad-added", G_CALLBACK (pad_added_cb),
+      td);
+  g_signal_connect (td->dynappsrc, "pad-removed",
+      G_CALLBACK (pad_removed_cb), td);
+  g_signal_connect (td->dynappsrc, "memory-released",
+      G_CALLBACK (memory_released_cb), td);
+  g_signal_connect (td->dynappsrc, "need-data", G_CALLBACK (need_data_cb),
+      td);
+
+  for (i = 0; i < n_sources; i++) {
+    g_signal_emit_by_name (td->dynappsrc, "new-appsrc", NULL,
+        &td->appsrc[i]);
+    fail_unless (td->appsrc[i] != NULL);
+  }
+  td->n_sources = n_sources;
+}
+
+static void
+start_test_objects (struct TestData *td)
+{
+  fail_if (gst_element_set_state (td->pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+}
+
+static void
+free_received (Received * r)
+{
+  g_bytes_unref (r->data);
+  g_slice_free (Received, r);
+}
+
+static void
+release_test_objects (struct TestData *td)
+{
+  fail_unless (gst_element_set_state (td->pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (td->pipeline);
+
+  g_list_free_full (td->received, (GDestroyNotify) free_received);
+  g_array_unref (td->masks);
+  g_mutex_clear (&td->lock);
+  g_cond_clear (&td->cond);
+}
+
+/* waits until @n buffers were received and @n_released memories were
+ * released */
+static void
+wait_for (struct TestData *td, guint n, guint n_released)
+{
+  gint64 deadline = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&td->lock);
+  while (td->n_received < n || td->n_released < n_released) {
+    if (!g_cond_wait_until (&td->cond, &td->lock, deadline))
+      break;
+  }
+  fail_unless (td->n_received >= n, "got %u buffers instead of %u",
+      td->n_received, n);
+  fail_unless (td->n_released >= n_released, "got %u releases instead of %u",
+      td->n_released, n_released);
+  g_mutex_unlock (&td->lock);
+}
+
+static void
+check_received (struct TestData *td, guint nth, guint source,
+    gconstpointer data, gsize size)
+{
+  Received *r = g_list_nth_data (td->received, nth);
+  gsize len;
+  gconstpointer bytes;
+
+  fail_unless (r != NULL);
+  fail_unless_equals_int (r->source, source);
+  bytes = g_bytes_get_data (r->data, &len);
+  fail_unless_equals_int (len, size);
+  fail_unless (memcmp (bytes, data, size) == 0);
+}
+
+GST_START_TEST (test_push_memory)
+{
+  struct TestData td;
+  static const gchar data[] = "zero-copy memory";
+  GstFlowReturn ret = GST_FLOW_ERROR;
+  gint slot = 0;
+
+  setup_test_objects (&td, 2);
+  start_test_objects (&td);
+
+  g_signal_emit_by_name (td.dynappsrc, "push-memory", 1, data,
+      (guint64) sizeof (data), (guint64) 0, GST_CLOCK_TIME_NONE, &slot, &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+
+  wait_for (&td, 1, 1);
+  check_received (&td, 0, 1, data, sizeof (data));
+
+  /* the release names the appsrc, not an index which may be stale */
+  fail_unless (td.released_appsrc == td.appsrc[1]);
+  fail_unless (td.released_user_data == &slot);
+
+  /* there is no source for an unknown index and nothing is released */
+  g_signal_emit_by_name (td.dynappsrc, "push-memory", 5, data,
+      (guint64) sizeof (data), (guint64) 0, GST_CLOCK_TIME_NONE, &slot, &ret);
+  fail_unless_equals_int (ret, GST_FLOW_ERROR);
+  fail_unless_equals_int (td.n_released, 1);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_push_fd)
+{
+  struct TestData td;
+  GstFlowReturn ret = GST_FLOW_ERROR;
+  gchar *filename = NULL;
+  gchar *contents;
+  gsize size = 3 * 4096, offset = 4096 + 123, i;
+  gint fd, slot = 0;
+
+  contents = g_malloc (size);
+  for (i = 0; i < size; i++)
+    contents[i] = i % 251;
+
+  fd = g_file_open_tmp ("dynappsrc-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  fail_unless (write (fd, contents, size) == (gssize) size);
+
+  setup_test_objects (&td, 1);
+  start_test_objects (&td);
+
+  /* an offset which is not page aligned */
+  g_signal_emit_by_name (td.dynappsrc, "push-fd", 0, fd, (guint64) offset,
+      (guint64) 1000, (guint64) 0, GST_CLOCK_TIME_NONE, &slot, &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+
+  wait_for (&td, 1, 1);
+  check_received (&td, 0, 0, contents + offset, 1000);
+  fail_unless (td.released_user_data == &slot);
+
+  release_test_objects (&td);
+
+  close (fd);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (contents);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pool_reuse)
+{
+  struct TestData td;
+  gchar data[16][32];
+  GstFlowReturn ret;
+  guint i;
+
+  setup_test_objects (&td, 1);
+  start_test_objects (&td);
+
+  /* the buffer shells are recycled, none of them may carry the memory of
+   * an earlier push */
+  for (i = 0; i < G_N_ELEMENTS (data); i++) {
+    g_snprintf (data[i], sizeof (data[i]), "buffer %u", i);
+
+    ret = GST_FLOW_ERROR;
+    g_signal_emit_by_name (td.dynappsrc, "push-memory", 0, data[i],
+        (guint64) sizeof (data[i]), (guint64) i * GST_SECOND,
+        GST_CLOCK_TIME_NONE, data[i], &ret);
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+    wait_for (&td, i + 1, i + 1);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (data); i++) {
+    Received *r = g_list_nth_data (td.received, i);
+
+    fail_unless_equals_int (r->n_memory, 1);
+    fail_unless_equals_uint64 (r->pts, i * GST_SECOND);
+    check_received (&td, i, 0, data[i], sizeof (data[i]));
+  }
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static GstBufferList *
+make_buffer_list (const gchar * prefix, guint n)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    gchar *data = g_strdup_printf ("%s %u", prefix, i);
+
+    gst_buffer_list_add (list, gst_buffer_new_wrapped (data,
+            strlen (data) + 1));
+  }
+
+  return list;
+}
+
+GST_START_TEST (test_push_buffer_lists)
+{
+  struct TestData td;
+  GstFlowReturn ret = GST_FLOW_ERROR;
+  GPtrArray *lists;
+  guint n_first = 0, n_second = 0;
+  GList *item;
+
+  setup_test_objects (&td, 2);
+  start_test_objects (&td);
+
+  lists = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_buffer_list_unref);
+  g_ptr_array_add (lists, make_buffer_list ("first", 3));
+  g_ptr_array_add (lists, make_buffer_list ("second", 3));
+
+  g_signal_emit_by_name (td.dynappsrc, "push-buffer-lists", lists, &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  wait_for (&td, 6, 0);
+
+  /* a failing source does not keep the other one from getting its list */
+  g_signal_emit_by_name (td.appsrc[0], "end-of-stream", &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+
+  g_signal_emit_by_name (td.dynappsrc, "push-buffer-lists", lists, &ret);
+  fail_unless_equals_int (ret, GST_FLOW_EOS);
+  wait_for (&td, 9, 0);
+
+  /* the sources stream in their own threads, check the order per source */
+  for (item = td.received; item; item = g_list_next (item)) {
+    Received *r = item->data;
+    gchar *data;
+
+    if (r->source == 0)
+      data = g_strdup_printf ("first %u", n_first++ % 3);
+    else
+      data = g_strdup_printf ("second %u", n_second++ % 3);
+
+    fail_unless_equals_string (g_bytes_get_data (r->data, NULL), data);
+    g_free (data);
+  }
+  fail_unless_equals_int (n_first, 3);
+  fail_unless_equals_int (n_second, 6);
+
+  g_ptr_array_unref (lists);
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+/* returns n-source of the next stream collection posted by dynappsrc */
+static gint
+pop_stream_collection (struct TestData *td)
+{
+  GstBus *bus = gst_element_get_bus (td->pipeline);
+  GstMessage *msg;
+  gint n_source = -1;
+
+  while ((msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+              GST_MESSAGE_ELEMENT))) {
+    const GstStructure *s = gst_message_get_structure (msg);
+
+    if (gst_structure_has_name (s, "dynappsrc-stream-collection")) {
+      fail_unless (gst_structure_get_int (s, "n-source", &n_source));
+      gst_message_unref (msg);
+      break;
+    }
+    gst_message_unref (msg);
+  }
+  gst_object_unref (bus);
+
+  return n_source;
+}
+
+GST_START_TEST (test_add_remove_running)
+{
+  struct TestData td;
+  static const gchar data[] = "late source";
+  GstFlowReturn ret = GST_FLOW_ERROR;
+  GstElement *appsrc = NULL;
+  gboolean removed = FALSE;
+
+  setup_test_objects (&td, 1);
+  start_test_objects (&td);
+  fail_unless_equals_int (pop_stream_collection (&td), 1);
+  fail_unless_equals_int (td.n_pads_added, 1);
+
+  /* a source added while running gets its pad right away */
+  g_signal_emit_by_name (td.dynappsrc, "new-appsrc", NULL, &appsrc);
+  fail_unless (appsrc != NULL);
+  fail_unless_equals_int (td.n_pads_added, 2);
+  fail_unless_equals_int (pop_stream_collection (&td), 2);
+
+  g_signal_emit_by_name (td.dynappsrc, "push-memory", 1, data,
+      (guint64) sizeof (data), (guint64) 0, GST_CLOCK_TIME_NONE, NULL, &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  wait_for (&td, 1, 1);
+  check_received (&td, 0, 1, data, sizeof (data));
+
+  /* removing the first source makes the new one index 0 */
+  g_signal_emit_by_name (td.dynappsrc, "remove-appsrc", td.appsrc[0],
+      &removed);
+  fail_unless (removed);
+  fail_unless_equals_int (td.n_pads_removed, 1);
+  fail_unless_equals_int (pop_stream_collection (&td), 1);
+
+  g_signal_emit_by_name (td.dynappsrc, "push-memory", 0, data,
+      (guint64) sizeof (data), (guint64) 0, GST_CLOCK_TIME_NONE, NULL, &ret);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  wait_for (&td, 2, 2);
+  check_received (&td, 1, 1, data, sizeof (data));
+  fail_unless (td.released_appsrc == appsrc);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+#define WRAP GST_DYN_APPSRC_WRAP_TIME
+
+GST_START_TEST (test_unwrap_timestamp)
+{
+  GstClockTime last = GST_CLOCK_TIME_NONE, offset = 0;
+
+  /* invalid timestamps pass through and don't touch the state */
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp
+      (GST_CLOCK_TIME_NONE, &last, &offset), GST_CLOCK_TIME_NONE);
+  fail_unless_equals_uint64 (last, GST_CLOCK_TIME_NONE);
+
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp (WRAP - GST_SECOND,
+          &last, &offset), WRAP - GST_SECOND);
+  fail_unless_equals_uint64 (offset, 0);
+
+  /* wraparound */
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp (GST_SECOND,
+          &last, &offset), WRAP + GST_SECOND);
+  fail_unless_equals_uint64 (offset, WRAP);
+  fail_unless_equals_uint64 (last, GST_SECOND);
+
+  /* a late timestamp from before the wraparound keeps the state */
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp (WRAP - 500 *
+          GST_MSECOND, &last, &offset), WRAP - 500 * GST_MSECOND);
+  fail_unless_equals_uint64 (offset, WRAP);
+  fail_unless_equals_uint64 (last, GST_SECOND);
+
+  /* a small jump back is not a wraparound */
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp (GST_SECOND / 2,
+          &last, &offset), WRAP + GST_SECOND / 2);
+  fail_unless_equals_uint64 (offset, WRAP);
+
+  /* the second wraparound */
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp (WRAP / 2,
+          &last, &offset), WRAP + WRAP / 2);
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp (WRAP - GST_SECOND,
+          &last, &offset), 2 * WRAP - GST_SECOND);
+  fail_unless_equals_uint64 (gst_dyn_appsrc_unwrap_timestamp (0, &last,
+          &offset), 2 * WRAP);
+  fail_unless_equals_uint64 (offset, 2 * WRAP);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unwrap_segment)
+{
+  GstSegment segment;
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  segment.start = GST_SECOND;
+  segment.stop = 10 * GST_SECOND;
+  segment.time = 0;
+  segment.position = GST_SECOND;
+
+  /* nothing seen yet */
+  fail_if (gst_dyn_appsrc_unwrap_segment (&segment, GST_CLOCK_TIME_NONE, 0));
+  fail_unless_equals_uint64 (segment.start, GST_SECOND);
+
+  /* after a wraparound the segment moves with the buffers */
+  fail_unless (gst_dyn_appsrc_unwrap_segment (&segment, WRAP - GST_SECOND,
+          0));
+  fail_unless_equals_uint64 (segment.start, WRAP + GST_SECOND);
+  fail_unless_equals_uint64 (segment.stop, WRAP + 10 * GST_SECOND);
+  fail_unless_equals_uint64 (segment.position, WRAP + GST_SECOND);
+  fail_unless_equals_uint64 (segment.time, 0);
+
+  /* an open segment keeps its open end */
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_dyn_appsrc_unwrap_segment (&segment, GST_SECOND, WRAP));
+  fail_unless_equals_uint64 (segment.start, WRAP);
+  fail_unless_equals_uint64 (segment.stop, GST_CLOCK_TIME_NONE);
+}
+
+GST_END_TEST;
+
+/* seek-data handlers of the appsrc elements, they meet in a barrier or
+ * wait at a gate */
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint n_expected;
+  guint n_entered;
+  guint n_met;
+  gboolean gate;
+  gboolean gate_open;
+  GArray *offsets;
+} SeekState;
+
+static void
+seek_state_init (SeekState * ss, guint n_expected)
+{
+  memset (ss, 0, sizeof (SeekState));
+  g_mutex_init (&ss->lock);
+  g_cond_init (&ss->cond);
+  ss->n_expected = n_expected;
+}
+
+static void
+seek_state_clear (SeekState * ss)
+{
+  if (ss->offsets)
+    g_array_unref (ss->offsets);
+  g_mutex_clear (&ss->lock);
+  g_cond_clear (&ss->cond);
+}
+
+static gboolean
+appsrc_seek_data_cb (GstElement * appsrc, guint64 offset, SeekState * ss)
+{
+  gint64 deadline = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&ss->lock);
+  ss->n_entered++;
+  g_cond_broadcast (&ss->cond);
+  while ((ss->gate && !ss->gate_open) || ss->n_entered < ss->n_expected) {
+    if (!g_cond_wait_until (&ss->cond, &ss->lock, deadline))
+      break;
+  }
+  if (ss->n_entered >= ss->n_expected)
+    ss->n_met++;
+  g_mutex_unlock (&ss->lock);
+
+  return TRUE;
+}
+
+static gboolean
+dynappsrc_seek_data_cb (GstElement * dynappsrc, GArray * offsets,
+    SeekState * ss)
+{
+  g_mutex_lock (&ss->lock);
+  if (ss->offsets)
+    g_array_unref (ss->offsets);
+  ss->offsets = g_array_ref (offsets);
+  g_mutex_unlock (&ss->lock);
+
+  return TRUE;
+}
+
+static GstEvent *
+new_byte_seek (gint64 offset)
+{
+  return gst_event_new_seek (1.0, GST_FORMAT_BYTES, GST_SEEK_FLAG_FLUSH,
+      GST_SEEK_TYPE_SET, offset, GST_SEEK_TYPE_NONE, -1);
+}
+
+static gboolean
+send_seek (GstElement * dynappsrc, const gchar * padname, GstEvent * event)
+{
+  GstPad *pad = gst_element_get_static_pad (dynappsrc, padname);
+  gboolean res;
+
+  fail_unless (pad != NULL);
+  res = gst_pad_send_event (pad, event);
+  gst_object_unref (pad);
+
+  return res;
+}
+
+GST_START_TEST (test_seek_fanout)
+{
+  struct TestData td;
+  SeekState ss;
+  guint i;
+
+  setup_test_objects (&td, 4);
+  seek_state_init (&ss, 3);
+
+  /* the first three sources only get through the barrier when they are
+   * seeked at the same time, the last one is not seekable */
+  for (i = 0; i < 3; i++) {
+    g_object_set (td.appsrc[i], "stream-type", 1, NULL);
+    g_signal_connect (td.appsrc[i], "seek-data",
+        G_CALLBACK (appsrc_seek_data_cb), &ss);
+  }
+  g_signal_connect (td.dynappsrc, "seek-data",
+      G_CALLBACK (dynappsrc_seek_data_cb), &ss);
+  start_test_objects (&td);
+
+  send_seek (td.dynappsrc, "src_0", new_byte_seek (1000));
+
+  fail_unless_equals_int (ss.n_met, 3);
+
+  /* one seek-data with the offset of every source */
+  fail_unless (ss.offsets != NULL);
+  fail_unless_equals_int (ss.offsets->len, 4);
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_uint64 (g_array_index (ss.offsets, guint64, i), 1000);
+  fail_unless_equals_uint64 (g_array_index (ss.offsets, guint64, 3),
+      GST_BUFFER_OFFSET_NONE);
+
+  seek_state_clear (&ss);
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GstElement *dynappsrc;
+  const gchar *padname;
+  GstEvent *event;
+  SeekState *ss;
+  gboolean saw_gate_open;
+} SeekThreadData;
+
+static gpointer
+seek_thread_func (SeekThreadData * data)
+{
+  gboolean res = send_seek (data->dynappsrc, data->padname, data->event);
+
+  g_mutex_lock (&data->ss->lock);
+  data->saw_gate_open = data->ss->gate_open;
+  g_mutex_unlock (&data->ss->lock);
+
+  return GINT_TO_POINTER (res);
+}
+
+GST_START_TEST (test_seek_dedup)
+{
+  struct TestData td;
+  SeekState ss;
+  SeekThreadData first, copy;
+  GThread *first_thread, *copy_thread;
+  GstEvent *event;
+
+  setup_test_objects (&td, 2);
+  seek_state_init (&ss, 1);
+  ss.gate = TRUE;
+
+  g_object_set (td.appsrc[0], "stream-type", 1, NULL);
+  g_object_set (td.appsrc[1], "stream-type", 1, NULL);
+  g_signal_connect (td.appsrc[0], "seek-data",
+      G_CALLBACK (appsrc_seek_data_cb), &ss);
+  start_test_objects (&td);
+
+  event = new_byte_seek (0);
+  first.dynappsrc = copy.dynappsrc = td.dynappsrc;
+  first.ss = copy.ss = &ss;
+  first.padname = "src_0";
+  first.event = gst_event_ref (event);
+  copy.padname = "src_1";
+  copy.event = event;
+
+  /* the first seek is held at the gate of the first source */
+  first_thread = g_thread_new ("seek", (GThreadFunc) seek_thread_func,
+      &first);
+  g_mutex_lock (&ss.lock);
+  while (ss.n_entered == 0)
+    g_cond_wait (&ss.cond, &ss.lock);
+  g_mutex_unlock (&ss.lock);
+
+  /* the copy of the seek from another thread waits for its result */
+  copy_thread = g_thread_new ("seek-copy", (GThreadFunc) seek_thread_func,
+      &copy);
+  g_usleep (50 * G_TIME_SPAN_MILLISECOND);
+
+  g_mutex_lock (&ss.lock);
+  ss.gate_open = TRUE;
+  g_cond_broadcast (&ss.cond);
+  g_mutex_unlock (&ss.lock);
+
+  fail_unless (g_thread_join (first_thread));
+  fail_unless (g_thread_join (copy_thread));
+
+  fail_unless (copy.saw_gate_open);
+  fail_unless_equals_int (ss.n_entered, 1);
+
+  seek_state_clear (&ss);
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+/* waits until the last need-data reported @mask */
+static void
+wait_for_mask (struct TestData *td, guint64 mask)
+{
+  gint64 deadline = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  guint64 last = G_MAXUINT64;
+
+  g_mutex_lock (&td->lock);
+  while (TRUE) {
+    if (td->masks->len > 0)
+      last = g_array_index (td->masks, guint64, td->masks->len - 1);
+    if (last == mask)
+      break;
+    if (!g_cond_wait_until (&td->cond, &td->lock, deadline))
+      break;
+  }
+  g_mutex_unlock (&td->lock);
+
+  fail_unless_equals_uint64 (last, mask);
+}
+
+GST_START_TEST (test_need_data)
+{
+  struct TestData td;
+  static const gchar data[64] = { 0, };
+  GstFlowReturn ret;
+  gboolean res = FALSE;
+  guint i;
+
+  setup_test_objects (&td, 1);
+  fail_if (gst_element_set_state (td.pipeline,
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (td.dynappsrc, "set-watermarks", 0, (guint64) 10,
+      (guint64) 100, (guint64) 0, (guint64) 0, &res);
+  fail_unless (res);
+  wait_for_mask (&td, 1);
+
+  /* the sink holds the first buffer in PAUSED, the others fill appsrc */
+  for (i = 0; i < 3; i++) {
+    ret = GST_FLOW_ERROR;
+    g_signal_emit_by_name (td.dynappsrc, "push-memory", 0, data,
+        (guint64) sizeof (data), (guint64) i * GST_SECOND,
+        GST_CLOCK_TIME_NONE, NULL, &ret);
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+  }
+  wait_for_mask (&td, 0);
+
+  /* appsrc drains in PLAYING */
+  start_test_objects (&td);
+  wait_for (&td, 3, 3);
+  wait_for_mask (&td, 1);
+
+  /* each mask is a change of the previous one */
+  for (i = 1; i < td.masks->len; i++)
+    fail_if (g_array_index (td.masks, guint64, i) ==
+        g_array_index (td.masks, guint64, i - 1));
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static void
+wait_for_eos (struct TestData *td)
+{
+  GstBus *bus = gst_element_get_bus (td->pipeline);
+  GstMessage *msg;
+
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+/* describes what @source received, in order */
+static gchar *
+describe_source (struct TestData *td, guint source)
+{
+  GString *desc = g_string_new (NULL);
+  GList *item;
+
+  for (item = td->received; item; item = g_list_next (item)) {
+    Received *r = item->data;
+
+    if (r->source == source)
+      g_string_append_printf (desc, "%" GST_TIME_FORMAT " %s\n",
+          GST_TIME_ARGS (r->pts), (const gchar *) g_bytes_get_data (r->data,
+              NULL));
+  }
+
+  return g_string_free (desc, FALSE);
+}
+
+GST_START_TEST (test_record_replay)
+{
+  struct TestData td;
+  GstFlowReturn ret;
+  gchar *location, *recorded[2];
+  guint i, j;
+  gint fd;
+
+  fd = g_file_open_tmp ("dynappsrc-XXXXXX.rec", &location, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+
+  /* the sources produce segments in different formats */
+  setup_test_objects (&td, 2);
+  g_object_set (td.dynappsrc, "record-location", location, NULL);
+  g_object_set (td.appsrc[1], "format", GST_FORMAT_TIME, NULL);
+  start_test_objects (&td);
+
+  for (i = 0; i < 2; i++) {
+    for (j = 0; j < 3; j++) {
+      gchar *data = g_strdup_printf ("source %u buffer %u", i, j);
+      GstBuffer *buffer = gst_buffer_new_wrapped (data, strlen (data) + 1);
+
+      GST_BUFFER_PTS (buffer) = (i + j) * GST_SECOND;
+      g_signal_emit_by_name (td.appsrc[i], "push-buffer", buffer, &ret);
+      fail_unless_equals_int (ret, GST_FLOW_OK);
+      gst_buffer_unref (buffer);
+    }
+    g_signal_emit_by_name (td.appsrc[i], "end-of-stream", &ret);
+  }
+  wait_for_eos (&td);
+
+  fail_unless_equals_int (td.segment_format[0], GST_FORMAT_BYTES);
+  fail_unless_equals_int (td.segment_format[1], GST_FORMAT_TIME);
+  for (i = 0; i < 2; i++)
+    recorded[i] = describe_source (&td, i);
+  release_test_objects (&td);
+
+  /* the replay creates the same sources and feeds the same data */
+  setup_test_objects (&td, 0);
+  g_object_set (td.dynappsrc, "replay-location", location, "replay-sync",
+      FALSE, NULL);
+  start_test_objects (&td);
+  wait_for_eos (&td);
+
+  fail_unless_equals_int (td.n_pads_added, 2);
+  fail_unless_equals_int (td.segment_format[0], GST_FORMAT_BYTES);
+  fail_unless_equals_int (td.segment_format[1], GST_FORMAT_TIME);
+  for (i = 0; i < 2; i++) {
+    gchar *replayed = describe_source (&td, i);
+
+    fail_unless_equals_string (replayed, recorded[i]);
+    g_free (replayed);
+    g_free (recorded[i]);
+  }
+  release_test_objects (&td);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_record_removed)
+{
+  struct TestData td;
+  GstFlowReturn ret;
+  gchar *location, *recorded[2];
+  gboolean removed = FALSE;
+  guint i;
+  gint fd;
+
+  fd = g_file_open_tmp ("dynappsrc-XXXXXX.rec", &location, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+
+  setup_test_objects (&td, 2);
+  g_object_set (td.dynappsrc, "record-location", location, NULL);
+  start_test_objects (&td);
+
+  for (i = 0; i < 3; i++) {
+    gchar *data = g_strdup_printf ("source %u buffer %u", i > 0, i);
+    GstBuffer *buffer = gst_buffer_new_wrapped (data, strlen (data) + 1);
+
+    GST_BUFFER_PTS (buffer) = i * GST_SECOND;
+    g_signal_emit_by_name (td.appsrc[i > 0], "push-buffer", buffer, &ret);
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+    gst_buffer_unref (buffer);
+
+    /* the second source keeps its id once the first one is gone */
+    if (i == 0) {
+      wait_for (&td, 1, 0);
+      g_signal_emit_by_name (td.dynappsrc, "remove-appsrc", td.appsrc[0],
+          &removed);
+      fail_unless (removed);
+    }
+  }
+  g_signal_emit_by_name (td.appsrc[1], "end-of-stream", &ret);
+  wait_for_eos (&td);
+
+  for (i = 0; i < 2; i++)
+    recorded[i] = describe_source (&td, i);
+  release_test_objects (&td);
+
+  /* the removed source is replayed up to its EOS */
+  setup_test_objects (&td, 0);
+  g_object_set (td.dynappsrc, "replay-location", location, "replay-sync",
+      FALSE, NULL);
+  start_test_objects (&td);
+  wait_for_eos (&td);
+
+  fail_unless_equals_int (td.n_pads_added, 2);
+  for (i = 0; i < 2; i++) {
+    gchar *replayed = describe_source (&td, i);
+
+    fail_unless_equals_string (replayed, recorded[i]);
+    g_free (replayed);
+    g_free (recorded[i]);
+  }
+  release_test_objects (&td);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_replay_corrupted)
+{
+  struct TestData td;
+  gchar header[16] = "DYNAPREC";
+  guint32 version = 1, record[12] = { 0, };
+  gchar *location;
+  FILE *file;
+  gint fd;
+
+  fd = g_file_open_tmp ("dynappsrc-XXXXXX.rec", &location, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+
+  /* a buffer record of a source id no capture can have */
+  memcpy (header + 8, &version, sizeof (version));
+  record[0] = GST_DYN_APPSRC_RECORD_BUFFER;
+  record[1] = G_MAXUINT32;
+  file = g_fopen (location, "wb");
+  fail_unless (file != NULL);
+  fail_unless_equals_int (fwrite (header, sizeof (header), 1, file), 1);
+  fail_unless_equals_int (fwrite (record, sizeof (record), 1, file), 1);
+  fclose (file);
+
+  setup_test_objects (&td, 0);
+  g_object_set (td.dynappsrc, "replay-location", location, NULL);
+  fail_unless (gst_element_set_state (td.pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (td.n_pads_added, 0);
+  release_test_objects (&td);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+static Suite *
+dynappsrc_suite (void)
+{
+  Suite *s = suite_create ("dynappsrc");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("general");
+  tcase_add_test (tc_chain, test_unwrap_timestamp);
+  tcase_add_test (tc_chain, test_unwrap_segment);
+  tcase_add_test (tc_chain, test_push_memory);
+  tcase_add_test (tc_chain, test_push_fd);
+  tcase_add_test (tc_chain, test_pool_reuse);
+  tcase_add_test (tc_chain, test_push_buffer_lists);
+  tcase_add_test (tc_chain, test_add_remove_running);
+  tcase_add_test (tc_chain, test_seek_fanout);
+  tcase_add_test (tc_chain, test_seek_dedup);
+  tcase_add_test (tc_chain, test_need_data);
+  tcase_add_test (tc_chain, test_record_replay);
+  tcase_add_test (tc_chain, test_record_removed);
+  tcase_add_test (tc_chain, test_replay_corrupted);
+
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dynappsrc);
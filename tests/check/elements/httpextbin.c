@@ -25,6 +25,8 @@
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
 
 static GType gst_http_filter_get_type (void);
 
@@ -51,22 +53,53 @@ static GstStaticPadTemplate filter_src_templ = GST_STATIC_PAD_TEMPLATE ("src",
 
 G_DEFINE_TYPE (GstHttpFilter, gst_http_filter, GST_TYPE_ELEMENT);
 
-static void
-gst_http_filter_finalize (GObject * object)
+/* whether the test filter pulls from upstream when it can */
+static gboolean filter_pull = FALSE;
+
+#define FILE_BYTE(offset) ((guint8) ((offset) % 251))
+
+static gboolean
+gst_http_filter_sink_activate (GstPad * pad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull = FALSE;
+
+  if (filter_pull) {
+    query = gst_query_new_scheduling ();
+    if (gst_pad_peer_query (pad, query))
+      pull = gst_query_has_scheduling_mode_with_flags (query,
+          GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+    gst_query_unref (query);
+  }
+
+  return gst_pad_activate_mode (pad, pull ? GST_PAD_MODE_PULL :
+      GST_PAD_MODE_PUSH, TRUE);
+}
+
+/* buffers that reached the test filter */
+static GMutex filter_lock;
+static GCond filter_cond;
+static guint filter_buffers = 0;
+
+/* the data is dropped, nothing is linked downstream of httpextbin */
+static GstFlowReturn
+gst_http_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
-  GstHttpFilter *demux = (GstHttpFilter *) object;
+  gst_buffer_unref (buffer);
 
-  G_OBJECT_CLASS (gst_http_filter_parent_class)->finalize (object);
+  g_mutex_lock (&filter_lock);
+  filter_buffers++;
+  g_cond_broadcast (&filter_cond);
+  g_mutex_unlock (&filter_lock);
+
+  return GST_FLOW_OK;
 }
 
 static void
 gst_http_filter_class_init (GstHttpFilterClass * klass)
 {
-  GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
 
-  gobject_class->finalize = gst_http_filter_finalize;
-
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&filter_sink_templ));
   gst_element_class_add_pad_template (element_class,
@@ -82,6 +115,9 @@ gst_http_filter_init (GstHttpFilter * filter)
 {
   filter->sinkpad =
       gst_pad_new_from_static_template (&filter_sink_templ, "sink");
+  gst_pad_set_chain_function (filter->sinkpad, gst_http_filter_chain);
+  gst_pad_set_activate_function (filter->sinkpad,
+      gst_http_filter_sink_activate);
   gst_element_add_pad (GST_ELEMENT (filter), filter->sinkpad);
 
   filter->srcpad = gst_pad_new_from_static_template (&filter_src_templ, "src");
@@ -114,8 +150,11 @@ GST_START_TEST (test_uri_interface)
   uri_protocols = gst_uri_handler_get_protocols (GST_URI_HANDLER (httpextbin));
 
   if (uri_protocols && *uri_protocols) {
-    for (; *uri_protocols != NULL; uri_protocols++)
+    /* only the built-in table is advertised, whatever the configuration */
+    for (; *uri_protocols != NULL; uri_protocols++) {
       GST_DEBUG ("Supported URI protocols : %s", *uri_protocols);
+      fail_unless (g_str_has_suffix (*uri_protocols, "+bbts"));
+    }
   } else {
     fail ("No supported URI protocols");
   }
@@ -130,7 +169,7 @@ GST_START_TEST (test_set_uri)
 {
   GstElement *httpextbin;
   gchar *uri;
-  gchar **item;
+  const gchar **item;
 
   const gchar *uris[] =
       { "http+justin://", "http+hoonhee://", "https+wonchul://", NULL };
@@ -138,7 +177,7 @@ GST_START_TEST (test_set_uri)
   httpextbin = gst_element_factory_make ("httpextbin", NULL);
   fail_unless (httpextbin != NULL, "Could not create httpextbin element");
 
-  for (item = uris; *item != NULL; *item++) {
+  for (item = uris; *item != NULL; item++) {
     GST_DEBUG ("Try to set uri : %s", *item);
     g_object_set (httpextbin, "uri", *item, NULL);
     g_object_get (httpextbin, "uri", &uri, NULL);
@@ -244,7 +283,7 @@ GST_END_TEST;
 GST_START_TEST (test_repeat_state_change)
 {
   GstElement *httpextbin;
-  gchar **item;
+  const gchar **item;
 
   const gchar *uris[] =
       { "http+justin://", "http+jeongseok://", "http+hoonhee://",
@@ -260,7 +299,7 @@ GST_START_TEST (test_repeat_state_change)
   g_signal_connect (httpextbin, "pad-added",
       G_CALLBACK (httpextbin_pad_added_cb), NULL);
 
-  for (item = uris; *item != NULL; *item++) {
+  for (item = uris; *item != NULL; item++) {
     GST_DEBUG ("Try to set uri : %s", *item);
     g_object_set (httpextbin, "uri", *item, NULL);
 
@@ -286,18 +325,576 @@ GST_START_TEST (test_repeat_state_change)
 
 GST_END_TEST;
 
+static GstElement *
+get_filter_element (GstElement * httpextbin)
+{
+  GstIterator *it;
+  GValue data = { 0, };
+  GstElement *filter = NULL;
+
+  it = gst_bin_iterate_elements (GST_BIN (httpextbin));
+  while (gst_iterator_next (it, &data) == GST_ITERATOR_OK) {
+    GstElement *child = g_value_get_object (&data);
+    GstElementFactory *factory = gst_element_get_factory (child);
+
+    if (factory && g_str_has_prefix (GST_OBJECT_NAME (factory), "httpfilter")) {
+      if (filter)
+        gst_object_unref (filter);
+      filter = gst_object_ref (child);
+    }
+    g_value_reset (&data);
+  }
+  g_value_unset (&data);
+  gst_iterator_free (it);
+
+  return filter;
+}
+
+static gchar *
+get_filter_factory_name (GstElement * httpextbin)
+{
+  GstElement *filter;
+  gchar *name;
+
+  if (!(filter = get_filter_element (httpextbin)))
+    return NULL;
+
+  name = g_strdup (GST_OBJECT_NAME (gst_element_get_factory (filter)));
+  gst_object_unref (filter);
+
+  return name;
+}
+
+GST_START_TEST (test_filter_cache)
+{
+  GstElement *httpextbin;
+  gchar *name;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  g_object_set (httpextbin, "uri", "http+justin://", NULL);
+
+  /* the second start is served from the cache */
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  name = get_filter_factory_name (httpextbin);
+  fail_unless_equals_string (name, "httpfilter");
+  g_free (name);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* a better filter registered later invalidates the cache */
+  fail_unless (gst_element_register (NULL, "httpfilter2",
+          GST_RANK_PRIMARY + 200, gst_http_filter_get_type ()));
+
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  name = get_filter_factory_name (httpextbin);
+  fail_unless_equals_string (name, "httpfilter2");
+  g_free (name);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (httpextbin);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_cache)
+{
+  GstElement *httpextbin;
+  GstElement *cache;
+  guint64 ring_buffer_max_size = 0;
+  guint max_size_bytes = 0;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  g_object_set (httpextbin, "uri", "http+justin://", "cache-size",
+      (guint64) 4 * 1024 * 1024, "read-ahead", 512 * 1024, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cache = gst_bin_get_by_name (GST_BIN (httpextbin), "cache");
+  fail_unless (cache != NULL, "No cache element between source and filter");
+
+  g_object_get (cache, "ring-buffer-max-size", &ring_buffer_max_size,
+      "max-size-bytes", &max_size_bytes, NULL);
+  fail_unless_equals_uint64 (ring_buffer_max_size, 4 * 1024 * 1024);
+  fail_unless_equals_int (max_size_bytes, 512 * 1024);
+  gst_object_unref (cache);
+
+  /* the cache is gone without cache-size */
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_set (httpextbin, "cache-size", (guint64) 0, NULL);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_bin_get_by_name (GST_BIN (httpextbin), "cache") == NULL);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (httpextbin);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+count_seek_cb (GstPad * pad, GstPadProbeInfo * info, gint * seeks)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_SEEK)
+    g_atomic_int_inc (seeks);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+check_pull_range (GstPad * pad, guint64 offset, guint length)
+{
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+  gsize i;
+
+  fail_unless_equals_int (gst_pad_pull_range (pad, offset, length, &buf),
+      GST_FLOW_OK);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, length);
+  for (i = 0; i < map.size; i++) {
+    if (map.data[i] != FILE_BYTE (offset + i))
+      fail ("unexpected data at offset %" G_GUINT64_FORMAT,
+          offset + (guint64) i);
+  }
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+}
+
+#define CACHE_FILE_SIZE (256 * 1024)
+
+static gchar *
+create_cache_file (void)
+{
+  guint8 *contents;
+  gchar *filename;
+  gint fd, i;
+
+  fd = g_file_open_tmp (NULL, &filename, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  contents = g_malloc (CACHE_FILE_SIZE);
+  for (i = 0; i < CACHE_FILE_SIZE; i++)
+    contents[i] = FILE_BYTE (i);
+  fail_unless (g_file_set_contents (filename, (gchar *) contents,
+          CACHE_FILE_SIZE, NULL));
+  g_free (contents);
+
+  return filename;
+}
+
+GST_START_TEST (test_cache_backward_seek)
+{
+  GstElement *httpextbin, *source, *filter;
+  GstPad *srcpad, *sinkpad;
+  gchar *filename, *uri;
+  gint seeks = 0;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  filename = create_cache_file ();
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  uri = g_strdup_printf ("file+justin://%s", filename);
+  g_object_set (httpextbin, "uri", uri, "cache-size",
+      (guint64) 1024 * 1024, "read-ahead", 512 * 1024, NULL);
+  g_free (uri);
+
+  /* the filter reads from the cache in pull mode */
+  filter_pull = TRUE;
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  g_object_get (httpextbin, "source", &source, NULL);
+  srcpad = gst_element_get_static_pad (source, "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+      (GstPadProbeCallback) count_seek_cb, &seeks, NULL);
+
+  filter = get_filter_element (httpextbin);
+  fail_unless (filter != NULL);
+  sinkpad = gst_element_get_static_pad (filter, "sink");
+  fail_unless_equals_int (GST_PAD_MODE (sinkpad), GST_PAD_MODE_PULL);
+
+  /* read the start and the end, the end is within the read-ahead */
+  check_pull_range (sinkpad, 0, 4096);
+  check_pull_range (sinkpad, CACHE_FILE_SIZE - 4096, 4096);
+  fail_unless_equals_int (g_atomic_int_get (&seeks), 0);
+
+  /* going back is served from the cache, no new request is made */
+  check_pull_range (sinkpad, 0, 4096);
+  check_pull_range (sinkpad, 100 * 1000, 1000);
+  fail_unless_equals_int (g_atomic_int_get (&seeks), 0);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+  filter_pull = FALSE;
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (filter);
+  gst_object_unref (srcpad);
+  gst_object_unref (source);
+  gst_object_unref (httpextbin);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+static void
+wait_filter_buffers (guint n_buffers)
+{
+  gint64 deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+
+  g_mutex_lock (&filter_lock);
+  while (filter_buffers < n_buffers)
+    fail_unless (g_cond_wait_until (&filter_cond, &filter_lock, deadline));
+  g_mutex_unlock (&filter_lock);
+}
+
+GST_START_TEST (test_cache_push_seek)
+{
+  GstElement *httpextbin, *source, *filter;
+  GstPad *srcpad, *sinkpad;
+  gchar *filename, *uri;
+  gint seeks = 0;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  filename = create_cache_file ();
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  uri = g_strdup_printf ("file+justin://%s", filename);
+  g_object_set (httpextbin, "uri", uri, "cache-size",
+      (guint64) 1024 * 1024, "read-ahead", 512 * 1024, NULL);
+  g_free (uri);
+
+  filter_buffers = 0;
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  g_object_get (httpextbin, "source", &source, NULL);
+  srcpad = gst_element_get_static_pad (source, "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+      (GstPadProbeCallback) count_seek_cb, &seeks, NULL);
+
+  filter = get_filter_element (httpextbin);
+  fail_unless (filter != NULL);
+  sinkpad = gst_element_get_static_pad (filter, "sink");
+  fail_unless_equals_int (GST_PAD_MODE (sinkpad), GST_PAD_MODE_PUSH);
+
+  /* the whole file is pushed in blocks of 4096 bytes */
+  wait_filter_buffers (CACHE_FILE_SIZE / 4096);
+
+  /* the filter seeks back in push mode, the cache serves it */
+  fail_unless (gst_pad_push_event (sinkpad, gst_event_new_seek (1.0,
+              GST_FORMAT_BYTES, GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 0,
+              GST_SEEK_TYPE_NONE, -1)));
+  wait_filter_buffers (2 * CACHE_FILE_SIZE / 4096);
+  fail_unless_equals_int (g_atomic_int_get (&seeks), 0);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (filter);
+  gst_object_unref (srcpad);
+  gst_object_unref (source);
+  gst_object_unref (httpextbin);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reuse_source)
+{
+  GstElement *httpextbin;
+  GstElement *first, *second;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  g_object_set (httpextbin, "uri", "http+justin://localhost/first", NULL);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (httpextbin, "source", &first, NULL);
+  fail_unless (first != NULL);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* same origin, only the location of the source changes. The element is
+   * kept, souphttpsrc still opens a new session when it starts again. */
+  g_object_set (httpextbin, "uri", "http+justin://localhost/second", NULL);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (httpextbin, "source", &second, NULL);
+  fail_unless (first == second);
+  gst_object_unref (second);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* other origin, the elements are recreated */
+  g_object_set (httpextbin, "uri", "http+justin://127.0.0.1/third", NULL);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (httpextbin, "source", &second, NULL);
+  fail_unless (first != second);
+  gst_object_unref (second);
+  gst_object_unref (first);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (httpextbin);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reuse_file_source)
+{
+  GstElement *httpextbin;
+  GstElement *first, *second;
+  gchar *filenames[2], *uri;
+  gint fd, i;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  for (i = 0; i < 2; i++) {
+    fd = g_file_open_tmp (NULL, &filenames[i], NULL);
+    fail_unless (fd >= 0);
+    close (fd);
+  }
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  uri = g_strdup_printf ("file+justin://%s", filenames[0]);
+  g_object_set (httpextbin, "uri", uri, NULL);
+  g_free (uri);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (httpextbin, "source", &first, NULL);
+  fail_unless (first != NULL);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* local files have no host, each of them is an origin of its own */
+  uri = g_strdup_printf ("file+justin://%s", filenames[1]);
+  g_object_set (httpextbin, "uri", uri, NULL);
+  g_free (uri);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (httpextbin, "source", &second, NULL);
+  fail_unless (first != second);
+  gst_object_unref (first);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* the same file again keeps the elements */
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (httpextbin, "source", &first, NULL);
+  fail_unless (first == second);
+  gst_object_unref (first);
+  gst_object_unref (second);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (httpextbin);
+
+  for (i = 0; i < 2; i++) {
+    g_unlink (filenames[i]);
+    g_free (filenames[i]);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_stats)
+{
+  GstElement *httpextbin;
+  guint stats_interval = 0;
+  gint download_rate = 0;
+  guint64 first_byte_latency = 0;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  g_object_set (httpextbin, "uri", "http+justin://", "stats-interval", 500,
+      NULL);
+  g_object_get (httpextbin, "stats-interval", &stats_interval, NULL);
+  fail_unless_equals_int (stats_interval, 500);
+
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* nothing is downloaded yet */
+  g_object_get (httpextbin, "download-rate", &download_rate,
+      "first-byte-latency", &first_byte_latency, NULL);
+  fail_unless_equals_int (download_rate, -1);
+  fail_unless (first_byte_latency == GST_CLOCK_TIME_NONE);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (httpextbin);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_first_byte_latency)
+{
+  GstElement *httpextbin;
+  guint64 first_byte_latency = 0;
+  gint64 deadline;
+  gchar *filename, *uri;
+  gint fd;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  fd = g_file_open_tmp (NULL, &filename, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  fail_unless (g_file_set_contents (filename, "justin", -1, NULL));
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  uri = g_strdup_printf ("file+justin://%s", filename);
+  g_object_set (httpextbin, "uri", uri, NULL);
+  g_free (uri);
+
+  filter_buffers = 0;
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* the latency is known once the first byte went through */
+  deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+  g_mutex_lock (&filter_lock);
+  while (filter_buffers == 0)
+    fail_unless (g_cond_wait_until (&filter_cond, &filter_lock, deadline));
+  g_mutex_unlock (&filter_lock);
+
+  g_object_get (httpextbin, "first-byte-latency", &first_byte_latency, NULL);
+  fail_unless (first_byte_latency != GST_CLOCK_TIME_NONE);
+  fail_unless (first_byte_latency < GST_SECOND);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (httpextbin);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_file_source)
+{
+  GstElement *httpextbin;
+  GstElement *source;
+  const gchar *const *uri_protocols;
+  gboolean found = FALSE;
+  gchar *filename, *uri;
+  gint fd;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  fail_unless (httpextbin != NULL, "Could not create httpextbin element");
+
+  uri_protocols = gst_uri_handler_get_protocols (GST_URI_HANDLER (httpextbin));
+  for (; uri_protocols && *uri_protocols; uri_protocols++)
+    found |= (g_strcmp0 (*uri_protocols, "file+bbts") == 0);
+  fail_unless (found, "file+bbts is not a supported protocol");
+
+  fd = g_file_open_tmp (NULL, &filename, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+
+  /* local file through the same filter path */
+  uri = g_strdup_printf ("file+justin://%s", filename);
+  g_object_set (httpextbin, "uri", uri, NULL);
+  g_free (uri);
+
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  g_object_get (httpextbin, "source", &source, NULL);
+  fail_unless (source != NULL);
+  fail_unless_equals_string (GST_OBJECT_NAME (gst_element_get_factory
+          (source)), "filesrc");
+  gst_object_unref (source);
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+
+  gst_object_unref (httpextbin);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
 static Suite *
 httpextbin_suite (void)
 {
   Suite *s = suite_create ("httpextbin");
   TCase *tc_chain;
+  GstElementFactory *soup;
 
   tc_chain = tcase_create ("general");
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_set_uri);
   //tcase_add_test (tc_chain, test_missing_plugin);
-  tcase_add_test (tc_chain, test_set_state_paused);
-  tcase_add_test (tc_chain, test_repeat_state_change);
+  tcase_add_test (tc_chain, test_file_source);
+  tcase_add_test (tc_chain, test_cache_backward_seek);
+  tcase_add_test (tc_chain, test_cache_push_seek);
+  tcase_add_test (tc_chain, test_reuse_file_source);
+  tcase_add_test (tc_chain, test_first_byte_latency);
+
+  /* the http transport needs souphttpsrc from gst-plugins-good */
+  if ((soup = gst_element_factory_find ("souphttpsrc"))) {
+    tcase_add_test (tc_chain, test_set_state_paused);
+    tcase_add_test (tc_chain, test_repeat_state_change);
+    tcase_add_test (tc_chain, test_filter_cache);
+    tcase_add_test (tc_chain, test_cache);
+    tcase_add_test (tc_chain, test_reuse_source);
+    tcase_add_test (tc_chain, test_stats);
+    gst_object_unref (soup);
+  }
 
   suite_add_tcase (s, tc_chain);
 
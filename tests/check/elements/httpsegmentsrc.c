@@ -0,0 +1,356 @@
+/* GStreamer unit tests for the httpsegmentsrc
+ *
+ * Copyright 2014 LGE Corporation.
+ *  @author: Hoonhee Lee <hoonhee.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/* size of the resource served by the stand-in server */
+#define RESOURCE_SIZE (2 * 1024 * 1024)
+/* each connection is throttled to 16KB every 4ms, about 4MB/s */
+#define SEND_BLOCK (16 * 1024)
+#define SEND_DELAY (4 * 1000)
+
+#define RESOURCE_BYTE(offset) ((guint8) ((offset) % 251))
+
+static gint server_fd = -1;
+static guint16 server_port;
+
+/* responses being sent right now and the most of them at once */
+static gint transfers = 0;
+static gint max_transfers = 0;
+
+static void
+transfer_started (void)
+{
+  gint n = g_atomic_int_add (&transfers, 1) + 1;
+  gint max;
+
+  while ((max = g_atomic_int_get (&max_transfers)) < n
+      && !g_atomic_int_compare_and_exchange (&max_transfers, max, n));
+}
+
+static gboolean
+read_request (gint fd, gchar * request, gsize size)
+{
+  gsize len = 0;
+
+  while (len < size - 1) {
+    gssize n = recv (fd, request + len, size - 1 - len, 0);
+
+    if (n <= 0)
+      return FALSE;
+    len += n;
+    request[len] = '\0';
+
+    if (strstr (request, "\r\n\r\n"))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* serves GET with or without a Range header from a generated resource, a
+ * connection is kept alive until the client closes it */
+static gpointer
+connection_func (gpointer data)
+{
+  gint fd = GPOINTER_TO_INT (data);
+  gchar request[4096];
+
+  while (read_request (fd, request, sizeof (request))) {
+    guint64 start = 0, end = RESOURCE_SIZE - 1, offset;
+    const gchar *range;
+    gchar *header;
+    gboolean ok = TRUE;
+
+    range = g_strstr_len (request, -1, "Range: bytes=");
+    if (!range)
+      range = g_strstr_len (request, -1, "range: bytes=");
+
+    if (range) {
+      gchar *end_ptr;
+
+      start = g_ascii_strtoull (range + 13, &end_ptr, 10);
+      if (*end_ptr == '-' && g_ascii_isdigit (end_ptr[1]))
+        end = MIN (g_ascii_strtoull (end_ptr + 1, NULL, 10), end);
+
+      header = g_strdup_printf ("HTTP/1.1 206 Partial Content\r\n"
+          "Content-Type: application/octet-stream\r\n"
+          "Accept-Ranges: bytes\r\n"
+          "Content-Range: bytes %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT
+          "/%d\r\n" "Content-Length: %" G_GUINT64_FORMAT "\r\n\r\n", start,
+          end, RESOURCE_SIZE, end - start + 1);
+    } else {
+      header = g_strdup_printf ("HTTP/1.1 200 OK\r\n"
+          "Content-Type: application/octet-stream\r\n"
+          "Accept-Ranges: bytes\r\n"
+          "Content-Length: %d\r\n\r\n", RESOURCE_SIZE);
+    }
+
+    if (send (fd, header, strlen (header), MSG_NOSIGNAL) < 0)
+      ok = FALSE;
+    g_free (header);
+
+    transfer_started ();
+    for (offset = start; ok && offset <= end;) {
+      guint8 block[SEND_BLOCK];
+      guint i, len = MIN (SEND_BLOCK, end + 1 - offset);
+
+      for (i = 0; i < len; i++)
+        block[i] = RESOURCE_BYTE (offset + i);
+
+      /* the client drops the response when it jumps to another range */
+      if (send (fd, block, len, MSG_NOSIGNAL) < 0)
+        ok = FALSE;
+      offset += len;
+      g_usleep (SEND_DELAY);
+    }
+    g_atomic_int_add (&transfers, -1);
+
+    if (!ok)
+      break;
+  }
+
+  close (fd);
+  return NULL;
+}
+
+static gpointer
+server_func (gpointer data)
+{
+  gint fd;
+
+  while ((fd = accept (server_fd, NULL, NULL)) >= 0)
+    g_thread_unref (g_thread_new ("connection", connection_func,
+            GINT_TO_POINTER (fd)));
+
+  return NULL;
+}
+
+static void
+start_server (void)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof (addr);
+
+  server_fd = socket (AF_INET, SOCK_STREAM, 0);
+  fail_unless (server_fd >= 0);
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  addr.sin_port = 0;
+
+  fail_unless (bind (server_fd, (struct sockaddr *) &addr, sizeof (addr)) == 0);
+  fail_unless (listen (server_fd, 16) == 0);
+  fail_unless (getsockname (server_fd, (struct sockaddr *) &addr, &len) == 0);
+  server_port = ntohs (addr.sin_port);
+
+  g_thread_unref (g_thread_new ("server", server_func, NULL));
+}
+
+static void
+stop_server (void)
+{
+  shutdown (server_fd, SHUT_RDWR);
+  close (server_fd);
+  server_fd = -1;
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    guint64 * received)
+{
+  GstMapInfo map;
+  gsize i;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  for (i = 0; i < map.size; i++) {
+    if (map.data[i] != RESOURCE_BYTE (*received + i))
+      fail ("unexpected data at offset %" G_GUINT64_FORMAT,
+          *received + (guint64) i);
+  }
+  *received += map.size;
+  gst_buffer_unmap (buffer, &map);
+}
+
+/* returns the most of range requests the server sent at once */
+static gint
+download (guint connections, guint64 * throughput)
+{
+  GstElement *pipeline, *src, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  gchar *location;
+  guint64 received = 0;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("httpsegmentsrc", NULL);
+  fail_unless (src != NULL, "Could not create httpsegmentsrc element");
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (sink != NULL);
+
+  location = g_strdup_printf ("http://127.0.0.1:%u/resource", server_port);
+  g_object_set (src, "location", location, "connections", connections,
+      "chunk-size", 128 * 1024, NULL);
+  g_free (location);
+  g_object_set (sink, "signal-handoffs", TRUE, "sync", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), &received);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  g_atomic_int_set (&max_transfers, 0);
+  fail_if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 30 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL, "download timed out");
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  fail_unless_equals_uint64 (received, RESOURCE_SIZE);
+  g_object_get (src, "throughput", throughput, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return g_atomic_int_get (&max_transfers);
+}
+
+GST_START_TEST (test_ordering)
+{
+  guint64 throughput = 0;
+
+  start_server ();
+  download (4, &throughput);
+  fail_unless (throughput > 0);
+  stop_server ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_connections)
+{
+  guint64 throughput = 0;
+
+  /* every connection is throttled, so the chunks of all of them are in
+   * flight at once, and the data still arrives in order */
+  start_server ();
+  fail_unless_equals_int (download (1, &throughput), 1);
+  fail_unless_equals_int (download (4, &throughput), 4);
+  stop_server ();
+}
+
+GST_END_TEST;
+
+static void
+check_range (GstPad * pad, guint64 offset, guint length)
+{
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+  gsize i;
+
+  fail_unless_equals_int (gst_pad_get_range (pad, offset, length, &buf),
+      GST_FLOW_OK);
+  fail_unless (buf != NULL);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), offset);
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, length);
+  for (i = 0; i < map.size; i++) {
+    if (map.data[i] != RESOURCE_BYTE (offset + i))
+      fail ("unexpected data at offset %" G_GUINT64_FORMAT,
+          offset + (guint64) i);
+  }
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+}
+
+GST_START_TEST (test_pull_range)
+{
+  GstElement *src;
+  GstPad *pad;
+  gchar *location;
+
+  start_server ();
+
+  src = gst_element_factory_make ("httpsegmentsrc", NULL);
+  fail_unless (src != NULL, "Could not create httpsegmentsrc element");
+
+  location = g_strdup_printf ("http://127.0.0.1:%u/resource", server_port);
+  g_object_set (src, "location", location, "connections", 2,
+      "chunk-size", 64 * 1024, NULL);
+  g_free (location);
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+
+  /* forward, inside of a chunk, the rest of it, and backward */
+  check_range (pad, 1000 * 1000, 4096);
+  check_range (pad, 1000 * 1000 + 4096, 100);
+  check_range (pad, 300 * 1000, 1000);
+  check_range (pad, 300 * 1000 + 1000, 64 * 1024);
+  check_range (pad, 0, 16);
+
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, FALSE));
+  gst_object_unref (pad);
+  gst_object_unref (src);
+
+  stop_server ();
+}
+
+GST_END_TEST;
+
+static Suite *
+httpsegmentsrc_suite (void)
+{
+  Suite *s = suite_create ("httpsegmentsrc");
+  TCase *tc_chain;
+  GstElementFactory *soup;
+
+  tc_chain = tcase_create ("general");
+
+  /* the connections are souphttpsrc elements from gst-plugins-good */
+  if ((soup = gst_element_factory_find ("souphttpsrc"))) {
+    tcase_add_test (tc_chain, test_ordering);
+    tcase_add_test (tc_chain, test_connections);
+    tcase_add_test (tc_chain, test_pull_range);
+    gst_object_unref (soup);
+  }
+
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (httpsegmentsrc);
@@ -26,6 +26,8 @@
 
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
+#include <gst/cool/gstcool.h>
 #include <stdlib.h>
 
 #define NUM_SUBSTREAMS 10
@@ -40,6 +42,7 @@ struct TestData
   GstPad *demuxsink, *demuxsrc[NUM_SUBSTREAMS];
   gint srcpad_cnt;
   GstCaps *mycaps;
+  volatile gint done;
 };
 
 static void
@@ -237,6 +240,676 @@ GST_START_TEST (test_streamiddemux_num_buffers)
 
 GST_END_TEST;
 
+static gint num_lists;
+
+static GstFlowReturn
+chain_list_ok (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstPad *peer_pad = NULL;
+
+  peer_pad = gst_pad_get_peer (active_srcpad);
+  fail_unless (pad == peer_pad);
+  fail_unless_equals_int (gst_buffer_list_length (list), 4);
+  gst_object_unref (peer_pad);
+  gst_buffer_list_unref (list);
+
+  num_lists++;
+
+  return GST_FLOW_OK;
+}
+
+static GstBufferList *
+create_buffer_list (void)
+{
+  GstBufferList *list;
+  gint i;
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 4; i++)
+    gst_buffer_list_add (list, gst_buffer_new ());
+
+  return list;
+}
+
+GST_START_TEST (test_streamiddemux_buffer_list)
+{
+  struct TestData td;
+  gint stream_cnt = 0;
+
+  setup_test_objects (&td);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_ok);
+    gst_pad_set_chain_list_function (td.mysink[stream_cnt], chain_list_ok);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  /* every list reaches the active pad in one piece */
+  num_lists = 0;
+  for (stream_cnt = 0; stream_cnt < 4; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("test%d", stream_cnt % 2);
+    gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+        GST_FORMAT_BYTES, name);
+    g_free (name);
+
+    set_active_srcpad (&td);
+
+    fail_unless (gst_pad_push_list (td.mysrc,
+            create_buffer_list ()) == GST_FLOW_OK);
+  }
+  fail_unless_equals_int (num_lists, 4);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static gpointer
+read_active_pad_func (struct TestData *td)
+{
+  while (!g_atomic_int_get (&td->done)) {
+    GstPad *pad = NULL;
+
+    g_object_get (td->demux, "active-pad", &pad, NULL);
+    if (pad)
+      gst_object_unref (pad);
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_streamiddemux_concurrent_active_pad)
+{
+  struct TestData td;
+  GThread *reader;
+  gint buffer_cnt = 0;
+  gint stream_cnt = 0;
+
+  setup_test_objects (&td);
+
+  for (stream_cnt = 0; stream_cnt < NUM_SUBSTREAMS; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_ok);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  /* the active pad is read while the streaming thread switches it */
+  td.done = 0;
+  reader = g_thread_new ("reader", (GThreadFunc) read_active_pad_func, &td);
+
+  for (buffer_cnt = 0; buffer_cnt < NUM_BUFFER * 10; ++buffer_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("test%d", buffer_cnt % NUM_SUBSTREAMS);
+    gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+        GST_FORMAT_BYTES, name);
+    g_free (name);
+
+    set_active_srcpad (&td);
+
+    fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+  }
+
+  g_atomic_int_set (&td.done, 1);
+  g_thread_join (reader);
+
+  for (stream_cnt = 0; stream_cnt < NUM_SUBSTREAMS; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+
+  for (stream_cnt = 0; stream_cnt < NUM_SUBSTREAMS; ++stream_cnt) {
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static gint num_interleaved;
+
+/* every buffer must reach the pad of the stream it is tagged with */
+static GstFlowReturn
+chain_interleaved (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstCoolStreamMeta *meta;
+  gchar *pad_stream_id;
+
+  meta = gst_buffer_get_cool_stream_meta (buffer);
+  fail_unless (meta != NULL);
+
+  pad_stream_id = gst_pad_get_stream_id (pad);
+  fail_unless_equals_string (pad_stream_id,
+      g_quark_to_string (meta->stream_id));
+  g_free (pad_stream_id);
+  gst_buffer_unref (buffer);
+
+  num_interleaved++;
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+chain_list_interleaved (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  guint i;
+
+  for (i = 0; i < gst_buffer_list_length (list); i++)
+    chain_interleaved (pad, parent,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+static GstBuffer *
+create_tagged_buffer (const gchar * stream_id)
+{
+  GstBuffer *buffer = gst_buffer_new ();
+
+  gst_buffer_add_cool_stream_meta (buffer, stream_id);
+
+  return buffer;
+}
+
+GST_START_TEST (test_streamiddemux_interleaved)
+{
+  struct TestData td;
+  GstBufferList *list;
+  gint stream_cnt = 0;
+  gint buffer_cnt = 0;
+
+  setup_test_objects (&td);
+  g_object_set (td.demux, "interleaved", TRUE, NULL);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_interleaved);
+    gst_pad_set_chain_list_function (td.mysink[stream_cnt],
+        chain_list_interleaved);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  /* one stream-start per stream creates the pads */
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test0");
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test1");
+  set_active_srcpad (&td);
+
+  /* then the streams alternate without any event */
+  num_interleaved = 0;
+  for (buffer_cnt = 0; buffer_cnt < NUM_BUFFER; ++buffer_cnt) {
+    fail_unless (gst_pad_push (td.mysrc,
+            create_tagged_buffer (buffer_cnt % 2 ? "test1" : "test0")) ==
+        GST_FLOW_OK);
+  }
+  fail_unless_equals_int (num_interleaved, NUM_BUFFER);
+
+  /* a list is split at the stream boundaries */
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, create_tagged_buffer ("test0"));
+  gst_buffer_list_add (list, create_tagged_buffer ("test0"));
+  gst_buffer_list_add (list, create_tagged_buffer ("test1"));
+  gst_buffer_list_add (list, create_tagged_buffer ("test0"));
+  fail_unless (gst_pad_push_list (td.mysrc, list) == GST_FLOW_OK);
+  fail_unless_equals_int (num_interleaved, NUM_BUFFER + 4);
+
+  /* a stream without a pad doesn't leak into the active one */
+  fail_unless (gst_pad_push (td.mysrc,
+          create_tagged_buffer ("test9")) == GST_FLOW_OK);
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, create_tagged_buffer ("test0"));
+  gst_buffer_list_add (list, create_tagged_buffer ("test9"));
+  fail_unless (gst_pad_push_list (td.mysrc, list) == GST_FLOW_OK);
+  fail_unless_equals_int (num_interleaved, NUM_BUFFER + 5);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+/* buffers pushed through a tagged pad carry the stream-id of the last
+ * stream-start on it, so they reach the matching pad in interleaved mode */
+GST_START_TEST (test_streamiddemux_tag_pad)
+{
+  struct TestData td;
+  GstBufferList *list;
+  gulong probe;
+  gint stream_cnt = 0;
+  gint buffer_cnt = 0;
+
+  setup_test_objects (&td);
+  g_object_set (td.demux, "interleaved", TRUE, NULL);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_interleaved);
+    gst_pad_set_chain_list_function (td.mysink[stream_cnt],
+        chain_list_interleaved);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  probe = gst_cool_stream_meta_tag_pad (td.mysrc);
+  fail_unless (probe != 0);
+
+  num_interleaved = 0;
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *stream_id = g_strdup_printf ("test%d", stream_cnt);
+
+    gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+        GST_FORMAT_BYTES, stream_id);
+    g_free (stream_id);
+
+    for (buffer_cnt = 0; buffer_cnt < NUM_BUFFER; ++buffer_cnt)
+      fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+
+    list = gst_buffer_list_new ();
+    gst_buffer_list_add (list, gst_buffer_new ());
+    gst_buffer_list_add (list, gst_buffer_new ());
+    fail_unless (gst_pad_push_list (td.mysrc, list) == GST_FLOW_OK);
+  }
+  fail_unless_equals_int (num_interleaved, 2 * (NUM_BUFFER + 2));
+  set_active_srcpad (&td);
+
+  gst_pad_remove_probe (td.mysrc, probe);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static gint num_caps[NUM_SUBSTREAMS];
+
+static gboolean
+event_count_caps (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS)
+    num_caps[GPOINTER_TO_INT (g_object_get_data (G_OBJECT (pad), "index"))]++;
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+GST_START_TEST (test_streamiddemux_sticky_cache)
+{
+  struct TestData td;
+  GstCaps *caps;
+  gint stream_cnt = 0;
+
+  setup_test_objects (&td);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    g_object_set_data (G_OBJECT (td.mysink[stream_cnt]), "index",
+        GINT_TO_POINTER (stream_cnt));
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_ok);
+    gst_pad_set_event_function (td.mysink[stream_cnt], event_count_caps);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+    num_caps[stream_cnt] = 0;
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  /* switching back and forth resends the same caps every time */
+  for (stream_cnt = 0; stream_cnt < 6; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("test%d", stream_cnt % 2);
+    gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+        GST_FORMAT_BYTES, name);
+    g_free (name);
+
+    set_active_srcpad (&td);
+
+    fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+  }
+  fail_unless_equals_int (num_caps[0], 1);
+  fail_unless_equals_int (num_caps[1], 1);
+
+  /* changed caps still go through */
+  caps = gst_caps_new_empty_simple ("test/other");
+  fail_unless (gst_pad_push_event (td.mysrc, gst_event_new_caps (caps)));
+  gst_caps_unref (caps);
+  fail_unless_equals_int (num_caps[1], 2);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static GstBuffer *
+create_timed_buffer (gsize size, GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, size, NULL);
+
+  GST_BUFFER_PTS (buf) = pts;
+
+  return buf;
+}
+
+static void
+check_stream_stats (const GstStructure * stats, const gchar * stream_id,
+    guint64 buffers, guint64 bytes, guint64 events, GstClockTime timestamp)
+{
+  const GstStructure *record = NULL;
+  const GValue *streams;
+  guint64 value = 0;
+  guint i;
+
+  fail_unless (gst_structure_has_field_typed (stats, "streams",
+          GST_TYPE_ARRAY));
+  streams = gst_structure_get_value (stats, "streams");
+  for (i = 0; i < gst_value_array_get_size (streams); i++) {
+    const GstStructure *s =
+        gst_value_get_structure (gst_value_array_get_value (streams, i));
+
+    if (!g_strcmp0 (gst_structure_get_string (s, "stream-id"), stream_id))
+      record = s;
+  }
+  fail_unless (record != NULL);
+
+  fail_unless (gst_structure_get_uint64 (record, "buffers", &value));
+  fail_unless_equals_uint64 (value, buffers);
+  fail_unless (gst_structure_get_uint64 (record, "bytes", &value));
+  fail_unless_equals_uint64 (value, bytes);
+  fail_unless (gst_structure_get_uint64 (record, "events", &value));
+  fail_unless_equals_uint64 (value, events);
+  fail_unless (gst_structure_get_uint64 (record, "last-timestamp", &value));
+  fail_unless_equals_uint64 (value, timestamp);
+}
+
+GST_START_TEST (test_streamiddemux_stats)
+{
+  struct TestData td;
+  GstStructure *stats = NULL;
+  GstBufferList *list;
+  guint switches = 0;
+  gint stream_cnt = 0;
+
+  setup_test_objects (&td);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_ok);
+    gst_pad_set_chain_list_function (td.mysink[stream_cnt], chain_list_ok);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  /* stream-start, caps and segment for each stream */
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test0");
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push (td.mysrc,
+          create_timed_buffer (10, 0)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (td.mysrc,
+          create_timed_buffer (10, GST_SECOND)) == GST_FLOW_OK);
+
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test1");
+  set_active_srcpad (&td);
+  list = create_buffer_list ();
+  fail_unless (gst_pad_push_list (td.mysrc, list) == GST_FLOW_OK);
+
+  fail_unless (gst_pad_push_event (td.mysrc,
+          gst_event_new_stream_start ("test0")));
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push (td.mysrc,
+          create_timed_buffer (5, 2 * GST_SECOND)) == GST_FLOW_OK);
+
+  g_object_get (td.demux, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint (stats, "switches", &switches));
+  fail_unless_equals_int (switches, 3);
+  check_stream_stats (stats, "test0", 3, 25, 4, 2 * GST_SECOND);
+  check_stream_stats (stats, "test1", 4, 0, 3, GST_CLOCK_TIME_NONE);
+  gst_structure_free (stats);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+/* switches through 4 streams with a pause before the last two, returns
+ * the number of srcpads added */
+static gint
+switch_idle_streams (gboolean recycle)
+{
+  struct TestData td;
+  GstClock *clock;
+  gint stream_cnt = 0, srcpad_cnt;
+
+  setup_test_objects (&td);
+  g_object_set (td.demux, "idle-timeout", 20 * GST_MSECOND, "recycle-pads",
+      recycle, NULL);
+
+  /* idle time follows the clock of the element */
+  clock = gst_test_clock_new ();
+  gst_element_set_clock (td.demux, clock);
+
+  for (stream_cnt = 0; stream_cnt < 4; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_ok);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  for (stream_cnt = 0; stream_cnt < 4; ++stream_cnt) {
+    gchar *name;
+
+    /* test0, then test1, went idle in the meantime */
+    if (stream_cnt >= 2)
+      gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 50 * GST_MSECOND);
+
+    name = g_strdup_printf ("test%d", stream_cnt);
+    gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+        GST_FORMAT_BYTES, name);
+    g_free (name);
+
+    set_active_srcpad (&td);
+
+    fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+
+    /* the previous stream is never pruned */
+    fail_unless (GST_ELEMENT (td.demux)->numsrcpads <= 2);
+  }
+  srcpad_cnt = td.srcpad_cnt;
+
+  for (stream_cnt = 0; stream_cnt < 4; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+  gst_object_unref (clock);
+
+  return srcpad_cnt;
+}
+
+GST_START_TEST (test_streamiddemux_idle_prune)
+{
+  fail_unless_equals_int (switch_idle_streams (FALSE), 4);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_streamiddemux_recycle_pads)
+{
+  fail_unless_equals_int (switch_idle_streams (TRUE), 2);
+}
+
+GST_END_TEST;
+
+static void
+src_pad_removed_cb (GstElement * demux, GstPad * pad, gint * removed)
+{
+  (*removed)++;
+}
+
+/* more buffers than streamiddemux lets through between two idle checks */
+static void
+push_past_idle_check (GstPad * srcpad)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  guint i;
+
+  for (i = 0; i < 64; i++)
+    gst_buffer_list_add (list, gst_buffer_new ());
+  fail_unless (gst_pad_push_list (srcpad, list) == GST_FLOW_OK);
+}
+
+GST_START_TEST (test_streamiddemux_idle_without_switch)
+{
+  struct TestData td;
+  GstClock *clock;
+  gint stream_cnt, removed = 0;
+
+  setup_test_objects (&td);
+  g_object_set (td.demux, "idle-timeout", 20 * GST_MSECOND, NULL);
+  g_signal_connect (td.demux, "pad-removed", G_CALLBACK (src_pad_removed_cb),
+      &removed);
+
+  clock = gst_test_clock_new ();
+  gst_element_set_clock (td.demux, clock);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *name;
+    name = g_strdup_printf ("mysink%d", stream_cnt);
+    td.mysink[stream_cnt] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (td.mysink[stream_cnt], chain_ok);
+    gst_pad_set_active (td.mysink[stream_cnt], TRUE);
+  }
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gchar *name;
+
+    name = g_strdup_printf ("test%d", stream_cnt);
+    gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+        GST_FORMAT_BYTES, name);
+    g_free (name);
+
+    set_active_srcpad (&td);
+    fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+  }
+  fail_unless_equals_int (GST_ELEMENT (td.demux)->numsrcpads, 2);
+
+  /* test0 isn't due yet */
+  gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 10 * GST_MSECOND);
+  push_past_idle_check (td.mysrc);
+  fail_unless_equals_int (removed, 0);
+
+  /* test0 timed out while test1 stays active, no stream-start needed */
+  gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 10 * GST_MSECOND);
+  push_past_idle_check (td.mysrc);
+  fail_unless_equals_int (removed, 1);
+  fail_unless_equals_int (GST_ELEMENT (td.demux)->numsrcpads, 1);
+
+  gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 50 * GST_MSECOND);
+  push_past_idle_check (td.mysrc);
+  fail_unless_equals_int (removed, 1);
+
+  for (stream_cnt = 0; stream_cnt < 2; ++stream_cnt) {
+    gst_pad_set_active (td.mysink[stream_cnt], FALSE);
+    gst_object_unref (td.mysink[stream_cnt]);
+  }
+  gst_pad_set_active (td.mysrc, FALSE);
+  gst_object_unref (td.mysrc);
+
+  release_test_objects (&td);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 static Suite *
 streamiddemux_suite (void)
 {
@@ -246,6 +919,15 @@ streamiddemux_suite (void)
   tc_chain = tcase_create ("streamiddemux simple");
   tcase_add_test (tc_chain, test_streamiddemux_simple);
   tcase_add_test (tc_chain, test_streamiddemux_num_buffers);
+  tcase_add_test (tc_chain, test_streamiddemux_concurrent_active_pad);
+  tcase_add_test (tc_chain, test_streamiddemux_buffer_list);
+  tcase_add_test (tc_chain, test_streamiddemux_interleaved);
+  tcase_add_test (tc_chain, test_streamiddemux_tag_pad);
+  tcase_add_test (tc_chain, test_streamiddemux_sticky_cache);
+  tcase_add_test (tc_chain, test_streamiddemux_idle_prune);
+  tcase_add_test (tc_chain, test_streamiddemux_recycle_pads);
+  tcase_add_test (tc_chain, test_streamiddemux_idle_without_switch);
+  tcase_add_test (tc_chain, test_streamiddemux_stats);
   suite_add_tcase (s, tc_chain);
 
   return s;
@@ -0,0 +1,224 @@
+/* GStreamer unit tests for the textbin
+ *
+ * Copyright 2014 LGE Corporation.
+ *  @author: Hoonhee Lee <hoonhee.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
+
+#define NUM_BUFFER 64
+#define BUFFER_SIZE 1024
+
+struct TestData
+{
+  GstElement *pipeline;
+  GstElement *textbin;
+  GstPad *mysrc;
+};
+
+static void
+setup_test_objects (struct TestData *td, GstState state)
+{
+  GstPad *sinkpad;
+
+  td->pipeline = gst_pipeline_new (NULL);
+  td->textbin = gst_element_factory_make ("textbin", NULL);
+  fail_unless (td->textbin != NULL);
+  gst_bin_add (GST_BIN (td->pipeline), td->textbin);
+
+  td->mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (td->textbin, "sink");
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td->mysrc, sinkpad)));
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (td->mysrc, TRUE);
+
+  fail_if (gst_element_set_state (td->pipeline,
+          state) == GST_STATE_CHANGE_FAILURE);
+}
+
+static void
+release_test_objects (struct TestData *td)
+{
+  fail_unless (gst_element_set_state (td->pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  gst_pad_set_active (td->mysrc, FALSE);
+  gst_object_unref (td->mysrc);
+  gst_object_unref (td->pipeline);
+}
+
+static void
+push_stream (struct TestData *td, const gchar * stream_id, const gchar * mime,
+    guint num_buffers)
+{
+  GstCaps *caps;
+  guint i;
+
+  caps = gst_caps_new_empty_simple (mime);
+  gst_check_setup_events_with_stream_id (td->mysrc, td->textbin, caps,
+      GST_FORMAT_TIME, stream_id);
+  gst_caps_unref (caps);
+
+  for (i = 0; i < num_buffers; i++) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+
+    GST_BUFFER_PTS (buf) = i * GST_SECOND;
+    fail_unless (gst_pad_push (td->mysrc, buf) == GST_FLOW_OK);
+  }
+}
+
+GST_START_TEST (test_textbin_drop_oldest)
+{
+  struct TestData td;
+  GstStructure *stats = NULL;
+  const GstStructure *record = NULL;
+  const GValue *streams;
+  guint overruns = 0, level_bytes = 0;
+  guint i;
+
+  /* teletext is held in PAUSED, so the queue of the stream fills up */
+  setup_test_objects (&td, GST_STATE_PAUSED);
+  g_object_set (td.textbin, "max-size-bytes", 8 * BUFFER_SIZE, NULL);
+
+  /* pushing doesn't block, the oldest data is dropped */
+  push_stream (&td, "text0", "application/x-teletext", NUM_BUFFER);
+
+  g_object_get (td.textbin, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint (stats, "overruns", &overruns));
+  fail_unless (overruns > 0);
+
+  streams = gst_structure_get_value (stats, "streams");
+  fail_unless (streams != NULL);
+  for (i = 0; i < gst_value_array_get_size (streams); i++) {
+    const GstStructure *s =
+        gst_value_get_structure (gst_value_array_get_value (streams, i));
+
+    if (!g_strcmp0 (gst_structure_get_string (s, "stream-id"), "text0"))
+      record = s;
+  }
+  fail_unless (record != NULL);
+  fail_unless (gst_structure_get_uint (record, "level-bytes", &level_bytes));
+  fail_unless (level_bytes <= 8 * BUFFER_SIZE);
+  gst_structure_free (stats);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static guint
+count_streams (struct TestData *td)
+{
+  GstStructure *stats = NULL;
+  guint n;
+
+  g_object_get (td->textbin, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+
+  fail_unless (gst_structure_has_field_typed (stats, "streams",
+          GST_TYPE_ARRAY));
+  n = gst_value_array_get_size (gst_structure_get_value (stats, "streams"));
+  gst_structure_free (stats);
+
+  return n;
+}
+
+GST_START_TEST (test_textbin_selected_streams)
+{
+  struct TestData td;
+  const gchar *selected[] = { "text1", NULL };
+  const gchar *all[] = { "text0", "text1", NULL };
+
+  setup_test_objects (&td, GST_STATE_PAUSED);
+  g_object_set (td.textbin, "selected-streams", selected, NULL);
+
+  /* no branch for a track which isn't selected */
+  push_stream (&td, "text0", "application/x-teletext", 4);
+  fail_unless_equals_int (count_streams (&td), 0);
+
+  push_stream (&td, "text1", "application/x-teletext", 4);
+  fail_unless_equals_int (count_streams (&td), 1);
+
+  /* the branch is built once the track is selected */
+  g_object_set (td.textbin, "selected-streams", all, NULL);
+  push_stream (&td, "text0", "application/x-teletext", 4);
+  fail_unless_equals_int (count_streams (&td), 2);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_textbin_idle_release)
+{
+  struct TestData td;
+  GstBufferList *list;
+  GstClock *clock;
+  guint i;
+
+  setup_test_objects (&td, GST_STATE_PAUSED);
+  g_object_set (td.textbin, "idle-timeout", 20 * GST_MSECOND, NULL);
+
+  /* the bin hands it to streamiddemux, which measures idle time on it */
+  clock = gst_test_clock_new ();
+  gst_element_set_clock (td.textbin, clock);
+
+  push_stream (&td, "text0", "application/x-teletext", 4);
+  push_stream (&td, "text1", "application/x-teletext", 4);
+  fail_unless_equals_int (count_streams (&td), 2);
+
+  /* text0 is held by textsink in PAUSED, its branch goes anyway once it
+   * timed out, without switching tracks again. streamiddemux only reads
+   * the clock every few buffers. */
+  gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 50 * GST_MSECOND);
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 64; i++)
+    gst_buffer_list_add (list, gst_buffer_new_allocate (NULL, BUFFER_SIZE,
+            NULL));
+  fail_unless (gst_pad_push_list (td.mysrc, list) == GST_FLOW_OK);
+  fail_unless_equals_int (count_streams (&td), 1);
+
+  release_test_objects (&td);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
+static Suite *
+textbin_suite (void)
+{
+  Suite *s = suite_create ("textbin");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("general");
+  tcase_add_test (tc_chain, test_textbin_drop_oldest);
+  tcase_add_test (tc_chain, test_textbin_selected_streams);
+  tcase_add_test (tc_chain, test_textbin_idle_release);
+
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (textbin);
@@ -0,0 +1,342 @@
+/* GStreamer unit tests for the tsinkbin
+ *
+ * Copyright 2014 LGE Corporation.
+ *  @author: Wonchul Lee <wonchul86.lee@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <gst/cool/gstcool.h>
+#include <stdio.h>
+
+#define NUM_STREAMS 2
+
+struct TestData
+{
+  GstElement *pipeline;
+  GstElement *tsinkbin;
+  GstPad *mysrc[NUM_STREAMS];
+  GstPad *sinkpad[NUM_STREAMS];
+};
+
+static volatile gint num_samples[NUM_STREAMS];
+
+static void
+subtitle_cb (GstElement * sink, GstPad * pad, GstSample * sample,
+    gpointer user_data)
+{
+  GstCaps *caps = gst_sample_get_caps (sample);
+  guint index;
+
+  fail_unless (GST_IS_PAD (pad));
+  fail_unless (gst_sample_get_buffer (sample) != NULL);
+  fail_unless (caps != NULL);
+  fail_unless (user_data == GINT_TO_POINTER (0xc001));
+
+  /* textsink names its pads sink_0, sink_1, ... */
+  fail_unless (sscanf (GST_PAD_NAME (pad), "sink_%u", &index) == 1);
+  fail_unless (index < NUM_STREAMS);
+  g_atomic_int_inc (&num_samples[index]);
+}
+
+static GMutex batch_lock;
+static GCond batch_cond;
+static GArray *batch_sizes;
+
+static void
+subtitle_batch_cb (GstElement * sink, GstPad * pad, GstSample ** samples,
+    guint n_samples, gpointer user_data)
+{
+  guint i;
+
+  for (i = 0; i < n_samples; i++)
+    fail_unless (gst_sample_get_buffer (samples[i]) != NULL);
+
+  g_mutex_lock (&batch_lock);
+  g_array_append_val (batch_sizes, n_samples);
+  g_cond_broadcast (&batch_cond);
+  g_mutex_unlock (&batch_lock);
+}
+
+static void
+setup_test_objects (struct TestData *td, const gchar * mime,
+    gboolean with_func, GstClockTime batch_window, GstState state)
+{
+  GstCaps *caps;
+  gint i;
+
+  td->pipeline = gst_pipeline_new (NULL);
+  td->tsinkbin = gst_element_factory_make ("tsinkbin", NULL);
+  fail_unless (td->tsinkbin != NULL);
+  gst_bin_add (GST_BIN (td->pipeline), td->tsinkbin);
+
+  if (with_func)
+    gst_cool_subtitle_set_func (td->pipeline, subtitle_cb,
+        GINT_TO_POINTER (0xc001), NULL);
+
+  if (batch_window > 0) {
+    batch_sizes = g_array_new (FALSE, FALSE, sizeof (guint));
+    gst_cool_subtitle_set_batch_func (td->pipeline, subtitle_batch_cb, NULL,
+        NULL);
+    g_object_set (td->tsinkbin, "batch-window", batch_window, NULL);
+  }
+
+  fail_if (gst_element_set_state (td->pipeline,
+          state) == GST_STATE_CHANGE_FAILURE);
+
+  caps = gst_caps_new_empty_simple (mime);
+  for (i = 0; i < NUM_STREAMS; i++) {
+    gchar *name;
+
+    num_samples[i] = 0;
+
+    td->sinkpad[i] = gst_element_get_request_pad (td->tsinkbin,
+        "text_sink%d");
+    fail_unless (td->sinkpad[i] != NULL);
+
+    name = g_strdup_printf ("mysrc%d", i);
+    td->mysrc[i] = gst_pad_new (name, GST_PAD_SRC);
+    g_free (name);
+    fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td->mysrc[i],
+                td->sinkpad[i])));
+    gst_pad_set_active (td->mysrc[i], TRUE);
+
+    name = g_strdup_printf ("text%d", i);
+    gst_check_setup_events_with_stream_id (td->mysrc[i], td->tsinkbin, caps,
+        GST_FORMAT_TIME, name);
+    g_free (name);
+  }
+  gst_caps_unref (caps);
+}
+
+static void
+release_test_objects (struct TestData *td)
+{
+  gint i;
+
+  fail_unless (gst_element_set_state (td->pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  for (i = 0; i < NUM_STREAMS; i++) {
+    gst_pad_set_active (td->mysrc[i], FALSE);
+    gst_pad_unlink (td->mysrc[i], td->sinkpad[i]);
+    gst_element_release_request_pad (td->tsinkbin, td->sinkpad[i]);
+    gst_object_unref (td->sinkpad[i]);
+    gst_object_unref (td->mysrc[i]);
+  }
+
+  gst_object_unref (td->pipeline);
+}
+
+static GstBuffer *
+create_text_buffer (GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, 8, NULL);
+
+  GST_BUFFER_PTS (buf) = pts;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+
+  return buf;
+}
+
+GST_START_TEST (test_tsinkbin_func)
+{
+  struct TestData td;
+  gint i;
+
+  setup_test_objects (&td, "text/x-raw", TRUE, 0, GST_STATE_PLAYING);
+
+  /* every sample goes to the function from the pushing thread */
+  for (i = 0; i < 3; i++)
+    fail_unless (gst_pad_push (td.mysrc[0],
+            create_text_buffer (i * GST_SECOND)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (td.mysrc[1],
+          create_text_buffer (0)) == GST_FLOW_OK);
+
+  fail_unless_equals_int (num_samples[0], 3);
+  fail_unless_equals_int (num_samples[1], 1);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsinkbin_message)
+{
+  struct TestData td;
+  GstMessage *msg;
+  GstBus *bus;
+  GstSample *sample;
+
+  setup_test_objects (&td, "text/x-raw", FALSE, 0, GST_STATE_PLAYING);
+
+  fail_unless (gst_pad_push (td.mysrc[1],
+          create_text_buffer (0)) == GST_FLOW_OK);
+  fail_unless_equals_int (num_samples[1], 0);
+
+  /* without a function, the sample is posted as before */
+  bus = gst_element_get_bus (td.pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_SECOND, GST_MESSAGE_APPLICATION);
+  fail_unless (msg != NULL);
+  fail_unless (gst_message_has_name (msg, "subtitle_data"));
+
+  sample = gst_value_get_sample (gst_structure_get_value
+      (gst_message_get_structure (msg), "sample"));
+  fail_unless (sample != NULL);
+  fail_unless (gst_sample_get_buffer (sample) != NULL);
+  gst_sample_unref (sample);
+
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static gpointer
+push_func (GstPad * mysrc)
+{
+  fail_unless (gst_pad_push (mysrc, create_text_buffer (0)) == GST_FLOW_OK);
+
+  return NULL;
+}
+
+static void
+check_held_until_playing (const gchar * mime)
+{
+  struct TestData td;
+  GThread *thread;
+
+  setup_test_objects (&td, mime, TRUE, 0, GST_STATE_PAUSED);
+
+  thread = g_thread_new ("push", (GThreadFunc) push_func, td.mysrc[0]);
+  g_usleep (G_USEC_PER_SEC / 10);
+  fail_unless_equals_int (num_samples[0], 0);
+
+  fail_if (gst_element_set_state (td.pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  g_thread_join (thread);
+  fail_unless_equals_int (num_samples[0], 1);
+
+  release_test_objects (&td);
+}
+
+GST_START_TEST (test_tsinkbin_teletext_sync)
+{
+  check_held_until_playing ("application/x-teletext");
+}
+
+GST_END_TEST;
+
+/* the other formats aren't synchronized, but not delivered in PAUSED
+ * either, as with the appsink of each stream */
+GST_START_TEST (test_tsinkbin_text_held)
+{
+  check_held_until_playing ("text/x-raw");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsinkbin_batch)
+{
+  struct TestData td;
+  gint64 end_time;
+  gint i;
+
+  setup_test_objects (&td, "text/x-raw", FALSE, GST_SECOND,
+      GST_STATE_PLAYING);
+
+  /* three samples within the window, the fourth one starts a new batch */
+  for (i = 0; i < 3; i++)
+    fail_unless (gst_pad_push (td.mysrc[0],
+            create_text_buffer (i * 100 * GST_MSECOND)) == GST_FLOW_OK);
+
+  g_mutex_lock (&batch_lock);
+  fail_unless_equals_int (batch_sizes->len, 0);
+  g_mutex_unlock (&batch_lock);
+
+  fail_unless (gst_pad_push (td.mysrc[0],
+          create_text_buffer (2 * GST_SECOND)) == GST_FLOW_OK);
+
+  /* the last batch is delivered when the window ran out */
+  end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&batch_lock);
+  while (batch_sizes->len < 2)
+    fail_unless (g_cond_wait_until (&batch_cond, &batch_lock, end_time));
+  fail_unless_equals_int (g_array_index (batch_sizes, guint, 0), 3);
+  fail_unless_equals_int (g_array_index (batch_sizes, guint, 1), 1);
+  g_mutex_unlock (&batch_lock);
+
+  fail_unless_equals_int (num_samples[0], 0);
+
+  release_test_objects (&td);
+  g_array_free (batch_sizes, TRUE);
+}
+
+GST_END_TEST;
+
+/* teletext already waited for its running time, it isn't held back for the
+ * window */
+GST_START_TEST (test_tsinkbin_teletext_batch)
+{
+  struct TestData td;
+  gint i;
+
+  setup_test_objects (&td, "application/x-teletext", FALSE, GST_SECOND,
+      GST_STATE_PLAYING);
+
+  for (i = 0; i < 2; i++) {
+    fail_unless (gst_pad_push (td.mysrc[0],
+            create_text_buffer (i * 100 * GST_MSECOND)) == GST_FLOW_OK);
+
+    g_mutex_lock (&batch_lock);
+    fail_unless_equals_int (batch_sizes->len, i + 1);
+    fail_unless_equals_int (g_array_index (batch_sizes, guint, i), 1);
+    g_mutex_unlock (&batch_lock);
+  }
+
+  release_test_objects (&td);
+  g_array_free (batch_sizes, TRUE);
+}
+
+GST_END_TEST;
+
+static Suite *
+tsinkbin_suite (void)
+{
+  Suite *s = suite_create ("tsinkbin");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("general");
+  tcase_add_test (tc_chain, test_tsinkbin_func);
+  tcase_add_test (tc_chain, test_tsinkbin_message);
+  tcase_add_test (tc_chain, test_tsinkbin_teletext_sync);
+  tcase_add_test (tc_chain, test_tsinkbin_text_held);
+  tcase_add_test (tc_chain, test_tsinkbin_batch);
+  tcase_add_test (tc_chain, test_tsinkbin_teletext_batch);
+
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (tsinkbin);